@@ -0,0 +1,153 @@
+#include <cstdint>
+
+#include <bloom_filter.h>
+#include <blocked_bloom_filter.h>
+#include <runtime_bloom_filter.h>
+
+#include <vector>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* classic BloomFilter with 8 seeded murmur3 functors against BlockedBloomFilter with one
+ * 64 bit hash and K = 8 and RuntimeBloomFilter with packed bits and k = 7 double hashed
+ * indexes, all at BITS_PER_KEY bits per key. the fpr counter is measured on
+ * keys that were never added; tests are half hits, half misses */
+constexpr size_t BITS_PER_KEY = 10;
+constexpr size_t NBITS = 1 << 24; //2MB packed, 16MB as the classic filter's bool per bit
+constexpr size_t NKEYS = NBITS / BITS_PER_KEY;
+constexpr size_t NTEST = 1 << 16;
+
+template <uint32_t SEED>
+struct SeededMurmur {
+  size_t operator()(const uint64_t& v) const noexcept {
+    return murmur3((const uint8_t*)&v, sizeof(v), SEED);
+  }
+};
+
+using Classic = BloomFilter<uint64_t, NBITS, SeededMurmur<1>, SeededMurmur<2>, SeededMurmur<3>, SeededMurmur<4>,
+                           SeededMurmur<5>, SeededMurmur<6>, SeededMurmur<7>, SeededMurmur<8>>;
+using Blocked = BlockedBloomFilter<uint64_t>;
+using Runtime = RuntimeBloomFilter<uint64_t>;
+
+static uint64_t key(size_t i){
+  return i * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static s::unique_ptr<Classic> make_classic(){
+  s::unique_ptr<Classic> bf(new Classic(SeededMurmur<1>(), SeededMurmur<2>(), SeededMurmur<3>(), SeededMurmur<4>(),
+                                        SeededMurmur<5>(), SeededMurmur<6>(), SeededMurmur<7>(), SeededMurmur<8>()));
+  bf->clear();
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+static s::unique_ptr<Blocked> make_blocked(){
+  s::unique_ptr<Blocked> bf(new Blocked(NBITS));
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+static s::unique_ptr<Runtime> make_runtime(){
+  s::unique_ptr<Runtime> bf(new Runtime(NBITS, bloom_optimal_hashes(NBITS, NKEYS)));
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+template <typename F>
+static double false_positive_rate(const F& bf){
+  size_t fp = 0;
+  for (size_t i = 0; i < NKEYS; ++i) fp += bf.test(key(NKEYS + i));
+  return (double)fp / NKEYS;
+}
+
+static s::vector<uint64_t> test_keys(){
+  s::vector<uint64_t> keys(NTEST);
+  for (size_t i = 0; i < NTEST; ++i)
+    keys[i] = key((i & 1 ? NKEYS : 0) + i * 7 % NKEYS);
+  return keys;
+}
+
+static void bm_classic_add(b::State& st){
+  s::unique_ptr<Classic> bf = make_classic();
+  size_t i = 0;
+  for (auto _ : st) bf->add(key(i++));
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_blocked_add(b::State& st){
+  Blocked bf(NBITS);
+  size_t i = 0;
+  for (auto _ : st) bf.add(key(i++));
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_blocked_add_batch(b::State& st){
+  Blocked bf(NBITS);
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st) bf.add(keys.data(), keys.size());
+  st.SetItemsProcessed(st.iterations() * keys.size());
+}
+
+static void bm_classic_test(b::State& st){
+  s::unique_ptr<Classic> bf = make_classic();
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st){
+    size_t hit = 0;
+    for (uint64_t k : keys) hit += bf->test(k);
+    b::DoNotOptimize(hit);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["fpr"] = false_positive_rate(*bf);
+  st.counters["bytes"] = sizeof(Classic);
+}
+
+static void bm_blocked_test(b::State& st){
+  s::unique_ptr<Blocked> bf = make_blocked();
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st){
+    size_t hit = 0;
+    for (uint64_t k : keys) hit += bf->test(k);
+    b::DoNotOptimize(hit);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["fpr"] = false_positive_rate(*bf);
+  st.counters["fpr_model"] = bf->fpr();
+  st.counters["bytes"] = bf->bytes();
+}
+
+static void bm_runtime_test(b::State& st){
+  s::unique_ptr<Runtime> bf = make_runtime();
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st){
+    size_t hit = 0;
+    for (uint64_t k : keys) hit += bf->test(k);
+    b::DoNotOptimize(hit);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["fpr"] = false_positive_rate(*bf);
+  st.counters["fpr_model"] = bf->fpr();
+  st.counters["bytes"] = bf->bytes();
+}
+
+static void bm_blocked_test_batch(b::State& st){
+  s::unique_ptr<Blocked> bf = make_blocked();
+  s::vector<uint64_t> keys = test_keys();
+  s::unique_ptr<bool[]> out(new bool[keys.size()]);
+  for (auto _ : st){
+    bf->test(keys.data(), keys.size(), out.get());
+    b::DoNotOptimize(out.get());
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+}
+
+BENCHMARK(bm_classic_add);
+BENCHMARK(bm_blocked_add);
+BENCHMARK(bm_blocked_add_batch);
+BENCHMARK(bm_classic_test);
+BENCHMARK(bm_blocked_test);
+BENCHMARK(bm_runtime_test);
+BENCHMARK(bm_blocked_test_batch);
@@ -0,0 +1,72 @@
+#include <cstdint>
+
+#include <concurrent_bloom_filter.h>
+
+#include <mutex>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* 1 to 8 threads adding to and testing one shared filter of 2^24 bits and k = 7: the lock
+ * free ConcurrentBloomFilter against a RuntimeBloomFilter behind a mutex. every thread
+ * works on its own keys; items_per_second is the total over all threads */
+constexpr size_t NBITS = 1 << 24;
+constexpr size_t K = 7;
+
+static uint64_t key(size_t thread, size_t i){
+  return (i * 64 + thread) * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static s::unique_ptr<ConcurrentBloomFilter<uint64_t>> concurrent;
+static s::unique_ptr<RuntimeBloomFilter<uint64_t>> locked;
+static s::mutex lock;
+
+static void bm_concurrent_add(b::State& st){
+  if (st.thread_index() == 0) concurrent.reset(new ConcurrentBloomFilter<uint64_t>(NBITS, K));
+  size_t i = 0;
+  for (auto _ : st) concurrent->add(key(st.thread_index(), i++));
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_locked_add(b::State& st){
+  if (st.thread_index() == 0) locked.reset(new RuntimeBloomFilter<uint64_t>(NBITS, K));
+  size_t i = 0;
+  for (auto _ : st){
+    s::lock_guard<s::mutex> g(lock);
+    locked->add(key(st.thread_index(), i++));
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_concurrent_test(b::State& st){
+  if (st.thread_index() == 0){
+    concurrent.reset(new ConcurrentBloomFilter<uint64_t>(NBITS, K));
+    for (size_t i = 0; i < NBITS / 10; ++i) concurrent->add(key(0, i));
+  }
+  size_t i = 0, hit = 0;
+  for (auto _ : st) hit += concurrent->test(key(0, i++ % (NBITS / 5)));
+  b::DoNotOptimize(hit);
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_locked_test(b::State& st){
+  if (st.thread_index() == 0){
+    locked.reset(new RuntimeBloomFilter<uint64_t>(NBITS, K));
+    for (size_t i = 0; i < NBITS / 10; ++i) locked->add(key(0, i));
+  }
+  size_t i = 0, hit = 0;
+  for (auto _ : st){
+    s::lock_guard<s::mutex> g(lock);
+    hit += locked->test(key(0, i++ % (NBITS / 5)));
+  }
+  b::DoNotOptimize(hit);
+  st.SetItemsProcessed(st.iterations());
+}
+
+BENCHMARK(bm_concurrent_add)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(bm_locked_add)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(bm_concurrent_test)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(bm_locked_test)->ThreadRange(1, 8)->UseRealTime();
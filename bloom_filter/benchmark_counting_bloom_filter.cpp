@@ -0,0 +1,138 @@
+#include <cstdint>
+
+#include <blocked_bloom_filter.h>
+#include <runtime_bloom_filter.h>
+#include <counting_bloom_filter.h>
+
+#include <vector>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* CountingBloomFilter sized for NKEYS keys at FPR, against the bit filters it can replace:
+ * RuntimeBloomFilter sized the same way and BlockedBloomFilter with as many bits as the
+ * runtime one. bits_per_key is the memory cost of each at the fpr measured on keys that were
+ * never added; tests are half hits, half misses */
+constexpr size_t NKEYS = 1 << 20;
+constexpr double FPR = 0.01;
+constexpr size_t NTEST = 1 << 16;
+
+using Counting = CountingBloomFilter<uint64_t>;
+using Blocked = BlockedBloomFilter<uint64_t>;
+using Runtime = RuntimeBloomFilter<uint64_t>;
+
+static uint64_t key(size_t i){
+  return i * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static s::unique_ptr<Counting> make_counting(){
+  s::unique_ptr<Counting> bf(new Counting(Counting::from_fpr(NKEYS, FPR)));
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+static s::unique_ptr<Blocked> make_blocked(){
+  s::unique_ptr<Blocked> bf(new Blocked(bloom_optimal_bits(NKEYS, FPR)));
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+static s::unique_ptr<Runtime> make_runtime(){
+  s::unique_ptr<Runtime> bf(new Runtime(Runtime::from_fpr(NKEYS, FPR)));
+  for (size_t i = 0; i < NKEYS; ++i) bf->add(key(i));
+  return bf;
+}
+
+template <typename F>
+static double false_positive_rate(const F& bf){
+  size_t fp = 0;
+  for (size_t i = 0; i < NKEYS; ++i) fp += bf.test(key(NKEYS + i));
+  return (double)fp / NKEYS;
+}
+
+static s::vector<uint64_t> test_keys(){
+  s::vector<uint64_t> keys(NTEST);
+  for (size_t i = 0; i < NTEST; ++i)
+    keys[i] = key((i & 1 ? NKEYS : 0) + i * 7 % NKEYS);
+  return keys;
+}
+
+template <typename F>
+static void report(b::State& st, const F& bf){
+  st.counters["fpr"] = false_positive_rate(bf);
+  st.counters["fpr_model"] = bf.fpr();
+  st.counters["bits_per_key"] = (double)bf.bytes() * 8. / NKEYS;
+}
+
+template <typename F>
+static void test_loop(b::State& st, const F& bf){
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st){
+    size_t hit = 0;
+    for (uint64_t k : keys) hit += bf.test(k);
+    b::DoNotOptimize(hit);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+}
+
+static void bm_counting_add(b::State& st){
+  Counting bf = Counting::from_fpr(NKEYS, FPR);
+  size_t i = 0;
+  for (auto _ : st) bf.add(key(i++ % NKEYS));
+  st.SetItemsProcessed(st.iterations());
+}
+
+//each key removed right after it is added, the filter stays at full load
+static void bm_counting_add_remove(b::State& st){
+  s::unique_ptr<Counting> bf = make_counting();
+  size_t i = 0;
+  for (auto _ : st){
+    uint64_t k = key(NKEYS + i++);
+    bf->add(k);
+    bf->remove(k);
+  }
+  st.SetItemsProcessed(st.iterations() * 2);
+}
+
+static void bm_blocked_add(b::State& st){
+  Blocked bf(bloom_optimal_bits(NKEYS, FPR));
+  size_t i = 0;
+  for (auto _ : st) bf.add(key(i++));
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_runtime_add(b::State& st){
+  Runtime bf = Runtime::from_fpr(NKEYS, FPR);
+  size_t i = 0;
+  for (auto _ : st) bf.add(key(i++));
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_counting_test(b::State& st){
+  s::unique_ptr<Counting> bf = make_counting();
+  test_loop(st, *bf);
+  report(st, *bf);
+}
+
+static void bm_blocked_test(b::State& st){
+  s::unique_ptr<Blocked> bf = make_blocked();
+  test_loop(st, *bf);
+  report(st, *bf);
+}
+
+static void bm_runtime_test(b::State& st){
+  s::unique_ptr<Runtime> bf = make_runtime();
+  test_loop(st, *bf);
+  report(st, *bf);
+}
+
+BENCHMARK(bm_counting_add);
+BENCHMARK(bm_counting_add_remove);
+BENCHMARK(bm_blocked_add);
+BENCHMARK(bm_runtime_add);
+BENCHMARK(bm_counting_test);
+BENCHMARK(bm_blocked_test);
+BENCHMARK(bm_runtime_test);
@@ -0,0 +1,111 @@
+#include <cstdint>
+
+#include <blocked_bloom_filter.h>
+#include <runtime_bloom_filter.h>
+#include <cuckoo_filter.h>
+
+#include <vector>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* CuckooFilter with 8, 12 and 16 bit fingerprints filled to capacity, against
+ * RuntimeBloomFilter sized for the same keys at the fpr of the 12 and 16 bit cuckoo filters,
+ * and BlockedBloomFilter with as many bits as the 16 bit one. bits_per_key is the memory
+ * cost of each at the fpr measured on keys that were never added; tests are half hits,
+ * half misses */
+constexpr size_t NKEYS = 1 << 20;
+constexpr size_t NTEST = 1 << 16;
+
+using Cuckoo8 = CuckooFilter<uint64_t, 8>;
+using Cuckoo12 = CuckooFilter<uint64_t, 12>;
+using Cuckoo16 = CuckooFilter<uint64_t, 16>;
+using Blocked = BlockedBloomFilter<uint64_t>;
+using Runtime = RuntimeBloomFilter<uint64_t>;
+
+static uint64_t key(size_t i){
+  return i * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+template <typename F>
+struct Make {
+  static s::unique_ptr<F> make(){ return s::unique_ptr<F>(new F(NKEYS)); }
+};
+template <>
+struct Make<Blocked> {
+  static s::unique_ptr<Blocked> make(){ return s::unique_ptr<Blocked>(new Blocked(Cuckoo16(NKEYS).bytes() * 8)); }
+};
+template <size_t P>
+struct RuntimeAt : Runtime {
+  //P is the fpr in millionths
+  RuntimeAt(): Runtime(Runtime::from_fpr(NKEYS, (double)P / 1e6)) {}
+};
+template <size_t P>
+struct Make<RuntimeAt<P>> {
+  static s::unique_ptr<RuntimeAt<P>> make(){ return s::unique_ptr<RuntimeAt<P>>(new RuntimeAt<P>()); }
+};
+
+template <typename F>
+static s::unique_ptr<F> make_filled(){
+  s::unique_ptr<F> f = Make<F>::make();
+  for (size_t i = 0; i < NKEYS; ++i) f->add(key(i));
+  return f;
+}
+
+template <typename F>
+static double false_positive_rate(const F& f){
+  size_t fp = 0;
+  for (size_t i = 0; i < NKEYS; ++i) fp += f.test(key(NKEYS + i));
+  return (double)fp / NKEYS;
+}
+
+static s::vector<uint64_t> test_keys(){
+  s::vector<uint64_t> keys(NTEST);
+  for (size_t i = 0; i < NTEST; ++i)
+    keys[i] = key((i & 1 ? NKEYS : 0) + i * 7 % NKEYS);
+  return keys;
+}
+
+//inserts of NKEYS keys into an empty filter, the cuckoo filters up to 95% load
+template <typename F>
+static void bm_add(b::State& st){
+  for (auto _ : st){
+    st.PauseTiming();
+    s::unique_ptr<F> f = Make<F>::make();
+    st.ResumeTiming();
+    for (size_t i = 0; i < NKEYS; ++i) f->add(key(i));
+    b::DoNotOptimize(f->count());
+  }
+  st.SetItemsProcessed(st.iterations() * NKEYS);
+}
+
+template <typename F>
+static void bm_test(b::State& st){
+  s::unique_ptr<F> f = make_filled<F>();
+  s::vector<uint64_t> keys = test_keys();
+  for (auto _ : st){
+    size_t hit = 0;
+    for (uint64_t k : keys) hit += f->test(k);
+    b::DoNotOptimize(hit);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["fpr"] = false_positive_rate(*f);
+  st.counters["fpr_model"] = f->fpr();
+  st.counters["bits_per_key"] = (double)f->bytes() * 8. / NKEYS;
+}
+
+BENCHMARK_TEMPLATE(bm_add, Cuckoo8)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add, Cuckoo12)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add, Cuckoo16)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add, RuntimeAt<1900>)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add, RuntimeAt<120>)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add, Blocked)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_test, Cuckoo8);
+BENCHMARK_TEMPLATE(bm_test, Cuckoo12);
+BENCHMARK_TEMPLATE(bm_test, Cuckoo16);
+BENCHMARK_TEMPLATE(bm_test, RuntimeAt<1900>);
+BENCHMARK_TEMPLATE(bm_test, RuntimeAt<120>);
+BENCHMARK_TEMPLATE(bm_test, Blocked);
@@ -1,6 +1,17 @@
+#ifndef BLOOM_FILTER
+#define BLOOM_FILTER
+
+#include <cassert>
+#include <cmath>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
 #include <tuple>
 
+#include "../hash/byte_hash.h"
+
+namespace s = std;
+
 /* Probability of False Positive:
  * let m be the size of the bit array, k be the number of hash functions, n be the number of expected elements:
  *
@@ -16,6 +27,19 @@
  * k = m / 2 * ln(2)
  */
 
+//m for n expected elements at false positive probability p, rounded up to whole 64 bit words
+inline size_t bloom_optimal_bits(size_t n, double p){
+  assert(p > 0. && p < 1.);
+  double m = -(double)s::max((size_t)1, n) * std::log(p) / (std::log(2.) * std::log(2.));
+  return s::max((size_t)64, ((size_t)std::ceil(m) + 63) / 64 * 64);
+}
+
+//k = m / n ln(2) for m bits and n expected elements
+inline size_t bloom_optimal_hashes(size_t m, size_t n){
+  double k = (double)m / (double)s::max((size_t)1, n) * std::log(2.);
+  return s::max((size_t)1, (size_t)std::lround(k));
+}
+
 template <typename T, size_t V, typename... Hs>
 class BloomFilter {
   template <size_t Idx>
@@ -62,3 +86,5 @@ private:
   bool              mHashIndexes[V];
   size_t            mCount;
 };
+
+#endif//BLOOM_FILTER
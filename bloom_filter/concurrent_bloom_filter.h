@@ -0,0 +1,154 @@
+#ifndef BLOOM_FILTER_CONCURRENT
+#define BLOOM_FILTER_CONCURRENT
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+#include "runtime_bloom_filter.h"
+
+namespace s = std;
+
+/* Concurrent Bloom Filter
+ *
+ * the layout of RuntimeBloomFilter (m bits packed in 64 bit words, k indexes double hashed
+ * from one 64 bit hash) with the words held in atomics, so any number of threads may add and
+ * test at the same time without a lock:
+ *   add:   a word is first read and only fetch_or'ed when the bit is missing, once a filter
+ *          fills most adds write nothing and the cache lines stay shared between cores
+ *   test:  k relaxed loads, wait free
+ * a test racing with the add of the same key may miss it until the add has returned; all
+ * adds done before a thread is joined are seen after the join.
+ *
+ * there is no shared element counter, it would be the one cache line every add writes;
+ * count() estimates the number of distinct keys from the number of bits set.
+ *
+ * filters of the same m, k and hash merge word by word: merge_union is exactly the filter
+ * of the union of both key sets, merge_intersection a filter for their intersection in which
+ * a key of only one of the sets passes at the false positive rate of the other. per thread RuntimeBloomFilters merge into a
+ * concurrent one the same way, and snapshot() copies one out, e.g. to save_binary it.
+ */
+
+template <typename T, typename H = ByteHash64<T>>
+class ConcurrentBloomFilter {
+  H mHash;
+  size_t mBits;
+  size_t mHashes;
+  s::unique_ptr<s::atomic<uint64_t>[]> mWords;
+
+  size_t nwords() const { return mBits / 64; }
+public:
+  ConcurrentBloomFilter(size_t nbits, size_t k, H hash = H()):
+    mHash(hash), mBits(s::max((size_t)64, (nbits + 63) / 64 * 64)), mHashes(s::max((size_t)1, k)),
+    mWords(new s::atomic<uint64_t>[mBits / 64]) {
+    clear();
+  }
+  //(n, p) would otherwise convert p to a hash count, from_fpr takes those
+  template <typename F, typename = typename s::enable_if<s::is_floating_point<F>::value>::type>
+  ConcurrentBloomFilter(size_t, F, H = H()) = delete;
+  ConcurrentBloomFilter(const ConcurrentBloomFilter&) = delete;
+  ConcurrentBloomFilter& operator=(const ConcurrentBloomFilter&) = delete;
+  ~ConcurrentBloomFilter() = default;
+
+  //sized for n elements at false positive probability p
+  static ConcurrentBloomFilter from_fpr(size_t n, double p, H hash = H()){
+    size_t m = bloom_optimal_bits(n, p);
+    return ConcurrentBloomFilter(m, bloom_optimal_hashes(m, n), hash);
+  }
+
+  void add_hash(uint64_t h){
+    DoubleHash g(h);
+    for (size_t i = 0; i < mHashes; ++i){
+      uint64_t b = g.next(mBits);
+      uint64_t bit = (uint64_t)1 << (b % 64);
+      s::atomic<uint64_t>& w = mWords[b / 64];
+      if ((w.load(s::memory_order_relaxed) & bit) == 0)
+        w.fetch_or(bit, s::memory_order_relaxed);
+    }
+  }
+  bool test_hash(uint64_t h) const {
+    DoubleHash g(h);
+    for (size_t i = 0; i < mHashes; ++i){
+      uint64_t b = g.next(mBits);
+      if (((mWords[b / 64].load(s::memory_order_relaxed) >> (b % 64)) & 0x1U) == 0) return false;
+    }
+    return true;
+  }
+
+  void add(const T& v){
+    add_hash(mHash(v));
+  }
+  bool test(const T& v) const {
+    return test_hash(mHash(v));
+  }
+
+  //the layouts must match: same number of bits and hashes, and the same hash functor
+  template <typename F>
+  bool compatible(const F& o) const {
+    return o.size() == mBits && o.hashes() == mHashes;
+  }
+
+  void merge_union(const ConcurrentBloomFilter& o){
+    assert(compatible(o));
+    for (size_t i = 0; i < nwords(); ++i)
+      mWords[i].fetch_or(o.mWords[i].load(s::memory_order_relaxed), s::memory_order_relaxed);
+  }
+  void merge_union(const RuntimeBloomFilter<T, H>& o){
+    assert(compatible(o));
+    const uint64_t* w = o.data();
+    for (size_t i = 0; i < nwords(); ++i)
+      if (w[i]) mWords[i].fetch_or(w[i], s::memory_order_relaxed);
+  }
+  void merge_intersection(const ConcurrentBloomFilter& o){
+    assert(compatible(o));
+    for (size_t i = 0; i < nwords(); ++i)
+      mWords[i].fetch_and(o.mWords[i].load(s::memory_order_relaxed), s::memory_order_relaxed);
+  }
+  void merge_intersection(const RuntimeBloomFilter<T, H>& o){
+    assert(compatible(o));
+    const uint64_t* w = o.data();
+    for (size_t i = 0; i < nwords(); ++i)
+      mWords[i].fetch_and(w[i], s::memory_order_relaxed);
+  }
+
+  //number of bits set, and from it the estimated number of distinct keys added,
+  //n = -m / k ln(1 - X / m) (Swamidass and Baldi)
+  size_t popcount() const {
+    size_t x = 0;
+    for (size_t i = 0; i < nwords(); ++i)
+      x += __builtin_popcountll(mWords[i].load(s::memory_order_relaxed));
+    return x;
+  }
+  size_t count() const {
+    size_t x = popcount();
+    if (x >= mBits) return SIZE_MAX;
+    return (size_t)std::lround(-(double)mBits / (double)mHashes * std::log(1. - (double)x / (double)mBits));
+  }
+  size_t size() const { return mBits; }
+  size_t hashes() const { return mHashes; }
+  size_t bytes() const { return mBits / 8; }
+  //expected false positive rate, from the fraction of bits set
+  double fpr() const {
+    return std::pow((double)popcount() / (double)mBits, (double)mHashes);
+  }
+
+  //owned non-atomic copy with count() as its element count; concurrent adds may or may not be in it
+  RuntimeBloomFilter<T, H> snapshot() const {
+    s::vector<uint64_t> w(nwords());
+    for (size_t i = 0; i < nwords(); ++i)
+      w[i] = mWords[i].load(s::memory_order_relaxed);
+    RuntimeBloomFilter<T, H> view(w.data(), mBits, mHashes, count(), mHash);
+    RuntimeBloomFilter<T, H> owned(view);
+    return owned;
+  }
+
+  //not safe against concurrent adds
+  void clear(){
+    for (size_t i = 0; i < nwords(); ++i)
+      mWords[i].store(0, s::memory_order_relaxed);
+  }
+};
+
+#endif//BLOOM_FILTER_CONCURRENT
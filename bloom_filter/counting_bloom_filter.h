@@ -0,0 +1,223 @@
+#ifndef BLOOM_FILTER_COUNTING
+#define BLOOM_FILTER_COUNTING
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+
+#include "blocked_bloom_filter.h"
+
+namespace s = std;
+
+/* Counting Bloom Filter
+ *
+ * a Bloom filter of 4 bit counters instead of bits, so that keys can be removed again. it
+ * uses the layout and hashing of BlockedBloomFilter: a 64 byte block of 8 words is picked
+ * by the high half of the key's 64 bit hash and probe i < K goes to word i, which holds 16
+ * counters as nibbles; the counter is nibble (lo * BLOOM_SALT[i]) >> 28. with AVX2 at runtime
+ * the K counters of a key are read, compared and updated as 2 vectors of 4 words.
+ *
+ * counters saturate at 15. a saturated counter is never decremented, its true count is
+ * unknown, so it only costs false positives; 15 keys on one counter are very unlikely below
+ * full load. removing a key that was never added decrements the counters of other keys and
+ * can make them test negative: only remove keys that were added.
+ *
+ * memory is 4x that of a BlockedBloomFilter with the same number of slots, fpr() is the rate
+ * of the blocked model with 16 slots per word.
+ */
+
+constexpr size_t COUNTING_BLOCK_COUNTERS = BLOOM_BLOCK_WORDS * 16;
+constexpr uint64_t COUNTING_MAX = 0xF;
+
+#ifdef HASH_X86
+//shift of the nibble of probe i in lane i, 64 for lanes of probes past K: srlv and sllv
+//by 64 give 0, so those lanes read a 0 counter and write nothing
+template <size_t K>
+HASH_AVX2 inline void counting_block_shift_avx2(uint32_t lo, __m256i& s0, __m256i& s1){
+  __m256i pos = _mm256_mullo_epi32(_mm256_set1_epi32((int)lo), _mm256_load_si256((const __m256i*)BLOOM_SALT));
+  pos = _mm256_slli_epi32(_mm256_srli_epi32(pos, 28), 2);
+  if (K < BLOOM_BLOCK_WORDS){
+    alignas(32) static constexpr uint32_t off[BLOOM_BLOCK_WORDS] = {
+      K > 0 ? 0U : 64U, K > 1 ? 0U : 64U, K > 2 ? 0U : 64U, K > 3 ? 0U : 64U,
+      K > 4 ? 0U : 64U, K > 5 ? 0U : 64U, K > 6 ? 0U : 64U, K > 7 ? 0U : 64U,
+    };
+    pos = _mm256_or_si256(pos, _mm256_load_si256((const __m256i*)off));
+  }
+  s0 = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(pos));
+  s1 = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(pos, 1));
+}
+
+//w += 1 in the lanes whose counter is below 15 (DEC: w -= 1 where the counter is 1 to 14)
+template <bool DEC>
+HASH_AVX2 inline __m256i counting_update_avx2(__m256i w, __m256i sh){
+  const __m256i one = _mm256_set1_epi64x(1), max = _mm256_set1_epi64x(COUNTING_MAX);
+  __m256i c = _mm256_and_si256(_mm256_srlv_epi64(w, sh), max);
+  __m256i skip = _mm256_cmpeq_epi64(c, max);
+  if (DEC) skip = _mm256_or_si256(skip, _mm256_cmpeq_epi64(c, _mm256_setzero_si256()));
+  __m256i d = _mm256_andnot_si256(skip, _mm256_sllv_epi64(one, sh));
+  return DEC ? _mm256_sub_epi64(w, d) : _mm256_add_epi64(w, d);
+}
+
+//true if any counter changed
+template <size_t K, bool DEC>
+HASH_AVX2 bool counting_block_update_avx2(BloomBlock& b, uint32_t lo){
+  __m256i s0, s1;
+  counting_block_shift_avx2<K>(lo, s0, s1);
+  __m256i* w = (__m256i*)b.w;
+  __m256i w0 = _mm256_load_si256(w), w1 = _mm256_load_si256(w + 1);
+  __m256i u0 = counting_update_avx2<DEC>(w0, s0), u1 = counting_update_avx2<DEC>(w1, s1);
+  _mm256_store_si256(w, u0);
+  _mm256_store_si256(w + 1, u1);
+  __m256i d = _mm256_or_si256(_mm256_xor_si256(w0, u0), _mm256_xor_si256(w1, u1));
+  return not _mm256_testz_si256(d, d);
+}
+
+//the smallest of the K counters of the key
+template <size_t K>
+HASH_AVX2 uint64_t counting_block_min_avx2(const BloomBlock& b, uint32_t lo){
+  __m256i s0, s1;
+  counting_block_shift_avx2<K>(lo, s0, s1);
+  const __m256i max = _mm256_set1_epi64x(COUNTING_MAX);
+  const __m256i* w = (const __m256i*)b.w;
+  __m256i c0 = _mm256_and_si256(_mm256_srlv_epi64(_mm256_load_si256(w), s0), max);
+  __m256i c1 = _mm256_and_si256(_mm256_srlv_epi64(_mm256_load_si256(w + 1), s1), max);
+  if (K < BLOOM_BLOCK_WORDS){
+    //lanes past K read as 15 so they never are the minimum
+    alignas(32) static constexpr uint64_t pad[BLOOM_BLOCK_WORDS] = {
+      K > 0 ? 0U : COUNTING_MAX, K > 1 ? 0U : COUNTING_MAX, K > 2 ? 0U : COUNTING_MAX, K > 3 ? 0U : COUNTING_MAX,
+      K > 4 ? 0U : COUNTING_MAX, K > 5 ? 0U : COUNTING_MAX, K > 6 ? 0U : COUNTING_MAX, K > 7 ? 0U : COUNTING_MAX,
+    };
+    c0 = _mm256_or_si256(c0, _mm256_load_si256((const __m256i*)pad));
+    c1 = _mm256_or_si256(c1, _mm256_load_si256((const __m256i*)(pad + 4)));
+  }
+  //the counters are in the low dwords, the high ones are set so they never are the minimum
+  const __m256i hi = _mm256_set1_epi64x((long long)0xFFFFFFFF00000000ULL);
+  __m256i c = _mm256_min_epu32(_mm256_or_si256(c0, hi), _mm256_or_si256(c1, hi));
+  __m128i m = _mm_min_epu32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+  m = _mm_min_epu32(m, _mm_srli_si128(m, 8));
+  return (uint64_t)(uint32_t)_mm_cvtsi128_si32(m);
+}
+#endif//HASH_X86
+
+template <size_t K, bool DEC>
+inline bool counting_block_update(BloomBlock& b, uint32_t lo){
+  bool changed = false;
+  for (size_t i = 0; i < K; ++i){
+    unsigned sh = ((lo * BLOOM_SALT[i]) >> 28) * 4;
+    uint64_t c = (b.w[i] >> sh) & COUNTING_MAX;
+    if (c == COUNTING_MAX || (DEC && c == 0)) continue;
+    if (DEC) b.w[i] -= (uint64_t)1 << sh;
+    else     b.w[i] += (uint64_t)1 << sh;
+    changed = true;
+  }
+  return changed;
+}
+
+template <size_t K>
+inline uint64_t counting_block_min(const BloomBlock& b, uint32_t lo){
+  uint64_t m = COUNTING_MAX;
+  for (size_t i = 0; i < K; ++i)
+    m = s::min(m, (b.w[i] >> (((lo * BLOOM_SALT[i]) >> 28) * 4)) & COUNTING_MAX);
+  return m;
+}
+
+template <typename T, typename H = ByteHash64<T>, size_t K = 8>
+class CountingBloomFilter {
+  static_assert(K >= 1 && K <= BLOOM_BLOCK_WORDS, "a block holds one probe per word");
+
+  H mHash;
+  s::vector<BloomBlock> mBlocks;
+  size_t mCount;
+
+  size_t block_of(uint64_t h) const {
+    return (size_t)(((h >> 32) * (uint64_t)mBlocks.size()) >> 32);
+  }
+  template <bool DEC>
+  bool update(uint64_t h){
+    BloomBlock& b = mBlocks[block_of(h)];
+#ifdef HASH_X86
+    if (hash_has_avx2()) return counting_block_update_avx2<K, DEC>(b, (uint32_t)h);
+#endif
+    return counting_block_update<K, DEC>(b, (uint32_t)h);
+  }
+  static size_t blocks_for(size_t n, double p){
+    assert(p > 0. && p < 1.);
+    //the smallest number of blocks meeting p, found by doubling then bisecting
+    size_t lo = 0, hi = 1;
+    while (bloom_block_fpr<K>((double)n, (double)hi, 16.) > p) lo = hi, hi *= 2;
+    while (hi - lo > 1){
+      size_t mid = lo + (hi - lo) / 2;
+      if (bloom_block_fpr<K>((double)n, (double)mid, 16.) > p) lo = mid;
+      else                                                   hi = mid;
+    }
+    return hi;
+  }
+public:
+  //ncounters is rounded up to whole blocks of 128 counters
+  explicit CountingBloomFilter(size_t ncounters, H hash = H()):
+    mHash(hash), mBlocks(s::max((size_t)1, (ncounters + COUNTING_BLOCK_COUNTERS - 1) / COUNTING_BLOCK_COUNTERS)), mCount(0) {
+    clear();
+  }
+  //(n, p) would otherwise convert p to a counter count, from_fpr takes those
+  template <typename F, typename = typename s::enable_if<s::is_floating_point<F>::value>::type>
+  CountingBloomFilter(size_t, F, H = H()) = delete;
+
+  //sized for n elements at false positive probability p
+  static CountingBloomFilter from_fpr(size_t n, double p, H hash = H()){
+    return CountingBloomFilter(blocks_for(n, p) * COUNTING_BLOCK_COUNTERS, hash);
+  }
+
+  void add_hash(uint64_t h){
+    update<false>(h);
+    mCount++;
+  }
+  //false if none of the key's counters could be decremented, they were all 0 or saturated;
+  //count() then stays
+  bool remove_hash(uint64_t h){
+    if (not update<true>(h)) return false;
+    mCount--;
+    return true;
+  }
+  //the smallest counter of the key, an upper bound of how many times it was added unless 15
+  uint64_t estimate_hash(uint64_t h) const {
+    const BloomBlock& b = mBlocks[block_of(h)];
+#ifdef HASH_X86
+    if (hash_has_avx2()) return counting_block_min_avx2<K>(b, (uint32_t)h);
+#endif
+    return counting_block_min<K>(b, (uint32_t)h);
+  }
+  bool test_hash(uint64_t h) const {
+    return estimate_hash(h) != 0;
+  }
+
+  void add(const T& v){
+    add_hash(mHash(v));
+  }
+  bool remove(const T& v){
+    return remove_hash(mHash(v));
+  }
+  bool test(const T& v) const {
+    return test_hash(mHash(v));
+  }
+  uint64_t estimate(const T& v) const {
+    return estimate_hash(mHash(v));
+  }
+
+  size_t count() const { return mCount; }
+  size_t size() const { return mBlocks.size() * COUNTING_BLOCK_COUNTERS; }
+  size_t bytes() const { return mBlocks.size() * sizeof(BloomBlock); }
+  //expected false positive rate with count() keys in the filter
+  double fpr() const {
+    return bloom_block_fpr<K>((double)mCount, (double)mBlocks.size(), 16.);
+  }
+
+  void clear(){
+    memset((void*)mBlocks.data(), 0, bytes());
+    mCount = 0;
+  }
+};
+
+#endif//BLOOM_FILTER_COUNTING
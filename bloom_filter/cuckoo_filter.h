@@ -0,0 +1,220 @@
+#ifndef BLOOM_FILTER_CUCKOO
+#define BLOOM_FILTER_CUCKOO
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "bloom_filter.h"
+#include "../hash/double_hash.h"
+
+namespace s = std;
+
+/* Cuckoo Filter
+ *
+ * an approximate set of F bit fingerprints (Fan, Andersen, Kaminsky and Mitzenmacher) in
+ * buckets of 4 slots. a key's 64 bit hash gives its fingerprint fp (low F bits, 0 is the
+ * empty slot) and its first bucket i1; its second bucket comes from the fingerprint alone,
+ * partial-key cuckoo hashing, so a fingerprint can be moved without its key:
+ *
+ *   i2 = (hash(fp) - i1) mod buckets
+ *
+ * an involution for any number of buckets, not only powers of 2 as with xor. add puts fp in
+ * a free slot of i1 or i2, else evicts a random fingerprint to its other bucket and so on,
+ * up to CUCKOO_MAX_KICKS moves; test and remove look in 2 buckets, 8 slots, at most 2 cache
+ * misses.
+ *
+ * the buckets are packed, 4 * F bits each, and read as one unaligned 64 bit word; the 4
+ * slots are compared to fp at once with the SWAR zero lane test. a lookup matches a
+ * wrong fingerprint with probability 1 - (1 - 1 / (2^F - 1))^(8 load), about 8 / 2^F at full
+ * load, so per key this takes F / load bits where a Bloom filter takes 1.44 log2(1 / p):
+ *
+ *   F = 8:   fpr 3%      8.4 bits per key at 95% load
+ *   F = 12:  fpr 0.2%   12.6 bits per key
+ *   F = 16:  fpr 0.012% 16.8 bits per key, a Bloom filter needs 19 for the same rate
+ *
+ * adding a key k times stores k copies (at most 8 fit), remove takes one back; removing a
+ * key that was never added can remove another key with the same fingerprint and buckets.
+ * when an add runs out of kicks the last evicted fingerprint is kept aside and the filter
+ * is full: no key is lost, but further adds fail until something is removed.
+ *
+ * H is a functor returning a 64 bit hash of T, ByteHash64 by default.
+ */
+
+constexpr size_t CUCKOO_BUCKET_SLOTS = 4;
+constexpr size_t CUCKOO_MAX_KICKS = 500;
+constexpr double CUCKOO_MAX_LOAD = 0.95; //reached with 4 slot buckets before adds start to fail
+
+template <typename T, size_t F = 12, typename H = ByteHash64<T>>
+class CuckooFilter {
+  static_assert(F == 8 || F == 12 || F == 16, "fingerprints are 8, 12 or 16 bits");
+
+  static constexpr uint64_t FP_MASK = ((uint64_t)1 << F) - 1;
+  static constexpr size_t BUCKET_BITS = CUCKOO_BUCKET_SLOTS * F;
+  static constexpr uint64_t BUCKET_MASK = BUCKET_BITS == 64 ? ~(uint64_t)0 : ((uint64_t)1 << BUCKET_BITS) - 1;
+  //lowest and highest bit of each slot
+  static constexpr uint64_t LANE_LO = ((uint64_t)1 << (0 * F)) | ((uint64_t)1 << (1 * F)) | ((uint64_t)1 << (2 * F)) | ((uint64_t)1 << (3 * F));
+  static constexpr uint64_t LANE_HI = LANE_LO << (F - 1);
+
+  struct Victim {
+    bool     used;
+    size_t   bucket;
+    uint64_t fp;
+  };
+
+  H mHash;
+  size_t mBuckets;
+  size_t mCount;
+  s::vector<uint8_t> mData; //mBuckets * BUCKET_BITS / 8 bytes, 8 more so the last bucket reads as a word
+  Victim mVictim;
+  uint64_t mRng;
+
+  uint64_t load_bucket(size_t i) const {
+    uint64_t b;
+    memcpy(&b, &mData[i * BUCKET_BITS / 8], sizeof(b));
+    return b & BUCKET_MASK;
+  }
+  void store_bucket(size_t i, uint64_t b){
+    uint64_t w;
+    uint8_t* p = &mData[i * BUCKET_BITS / 8];
+    memcpy(&w, p, sizeof(w));
+    w = (w & ~BUCKET_MASK) | b;
+    memcpy(p, &w, sizeof(w));
+  }
+  //high bit of the slots holding 0: exact for the lowest such slot, which is all that is used
+  static uint64_t zero_lanes(uint64_t x){
+    return (x - LANE_LO) & ~x & LANE_HI;
+  }
+  static uint64_t match_lanes(uint64_t b, uint64_t fp){
+    return zero_lanes(b ^ (fp * LANE_LO));
+  }
+  static size_t first_lane(uint64_t lanes){
+    return (size_t)__builtin_ctzll(lanes) / F;
+  }
+
+  static uint64_t fingerprint(uint64_t h){
+    uint64_t fp = h & FP_MASK;
+    return fp ? fp : 1;
+  }
+  size_t bucket_of(uint64_t h) const {
+    return (size_t)hash_range(h, mBuckets);
+  }
+  size_t alt_bucket(size_t i, uint64_t fp) const {
+    size_t j = (size_t)hash_range(murmur3_fmix64(fp), mBuckets);
+    return j >= i ? j - i : j + mBuckets - i;
+  }
+
+  bool insert(size_t i, uint64_t fp){
+    uint64_t b = load_bucket(i);
+    uint64_t z = zero_lanes(b);
+    if (z == 0) return false;
+    store_bucket(i, b | (fp << (first_lane(z) * F)));
+    return true;
+  }
+  bool erase(size_t i, uint64_t fp){
+    uint64_t b = load_bucket(i);
+    uint64_t m = match_lanes(b, fp);
+    if (m == 0) return false;
+    store_bucket(i, b & ~(FP_MASK << (first_lane(m) * F)));
+    return true;
+  }
+  bool is_victim(size_t i1, size_t i2, uint64_t fp) const {
+    return mVictim.used && mVictim.fp == fp && (mVictim.bucket == i1 || mVictim.bucket == i2);
+  }
+  bool contains(size_t i1, size_t i2, uint64_t fp) const {
+    return (match_lanes(load_bucket(i1), fp) | match_lanes(load_bucket(i2), fp)) || is_victim(i1, i2, fp);
+  }
+  //fp into bucket i or its alternate, evicting fingerprints to their alternates when both are
+  //full; the one left over after CUCKOO_MAX_KICKS moves becomes the victim
+  void place(size_t i, uint64_t fp){
+    mCount++;
+    if (insert(i, fp) || insert(i = alt_bucket(i, fp), fp)) return;
+    for (size_t n = 0; n < CUCKOO_MAX_KICKS; ++n){
+      size_t lane = (size_t)(next_random() % CUCKOO_BUCKET_SLOTS);
+      uint64_t b = load_bucket(i);
+      uint64_t out = (b >> (lane * F)) & FP_MASK;
+      store_bucket(i, (b & ~(FP_MASK << (lane * F))) | (fp << (lane * F)));
+      fp = out;
+      i = alt_bucket(i, fp);
+      if (insert(i, fp)) return;
+    }
+    mVictim = Victim{true, i, fp};
+  }
+  uint64_t next_random(){
+    mRng ^= mRng << 13;
+    mRng ^= mRng >> 7;
+    mRng ^= mRng << 17;
+    return mRng;
+  }
+public:
+  //room for capacity keys at CUCKOO_MAX_LOAD
+  explicit CuckooFilter(size_t capacity, H hash = H()):
+    mHash(hash),
+    mBuckets(s::max((size_t)1, (size_t)std::ceil((double)capacity / (CUCKOO_BUCKET_SLOTS * CUCKOO_MAX_LOAD)))),
+    mCount(0), mData(mBuckets * BUCKET_BITS / 8 + sizeof(uint64_t)), mVictim{false, 0, 0}, mRng(0x9E3779B97F4A7C15ULL) {}
+
+  //false if the filter is full: the key was not added and test may not find it
+  bool add_hash(uint64_t h){
+    if (mVictim.used) return false;
+    place(bucket_of(h), fingerprint(h));
+    return true;
+  }
+  bool test_hash(uint64_t h) const {
+    uint64_t fp = fingerprint(h);
+    size_t i1 = bucket_of(h);
+    return contains(i1, alt_bucket(i1, fp), fp);
+  }
+  //false if no copy of the fingerprint was found
+  bool remove_hash(uint64_t h){
+    uint64_t fp = fingerprint(h);
+    size_t i1 = bucket_of(h), i2 = alt_bucket(i1, fp);
+    if (erase(i1, fp) || erase(i2, fp)){
+      mCount--;
+      //a slot is free again, the victim may fit
+      if (mVictim.used){
+        mVictim.used = false;
+        mCount--;
+        place(mVictim.bucket, mVictim.fp);
+      }
+      return true;
+    }
+    if (is_victim(i1, i2, fp)){
+      mVictim.used = false;
+      mCount--;
+      return true;
+    }
+    return false;
+  }
+
+  bool add(const T& v){
+    return add_hash(mHash(v));
+  }
+  bool test(const T& v) const {
+    return test_hash(mHash(v));
+  }
+  bool remove(const T& v){
+    return remove_hash(mHash(v));
+  }
+
+  size_t count() const { return mCount; }
+  //number of fingerprint slots
+  size_t size() const { return mBuckets * CUCKOO_BUCKET_SLOTS; }
+  size_t bytes() const { return mBuckets * BUCKET_BITS / 8; }
+  bool full() const { return mVictim.used; }
+  double load_factor() const { return (double)mCount / (double)size(); }
+  //expected false positive rate at the current load
+  double fpr() const {
+    return 1. - std::pow(1. - 1. / (double)FP_MASK, 2. * CUCKOO_BUCKET_SLOTS * load_factor());
+  }
+
+  void clear(){
+    s::fill(mData.begin(), mData.end(), 0);
+    mVictim = Victim{false, 0, 0};
+    mCount = 0;
+  }
+};
+
+#endif//BLOOM_FILTER_CUCKOO
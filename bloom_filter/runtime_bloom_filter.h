@@ -0,0 +1,253 @@
+#ifndef BLOOM_FILTER_RUNTIME
+#define BLOOM_FILTER_RUNTIME
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bloom_filter.h"
+#include "../hash/double_hash.h"
+
+namespace s = std;
+
+/* Runtime Sized Bloom Filter
+ *
+ * a classic Bloom filter whose size is chosen at runtime: the constructor takes m bits and k
+ * hashes, from_fpr the expected number of elements n and the target false positive
+ * probability p, from which m and k follow as derived in bloom_filter.h. the bits are packed 64 to a word on the heap,
+ * and the k indexes of a key come from one 64 bit hash by double hashing.
+ *
+ * Binary Bloom Filter File
+ *
+ * a 64 byte header followed by the words of the bit array exactly as they are in memory, at a
+ * 64 byte aligned offset, in native byte order:
+ *
+ *   save_binary:        write a filter
+ *   load_binary:        read a file into an owned filter
+ *   MappedBloomFilter:  map a file read only and expose it as a const filter that borrows the
+ *                       mapping; any number of processes mapping the same file share one copy
+ *                       of it in the page cache
+ *
+ * the file does not record the hash functor, a filter must be read with the H it was built with;
+ * load_binary keeps the functor of the filter it reads into.
+ */
+
+constexpr char     BLOOM_FILE_MAGIC[4] = {'B', 'L', 'M', 'F'};
+constexpr uint32_t BLOOM_FILE_VERSION = 1;
+constexpr uint64_t BLOOM_FILE_ALIGN = 64;
+
+struct BloomFileHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t hashes;  //k
+  uint32_t flags;
+  uint64_t bits;    //m
+  uint64_t count;   //elements added
+  uint64_t offset;  //byte offset of the first word
+  uint8_t  pad[24];
+};
+static_assert(sizeof(BloomFileHeader) == BLOOM_FILE_ALIGN, "bloom filter file header must be 64 bytes");
+
+template <typename T, typename H = ByteHash64<T>>
+class RuntimeBloomFilter {
+  H mHash;
+  size_t mBits;
+  size_t mHashes;
+  size_t mCount;
+  s::vector<uint64_t> mOwned;
+  const uint64_t* mWords; //mOwned, or a borrowed read only array
+
+  uint64_t* words(){
+    assert(mWords == mOwned.data());
+    return mOwned.data();
+  }
+public:
+  RuntimeBloomFilter(size_t nbits, size_t k, H hash = H()):
+    mHash(hash), mBits(s::max((size_t)64, (nbits + 63) / 64 * 64)), mHashes(s::max((size_t)1, k)), mCount(0),
+    mOwned(mBits / 64), mWords(mOwned.data()) {}
+  //(n, p) would otherwise convert p to a hash count, from_fpr takes those
+  template <typename F, typename = typename s::enable_if<s::is_floating_point<F>::value>::type>
+  RuntimeBloomFilter(size_t, F, H = H()) = delete;
+  //read only view of nbits / 64 words owned by someone else
+  RuntimeBloomFilter(const uint64_t* words, size_t nbits, size_t k, size_t count, H hash = H()):
+    mHash(hash), mBits(nbits), mHashes(k), mCount(count), mWords(words) {}
+
+  //a copy always owns its words
+  RuntimeBloomFilter(const RuntimeBloomFilter& o):
+    mHash(o.mHash), mBits(o.mBits), mHashes(o.mHashes), mCount(o.mCount),
+    mOwned(o.mWords, o.mWords + o.mBits / 64), mWords(mOwned.data()) {}
+  RuntimeBloomFilter(RuntimeBloomFilter&& o) noexcept:
+    mHash(s::move(o.mHash)), mBits(o.mBits), mHashes(o.mHashes), mCount(o.mCount),
+    mOwned(s::move(o.mOwned)), mWords(o.mWords) {}
+  RuntimeBloomFilter& operator=(RuntimeBloomFilter o) noexcept {
+    mHash = s::move(o.mHash);
+    mBits = o.mBits;
+    mHashes = o.mHashes;
+    mCount = o.mCount;
+    mOwned = s::move(o.mOwned);
+    mWords = o.mWords;
+    return *this;
+  }
+  ~RuntimeBloomFilter() = default;
+
+  //sized for n elements at false positive probability p
+  static RuntimeBloomFilter from_fpr(size_t n, double p, H hash = H()){
+    size_t m = bloom_optimal_bits(n, p);
+    return RuntimeBloomFilter(m, bloom_optimal_hashes(m, n), hash);
+  }
+
+  void add_hash(uint64_t h){
+    uint64_t* w = words();
+    DoubleHash g(h);
+    for (size_t i = 0; i < mHashes; ++i){
+      uint64_t b = g.next(mBits);
+      w[b / 64] |= (uint64_t)1 << (b % 64);
+    }
+    mCount++;
+  }
+  bool test_hash(uint64_t h) const {
+    DoubleHash g(h);
+    for (size_t i = 0; i < mHashes; ++i){
+      uint64_t b = g.next(mBits);
+      if (((mWords[b / 64] >> (b % 64)) & 0x1U) == 0) return false;
+    }
+    return true;
+  }
+
+  void add(const T& v){
+    add_hash(mHash(v));
+  }
+  bool test(const T& v) const {
+    return test_hash(mHash(v));
+  }
+
+  size_t count() const { return mCount; }
+  size_t size() const { return mBits; }
+  size_t hashes() const { return mHashes; }
+  size_t bytes() const { return mBits / 8; }
+  const H& hash() const { return mHash; }
+  bool is_borrowed() const { return mWords != mOwned.data(); }
+  const uint64_t* data() const { return mWords; }
+  //expected false positive rate after count() distinct keys
+  double fpr() const {
+    return std::pow(1. - std::exp(-(double)mHashes * (double)mCount / (double)mBits), (double)mHashes);
+  }
+
+  void clear(){
+    memset(words(), 0, bytes());
+    mCount = 0;
+  }
+};
+
+//the filter is written with its count, borrowed or owned
+template <typename T, typename H>
+bool save_binary(const RuntimeBloomFilter<T, H>& f, const s::string& filename){
+  BloomFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, BLOOM_FILE_MAGIC, sizeof(h.magic));
+  h.version = BLOOM_FILE_VERSION;
+  h.hashes = f.hashes();
+  h.bits = f.size();
+  h.count = f.count();
+  h.offset = BLOOM_FILE_ALIGN;
+
+  s::ofstream out(filename.c_str(), s::ios::out | s::ios::binary | s::ios::trunc);
+  if (not out.is_open()){
+    s::cout << "could not open file " << filename << " to save" << s::endl;
+    return false;
+  }
+  out.write((const char*)&h, sizeof(h));
+  out.write((const char*)f.data(), f.bytes());
+  out.close();
+  if (out.fail()){
+    s::cout << "failed writing file " << filename << s::endl;
+    return false;
+  }
+  return true;
+}
+
+//validate a header against the size of the file it came from
+inline bool check_bloom_header(const BloomFileHeader& h, size_t file_size, const s::string& filename){
+  if (memcmp(h.magic, BLOOM_FILE_MAGIC, sizeof(h.magic)) != 0 || h.version != BLOOM_FILE_VERSION){
+    s::cout << "file " << filename << " is not a bloom filter file" << s::endl;
+    return false;
+  }
+  if (h.hashes == 0 || h.bits == 0 || h.bits % 64 != 0 ||
+      h.offset % BLOOM_FILE_ALIGN != 0 || h.offset < sizeof(BloomFileHeader) ||
+      file_size < h.offset || (file_size - h.offset) / 8 < h.bits / 64){
+    s::cout << "file " << filename << " is truncated or corrupted" << s::endl;
+    return false;
+  }
+  return true;
+}
+
+/* read only memory mapping of a bloom filter file; the filter it exposes borrows the mapping
+ * and must not outlive this object, a copy of it is owned and may be added to */
+template <typename T, typename H = ByteHash64<T>>
+class MappedBloomFilter {
+  void*  mMap;
+  size_t mSize;
+  RuntimeBloomFilter<T, H> mFilter;
+public:
+  explicit MappedBloomFilter(const s::string& filename, H hash = H()):
+    mMap(nullptr), mSize(0), mFilter(nullptr, 0, 0, 0, hash) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+      s::cout << "could not open input file " << filename << " to load" << s::endl;
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BloomFileHeader)){
+      s::cout << "file " << filename << " is not a bloom filter file" << s::endl;
+      ::close(fd);
+      return;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED){
+      s::cout << "could not map file " << filename << s::endl;
+      return;
+    }
+
+    BloomFileHeader h;
+    memcpy(&h, map, sizeof(h));
+    if (not check_bloom_header(h, st.st_size, filename)){
+      munmap(map, st.st_size);
+      return;
+    }
+    mMap = map;
+    mSize = st.st_size;
+    mFilter = RuntimeBloomFilter<T, H>((const uint64_t*)((const char*)map + h.offset), h.bits, h.hashes, h.count, hash);
+  }
+  MappedBloomFilter(const MappedBloomFilter&) = delete;
+  MappedBloomFilter& operator=(const MappedBloomFilter&) = delete;
+  ~MappedBloomFilter(){
+    if (mMap) munmap(mMap, mSize);
+  }
+
+  bool is_open() const { return mMap != nullptr; }
+  const RuntimeBloomFilter<T, H>& filter() const { return mFilter; }
+  bool test(const T& v) const { return mFilter.test(v); }
+};
+
+//owned copy of a bloom filter file hashed with f's functor; false and f untouched if the file
+//could not be read
+template <typename T, typename H>
+bool load_binary(RuntimeBloomFilter<T, H>& f, const s::string& filename){
+  MappedBloomFilter<T, H> mapped(filename, f.hash());
+  if (not mapped.is_open()) return false;
+  f = mapped.filter();
+  return true;
+}
+
+#endif//BLOOM_FILTER_RUNTIME
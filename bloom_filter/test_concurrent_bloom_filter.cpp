@@ -0,0 +1,70 @@
+#include <concurrent_bloom_filter.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentBloomFilter, Basic){
+  auto bf = ConcurrentBloomFilter<uint64_t>::from_fpr(10000, 0.01);
+  EXPECT_EQ(95872UL, bf.size());
+  EXPECT_EQ(7UL, bf.hashes());
+  for (uint64_t i = 0; i < 10000; ++i) bf.add(i);
+  for (uint64_t i = 0; i < 10000; ++i) EXPECT_TRUE(bf.test(i));
+  size_t fp = 0;
+  for (uint64_t i = 10000; i < 110000; ++i) fp += bf.test(i);
+  EXPECT_LT(fp, 1200UL);
+  EXPECT_NEAR(10000., (double)bf.count(), 300.);
+  bf.clear();
+  EXPECT_EQ(0UL, bf.count());
+  EXPECT_FALSE(bf.test(1));
+}
+
+//the same keys added by one thread to a RuntimeBloomFilter and by 4 threads concurrently
+TEST(ConcurrentBloomFilter, Threads){
+  constexpr size_t N = 40000, NT = 4;
+  auto bf = ConcurrentBloomFilter<uint64_t>::from_fpr(N, 0.01);
+  auto ref = RuntimeBloomFilter<uint64_t>::from_fpr(N, 0.01);
+  for (uint64_t i = 0; i < N; ++i) ref.add(i);
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < NT; ++t)
+    threads.emplace_back([&bf, t](){
+      for (uint64_t i = t; i < N; i += NT) bf.add(i);
+    });
+  for (std::thread& t : threads) t.join();
+
+  RuntimeBloomFilter<uint64_t> snap = bf.snapshot();
+  EXPECT_FALSE(snap.is_borrowed());
+  for (size_t i = 0; i < snap.size() / 64; ++i)
+    ASSERT_EQ(ref.data()[i], snap.data()[i]);
+}
+
+TEST(ConcurrentBloomFilter, Merge){
+  constexpr size_t N = 5000;
+  auto a = ConcurrentBloomFilter<uint64_t>::from_fpr(2 * N, 0.01), b = ConcurrentBloomFilter<uint64_t>::from_fpr(2 * N, 0.01);
+  auto c = RuntimeBloomFilter<uint64_t>::from_fpr(2 * N, 0.01);
+  for (uint64_t i = 0; i < N; ++i) a.add(i);
+  for (uint64_t i = N / 2; i < N + N / 2; ++i) b.add(i);
+  for (uint64_t i = 2 * N; i < 3 * N; ++i) c.add(i);
+  ASSERT_TRUE(a.compatible(b));
+  ASSERT_TRUE(a.compatible(c));
+
+  auto u = ConcurrentBloomFilter<uint64_t>::from_fpr(2 * N, 0.01);
+  u.merge_union(a);
+  u.merge_union(b);
+  u.merge_union(c);
+  for (uint64_t i = 0; i < 3 * N; ++i)
+    if (i < N + N / 2 || i >= 2 * N){ EXPECT_TRUE(u.test(i)); }
+
+  a.merge_intersection(b);
+  size_t in = 0, out = 0;
+  for (uint64_t i = N / 2; i < N; ++i) in += a.test(i);
+  for (uint64_t i = 0; i < N / 2; ++i) out += a.test(i);
+  EXPECT_EQ(N / 2, in);
+  EXPECT_LT(out, N / 20);
+
+  auto empty = RuntimeBloomFilter<uint64_t>::from_fpr(2 * N, 0.01);
+  a.merge_intersection(empty);
+  EXPECT_EQ(0UL, a.popcount());
+}
@@ -0,0 +1,89 @@
+#include <counting_bloom_filter.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+TEST(CountingBloomFilter, AddRemove){
+  CountingBloomFilter<std::string> bf(1024);
+  EXPECT_EQ(1024UL, bf.size());
+  EXPECT_EQ(512UL, bf.bytes());
+  bf.add("death");
+  bf.add("war");
+  bf.add("famine");
+  EXPECT_TRUE(bf.test("death"));
+  EXPECT_TRUE(bf.test("war"));
+  EXPECT_TRUE(bf.test("famine"));
+  EXPECT_FALSE(bf.test("peace"));
+  bf.remove("war");
+  EXPECT_FALSE(bf.test("war"));
+  EXPECT_TRUE(bf.test("death"));
+  EXPECT_TRUE(bf.test("famine"));
+  EXPECT_EQ(2UL, bf.count());
+}
+
+//a remove that finds all counters of the key at 0 changes nothing, count() does not wrap
+TEST(CountingBloomFilter, RemoveAbsent){
+  CountingBloomFilter<uint64_t> bf(1 << 16);
+  EXPECT_FALSE(bf.remove(7));
+  EXPECT_EQ(0UL, bf.count());
+  bf.add(7);
+  EXPECT_TRUE(bf.remove(7));
+  EXPECT_FALSE(bf.remove(7));
+  EXPECT_EQ(0UL, bf.count());
+}
+
+TEST(CountingBloomFilter, Estimate){
+  CountingBloomFilter<uint64_t> bf(1 << 16);
+  for (size_t i = 0; i < 5; ++i) bf.add(42);
+  EXPECT_EQ(5UL, bf.estimate(42));
+  for (size_t i = 0; i < 20; ++i) bf.add(42);
+  EXPECT_EQ(15UL, bf.estimate(42));
+  //saturated counters stay
+  for (size_t i = 0; i < 25; ++i) bf.remove(42);
+  EXPECT_EQ(15UL, bf.estimate(42));
+  bf.clear();
+  EXPECT_EQ(0UL, bf.estimate(42));
+}
+
+//adding then removing half of the keys leaves the other half and the rate of a filter of
+//the remaining half
+TEST(CountingBloomFilter, FalsePositiveRate){
+  constexpr size_t N = 40000;
+  auto bf = CountingBloomFilter<uint64_t>::from_fpr(N, 0.01);
+  for (uint64_t i = 0; i < 2 * N; ++i) bf.add(i);
+  for (uint64_t i = N; i < 2 * N; ++i) bf.remove(i);
+  for (uint64_t i = 0; i < N; ++i) ASSERT_TRUE(bf.test(i));
+  size_t fp = 0;
+  for (uint64_t i = N; i < 11 * N; ++i) fp += bf.test(i);
+  double rate = (double)fp / (10 * N);
+  EXPECT_LE(bf.fpr(), 0.01);
+  EXPECT_NEAR(bf.fpr(), rate, 0.002);
+}
+
+template <size_t K>
+void counting_scalar_matches_vector(){
+  for (uint32_t lo : {0U, 1U, 0xDEADBEEFU, 0xFFFFFFFFU, 0x12345678U}){
+    BloomBlock a = {}, b = {};
+    for (size_t i = 0; i < 17; ++i){
+      bool ca = counting_block_update<K, false>(a, lo), cb = counting_block_update_avx2<K, false>(b, lo);
+      ASSERT_EQ(ca, cb);
+      for (size_t j = 0; j < BLOOM_BLOCK_WORDS; ++j) ASSERT_EQ(a.w[j], b.w[j]);
+      ASSERT_EQ(counting_block_min<K>(a, lo), counting_block_min_avx2<K>(b, lo));
+    }
+    for (size_t i = 0; i < 3; ++i){
+      bool ca = counting_block_update<K, true>(a, lo ^ 0x5555U), cb = counting_block_update_avx2<K, true>(b, lo ^ 0x5555U);
+      ASSERT_EQ(ca, cb);
+      for (size_t j = 0; j < BLOOM_BLOCK_WORDS; ++j) ASSERT_EQ(a.w[j], b.w[j]);
+      ASSERT_EQ(counting_block_min<K>(a, lo ^ 0x5555U), counting_block_min_avx2<K>(b, lo ^ 0x5555U));
+    }
+  }
+}
+
+TEST(CountingBloomFilter, ScalarMatchesVector){
+  if (not hash_has_avx2()) return;
+  counting_scalar_matches_vector<8>();
+  counting_scalar_matches_vector<5>();
+  counting_scalar_matches_vector<1>();
+}
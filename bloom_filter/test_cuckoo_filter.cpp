@@ -0,0 +1,81 @@
+#include <cuckoo_filter.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+TEST(CuckooFilter, AddRemove){
+  CuckooFilter<std::string> cf(1000);
+  EXPECT_EQ(1056UL, cf.size());
+  EXPECT_EQ(1584UL, cf.bytes());
+  EXPECT_TRUE(cf.add("death"));
+  EXPECT_TRUE(cf.add("war"));
+  EXPECT_TRUE(cf.add("famine"));
+  EXPECT_TRUE(cf.test("death"));
+  EXPECT_TRUE(cf.test("war"));
+  EXPECT_TRUE(cf.test("famine"));
+  EXPECT_FALSE(cf.test("peace"));
+  EXPECT_TRUE(cf.remove("war"));
+  EXPECT_FALSE(cf.test("war"));
+  EXPECT_FALSE(cf.remove("war"));
+  EXPECT_TRUE(cf.test("death"));
+  EXPECT_TRUE(cf.test("famine"));
+  EXPECT_EQ(2UL, cf.count());
+  cf.clear();
+  EXPECT_FALSE(cf.test("death"));
+  EXPECT_EQ(0UL, cf.count());
+}
+
+TEST(CuckooFilter, Duplicates){
+  CuckooFilter<uint64_t> cf(1000);
+  for (size_t i = 0; i < 3; ++i) EXPECT_TRUE(cf.add(42));
+  for (size_t i = 0; i < 3; ++i){
+    EXPECT_TRUE(cf.test(42));
+    EXPECT_TRUE(cf.remove(42));
+  }
+  EXPECT_FALSE(cf.test(42));
+}
+
+//fill to capacity, every key is found, then remove all of them
+template <size_t F>
+void cuckoo_fill(double fpr){
+  constexpr size_t N = 100000;
+  CuckooFilter<uint64_t, F> cf(N);
+  for (uint64_t i = 0; i < N; ++i) ASSERT_TRUE(cf.add(i));
+  EXPECT_FALSE(cf.full());
+  EXPECT_GT(cf.load_factor(), 0.9);
+  for (uint64_t i = 0; i < N; ++i) ASSERT_TRUE(cf.test(i));
+  size_t fp = 0;
+  for (uint64_t i = N; i < 11 * N; ++i) fp += cf.test(i);
+  double rate = (double)fp / (10 * N);
+  EXPECT_LT(rate, fpr);
+  EXPECT_NEAR(cf.fpr(), rate, cf.fpr() * 0.25);
+  for (uint64_t i = 0; i < N; ++i) ASSERT_TRUE(cf.remove(i));
+  EXPECT_EQ(0UL, cf.count());
+  for (uint64_t i = 0; i < N; ++i) ASSERT_FALSE(cf.test(i));
+}
+
+TEST(CuckooFilter, Fill8){ cuckoo_fill<8>(0.04); }
+TEST(CuckooFilter, Fill12){ cuckoo_fill<12>(0.003); }
+TEST(CuckooFilter, Fill16){ cuckoo_fill<16>(0.0002); }
+
+//past capacity adds fail but no key that was added is lost
+TEST(CuckooFilter, Overfull){
+  constexpr size_t N = 4096;
+  CuckooFilter<uint64_t, 16> cf(N);
+  std::vector<uint64_t> added;
+  for (uint64_t i = 0; i < 2 * N; ++i)
+    if (cf.add(i)) added.push_back(i);
+  EXPECT_TRUE(cf.full());
+  EXPECT_EQ(added.size(), cf.count());
+  EXPECT_LE(added.size(), cf.size());
+  for (uint64_t k : added) ASSERT_TRUE(cf.test(k));
+  //removals make room for the victim
+  size_t removed = added.size() / 10;
+  for (size_t i = 0; i < removed; ++i) ASSERT_TRUE(cf.remove(added[i]));
+  EXPECT_FALSE(cf.full());
+  EXPECT_EQ(added.size() - removed, cf.count());
+  for (size_t i = removed; i < added.size(); ++i) ASSERT_TRUE(cf.test(added[i]));
+  EXPECT_TRUE(cf.add(2 * N));
+}
@@ -0,0 +1,120 @@
+#include <runtime_bloom_filter.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+
+TEST(RuntimeBloomFilter, Sizing){
+  //n = 1000, p = 1%: m = 9585.06 rounded up to 9600 bits and k = 7
+  auto bf = RuntimeBloomFilter<uint64_t>::from_fpr(1000, 0.01);
+  EXPECT_EQ(9600UL, bf.size());
+  EXPECT_EQ(7UL, bf.hashes());
+  EXPECT_EQ(1200UL, bf.bytes());
+
+  RuntimeBloomFilter<uint64_t> bf2(100, 3);
+  EXPECT_EQ(128UL, bf2.size());
+  EXPECT_EQ(3UL, bf2.hashes());
+}
+
+TEST(RuntimeBloomFilter, FalsePositiveRate){
+  constexpr size_t N = 50000;
+  for (double p : {0.01, 0.001}){
+    auto bf = RuntimeBloomFilter<uint64_t>::from_fpr(N, p);
+    for (uint64_t i = 0; i < N; ++i) bf.add(i);
+    for (uint64_t i = 0; i < N; ++i) ASSERT_TRUE(bf.test(i));
+    size_t fp = 0;
+    for (uint64_t i = N; i < 11 * N; ++i) fp += bf.test(i);
+    EXPECT_LT((double)fp / (10 * N), p * 1.2);
+    EXPECT_NEAR(p, bf.fpr(), p * 0.1);
+  }
+}
+
+TEST(RuntimeBloomFilter, String){
+  auto bf = RuntimeBloomFilter<std::string>::from_fpr(10, 0.01);
+  bf.add("death");
+  bf.add("war");
+  bf.add("famine");
+  EXPECT_TRUE(bf.test("death"));
+  EXPECT_TRUE(bf.test("war"));
+  EXPECT_TRUE(bf.test("famine"));
+  EXPECT_FALSE(bf.test("peace"));
+  bf.clear();
+  EXPECT_FALSE(bf.test("death"));
+  EXPECT_EQ(0UL, bf.count());
+}
+
+struct TestBloomFile : ::testing::Test {
+  std::string filename;
+  TestBloomFile(): filename(std::string("/tmp/test_bloom_") + std::to_string(getpid()) + ".bin") {}
+  ~TestBloomFile(){
+    std::remove(filename.c_str());
+  }
+};
+
+TEST_F(TestBloomFile, SaveLoadMap){
+  auto bf = RuntimeBloomFilter<uint64_t>::from_fpr(5000, 0.001);
+  for (uint64_t i = 0; i < 5000; ++i) bf.add(i * 3);
+  ASSERT_TRUE(save_binary(bf, filename));
+
+  RuntimeBloomFilter<uint64_t> loaded(64, 1);
+  ASSERT_TRUE(load_binary(loaded, filename));
+  EXPECT_FALSE(loaded.is_borrowed());
+  EXPECT_EQ(bf.size(), loaded.size());
+  EXPECT_EQ(bf.hashes(), loaded.hashes());
+  EXPECT_EQ(bf.count(), loaded.count());
+
+  MappedBloomFilter<uint64_t> mapped(filename);
+  ASSERT_TRUE(mapped.is_open());
+  EXPECT_TRUE(mapped.filter().is_borrowed());
+  EXPECT_EQ(0UL, (size_t)mapped.filter().data() % BLOOM_FILE_ALIGN);
+  for (uint64_t i = 0; i < 15000; ++i){
+    EXPECT_EQ(bf.test(i), loaded.test(i));
+    EXPECT_EQ(bf.test(i), mapped.test(i));
+  }
+
+  //a copy of the mapped filter is owned and can grow
+  RuntimeBloomFilter<uint64_t> copy = mapped.filter();
+  EXPECT_FALSE(copy.is_borrowed());
+  copy.add(1);
+  EXPECT_TRUE(copy.test(1));
+  EXPECT_EQ(5001UL, copy.count());
+}
+
+TEST_F(TestBloomFile, Corrupted){
+  auto bf = RuntimeBloomFilter<uint64_t>::from_fpr(1000, 0.01);
+  ASSERT_TRUE(save_binary(bf, filename));
+  //cut off the last word
+  {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size() - 8);
+  }
+  MappedBloomFilter<uint64_t> mapped(filename);
+  EXPECT_FALSE(mapped.is_open());
+  RuntimeBloomFilter<uint64_t> loaded(64, 1);
+  EXPECT_FALSE(load_binary(loaded, filename));
+  EXPECT_EQ(64UL, loaded.size());
+  EXPECT_FALSE(load_binary(loaded, "/nonexistent/bloom.bin"));
+}
+
+//a hash with state: the filter a file is loaded into keeps its own
+struct SeededHash {
+  uint64_t seed;
+  uint64_t operator()(const uint64_t& v) const {
+    return murmur3_x64_128((const uint8_t*)&v, sizeof(v), (uint32_t)seed).h1;
+  }
+};
+
+TEST_F(TestBloomFile, LoadKeepsHash){
+  RuntimeBloomFilter<uint64_t, SeededHash> bf(4096, 5, SeededHash{77});
+  for (uint64_t i = 0; i < 300; ++i) bf.add(i);
+  ASSERT_TRUE(save_binary(bf, filename));
+
+  RuntimeBloomFilter<uint64_t, SeededHash> loaded(64, 1, SeededHash{77});
+  ASSERT_TRUE(load_binary(loaded, filename));
+  EXPECT_EQ(77UL, loaded.hash().seed);
+  for (uint64_t i = 0; i < 300; ++i) EXPECT_TRUE(loaded.test(i));
+}
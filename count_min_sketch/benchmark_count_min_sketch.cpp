@@ -0,0 +1,137 @@
+#include <cstdint>
+
+#include <runtime_count_min_sketch.h>
+#include <concurrent_count_min_sketch.h>
+#include <heavy_hitters.h>
+#include <windowed_count_min_sketch.h>
+
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* counting a skewed stream of NSTREAM keys, key i drawn with probability ~ 1 / (i + 1) out of
+ * NDISTINCT, into sketches of WIDTH x DEPTH counters: 8, 16 and 32 bit counters with
+ * standard and conservative update, the lock free ConcurrentCountMinSketch against a
+ * RuntimeCountMinSketch behind a mutex, HeavyHitters tracking the top 100, and
+ * WindowedCountMinSketch with the stream spread over 4 windows of 8 slots. mean_error is
+ * the mean error over the distinct keys, negative once 8 bit counters of the heaviest keys
+ * saturate; bytes is the size of the counters */
+constexpr size_t NSTREAM = 1 << 20;
+constexpr size_t NDISTINCT = 1 << 16;
+constexpr size_t WIDTH = 1 << 14;
+constexpr size_t DEPTH = 4;
+
+static const s::vector<uint64_t>& stream(){
+  static s::vector<uint64_t> keys;
+  if (keys.empty()){
+    //inverse cdf of the harmonic distribution, i = exp(u ln(NDISTINCT)) - 1 approximately
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    keys.resize(NSTREAM);
+    for (size_t i = 0; i < NSTREAM; ++i){
+      x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+      double u = (double)(x >> 11) / (double)(1ULL << 53);
+      keys[i] = (uint64_t)std::exp(u * std::log((double)NDISTINCT)) - 1;
+    }
+  }
+  return keys;
+}
+
+template <typename S>
+static double mean_error(const S& cms){
+  s::unordered_map<uint64_t, uint64_t> truth;
+  for (uint64_t k : stream()) truth[k]++;
+  double err = 0.;
+  for (auto& kv : truth) err += (double)cms.estimate(kv.first) - (double)kv.second;
+  return err / truth.size();
+}
+
+template <typename C, bool CU>
+static void bm_count(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  RuntimeCountMinSketch<uint64_t, C, CU> cms(WIDTH, DEPTH);
+  for (auto _ : st){
+    cms.clear();
+    for (uint64_t k : keys) cms.count(k);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["mean_error"] = mean_error(cms);
+  st.counters["bytes"] = cms.bytes();
+}
+
+static s::unique_ptr<ConcurrentCountMinSketch<uint64_t>> concurrent;
+static s::unique_ptr<RuntimeCountMinSketch<uint64_t>> locked;
+static s::mutex lock;
+
+static void bm_concurrent_count(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  if (st.thread_index() == 0) concurrent.reset(new ConcurrentCountMinSketch<uint64_t>(WIDTH, DEPTH));
+  size_t i = st.thread_index() * (NSTREAM / 8);
+  for (auto _ : st) concurrent->count(keys[i++ % NSTREAM]);
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_locked_count(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  if (st.thread_index() == 0) locked.reset(new RuntimeCountMinSketch<uint64_t>(WIDTH, DEPTH));
+  size_t i = st.thread_index() * (NSTREAM / 8);
+  for (auto _ : st){
+    s::lock_guard<s::mutex> g(lock);
+    locked->count(keys[i++ % NSTREAM]);
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+
+static void bm_heavy_hitters(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  HeavyHitters<uint64_t> hh(100, RuntimeCountMinSketch<uint64_t, uint32_t, true>(WIDTH, DEPTH));
+  for (auto _ : st){
+    hh.clear();
+    for (uint64_t k : keys) hh.count(k);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["threshold"] = hh.threshold();
+}
+
+//the stream over 4 windows, ticks advancing one every 32 keys
+static void bm_windowed_count(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  WindowedCountMinSketch<uint64_t> cms(WIDTH, DEPTH, NSTREAM / 32 / 4, 8);
+  for (auto _ : st){
+    cms.clear();
+    for (size_t i = 0; i < keys.size(); ++i) cms.count(keys[i], i / 32);
+  }
+  st.SetItemsProcessed(st.iterations() * keys.size());
+  st.counters["bytes"] = cms.bytes();
+}
+
+static void bm_windowed_estimate(b::State& st){
+  const s::vector<uint64_t>& keys = stream();
+  WindowedCountMinSketch<uint64_t> cms(WIDTH, DEPTH, NSTREAM / 32 / 4, 8);
+  for (size_t i = 0; i < keys.size(); ++i) cms.count(keys[i], i / 32);
+  uint64_t now = (NSTREAM - 1) / 32;
+  for (auto _ : st){
+    uint64_t e = 0;
+    for (size_t i = 0; i < NDISTINCT; ++i) e += cms.estimate(i, now);
+    b::DoNotOptimize(e);
+  }
+  st.SetItemsProcessed(st.iterations() * NDISTINCT);
+}
+
+BENCHMARK_TEMPLATE(bm_count, uint8_t, false)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_count, uint8_t, true)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_count, uint16_t, false)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_count, uint16_t, true)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_count, uint32_t, false)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_count, uint32_t, true)->Unit(b::kMillisecond);
+BENCHMARK(bm_concurrent_count)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(bm_locked_count)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(bm_heavy_hitters)->Unit(b::kMillisecond);
+BENCHMARK(bm_windowed_count)->Unit(b::kMillisecond);
+BENCHMARK(bm_windowed_estimate)->Unit(b::kMillisecond);
@@ -0,0 +1,204 @@
+#ifndef COUNT_MIN_SKETCH_FILE
+#define COUNT_MIN_SKETCH_FILE
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+#include "runtime_count_min_sketch.h"
+#include "windowed_count_min_sketch.h"
+
+namespace s = std;
+
+/* Binary Count-Min Sketch File
+ *
+ * a 64 byte header, then for a windowed sketch the epoch and total of each slot, then the
+ * counters of every slot one after the other exactly as they are in memory, in native byte
+ * order. it is written to and read from any stream, so a shard can send its sketch over a
+ * socket or a pipe as well as leave it in a file for an aggregator to merge:
+ *
+ *   write_binary / read_binary:  a RuntimeCountMinSketch or WindowedCountMinSketch on a stream
+ *   save_binary / load_binary:   the same on a file
+ *
+ * the counter width must match when reading, the update mode need not. the file does not
+ * record the hash functor, a sketch must be read with the H it was built with; read_binary
+ * keeps the functor of the sketch it reads into.
+ */
+
+constexpr char     CMS_FILE_MAGIC[4] = {'C', 'M', 'S', 'K'};
+constexpr uint32_t CMS_FILE_VERSION = 1;
+constexpr uint32_t CMS_FILE_CONSERVATIVE = 0x1;
+constexpr uint32_t CMS_FILE_WINDOWED = 0x2;
+constexpr uint64_t CMS_FILE_MAX_SLOTS = 1 << 16; //more sub-sketches than this is a corrupted header
+
+struct CountMinFileHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t counter; //bytes per counter
+  uint32_t flags;
+  uint64_t width;
+  uint64_t depth;
+  uint64_t total;   //plain sketch only
+  uint64_t slots;   //windowed sketch only
+  uint64_t span;    //windowed sketch only, ticks per slot
+  uint8_t  pad[8];
+};
+static_assert(sizeof(CountMinFileHeader) == 64, "count-min sketch file header must be 64 bytes");
+
+struct CountMinFileSlot {
+  uint64_t epoch;
+  uint64_t total;
+};
+
+template <typename C, bool CU>
+CountMinFileHeader make_cms_header(size_t width, size_t depth, bool windowed){
+  CountMinFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CMS_FILE_MAGIC, sizeof(h.magic));
+  h.version = CMS_FILE_VERSION;
+  h.counter = sizeof(C);
+  h.flags = (CU ? CMS_FILE_CONSERVATIVE : 0) | (windowed ? CMS_FILE_WINDOWED : 0);
+  h.width = width;
+  h.depth = depth;
+  return h;
+}
+
+//validate a header against the counter type and the kind of sketch being read
+template <typename C>
+bool check_cms_header(const CountMinFileHeader& h, bool windowed, const s::string& name){
+  if (memcmp(h.magic, CMS_FILE_MAGIC, sizeof(h.magic)) != 0 || h.version != CMS_FILE_VERSION){
+    s::cout << name << " is not a count-min sketch" << s::endl;
+    return false;
+  }
+  if (h.counter != sizeof(C)){
+    s::cout << name << " has " << h.counter << " byte counters, expected " << sizeof(C) << s::endl;
+    return false;
+  }
+  if (((h.flags & CMS_FILE_WINDOWED) != 0) != windowed){
+    s::cout << name << (windowed ? " is not" : " is") << " a windowed count-min sketch" << s::endl;
+    return false;
+  }
+  if (h.width == 0 || h.depth == 0 || h.depth > CMS_MAX_DEPTH || h.width > SIZE_MAX / sizeof(C) / h.depth ||
+      (windowed && (h.slots == 0 || h.slots > CMS_FILE_MAX_SLOTS || h.span == 0 || h.span > UINT64_MAX / h.slots ||
+                    h.width * h.depth > SIZE_MAX / sizeof(C) / h.slots))){
+    s::cout << name << " is corrupted" << s::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename T, typename C, bool CU, typename H>
+bool write_binary(const RuntimeCountMinSketch<T, C, CU, H>& cms, s::ostream& out){
+  CountMinFileHeader h = make_cms_header<C, CU>(cms.width(), cms.depth(), false);
+  h.total = cms.total();
+  out.write((const char*)&h, sizeof(h));
+  out.write((const char*)cms.data(), cms.bytes());
+  return not out.fail();
+}
+
+//cms is replaced by the sketch read with its own hash, untouched if it could not be read
+template <typename T, typename C, bool CU, typename H>
+bool read_binary(RuntimeCountMinSketch<T, C, CU, H>& cms, s::istream& in, const s::string& name = "stream"){
+  CountMinFileHeader h;
+  if (not in.read((char*)&h, sizeof(h))){
+    s::cout << name << " is not a count-min sketch" << s::endl;
+    return false;
+  }
+  if (not check_cms_header<C>(h, false, name)) return false;
+  s::vector<C> c(h.width * h.depth);
+  if (not in.read((char*)c.data(), c.size() * sizeof(C))){
+    s::cout << name << " is truncated" << s::endl;
+    return false;
+  }
+  cms = RuntimeCountMinSketch<T, C, CU, H>(c.data(), h.width, h.depth, h.total, cms.hash());
+  return true;
+}
+
+template <typename T, typename C, bool CU, typename H>
+bool write_binary(const WindowedCountMinSketch<T, C, CU, H>& cms, s::ostream& out){
+  CountMinFileHeader h = make_cms_header<C, CU>(cms.width(), cms.depth(), true);
+  h.slots = cms.slots();
+  h.span = cms.span();
+  out.write((const char*)&h, sizeof(h));
+  for (size_t i = 0; i < cms.slots(); ++i){
+    CountMinFileSlot sl = {cms.epoch(i), cms.slot(i).total()};
+    out.write((const char*)&sl, sizeof(sl));
+  }
+  for (size_t i = 0; i < cms.slots(); ++i)
+    out.write((const char*)cms.slot(i).data(), cms.slot(i).bytes());
+  return not out.fail();
+}
+
+template <typename T, typename C, bool CU, typename H>
+bool read_binary(WindowedCountMinSketch<T, C, CU, H>& cms, s::istream& in, const s::string& name = "stream"){
+  CountMinFileHeader h;
+  if (not in.read((char*)&h, sizeof(h))){
+    s::cout << name << " is not a count-min sketch" << s::endl;
+    return false;
+  }
+  if (not check_cms_header<C>(h, true, name)) return false;
+  s::vector<CountMinFileSlot> sl(h.slots);
+  s::vector<C> c(h.width * h.depth);
+  if (not in.read((char*)sl.data(), sl.size() * sizeof(CountMinFileSlot))){
+    s::cout << name << " is truncated" << s::endl;
+    return false;
+  }
+  auto ret = WindowedCountMinSketch<T, C, CU, H>::from_span(h.width, h.depth, h.span, h.slots, cms.hash());
+  for (size_t i = 0; i < h.slots; ++i){
+    if (not in.read((char*)c.data(), c.size() * sizeof(C))){
+      s::cout << name << " is truncated" << s::endl;
+      return false;
+    }
+    ret.set_slot(i, sl[i].epoch, RuntimeCountMinSketch<T, C, CU, H>(c.data(), h.width, h.depth, sl[i].total, cms.hash()));
+  }
+  cms = s::move(ret);
+  return true;
+}
+
+template <typename S>
+bool save_cms_file(const S& cms, const s::string& filename){
+  s::ofstream out(filename.c_str(), s::ios::out | s::ios::binary | s::ios::trunc);
+  if (not out.is_open()){
+    s::cout << "could not open file " << filename << " to save" << s::endl;
+    return false;
+  }
+  write_binary(cms, out);
+  out.close();
+  if (out.fail()){
+    s::cout << "failed writing file " << filename << s::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename S>
+bool load_cms_file(S& cms, const s::string& filename){
+  s::ifstream in(filename.c_str(), s::ios::in | s::ios::binary);
+  if (not in.is_open()){
+    s::cout << "could not open input file " << filename << " to load" << s::endl;
+    return false;
+  }
+  return read_binary(cms, in, "file " + filename);
+}
+
+template <typename T, typename C, bool CU, typename H>
+bool save_binary(const RuntimeCountMinSketch<T, C, CU, H>& cms, const s::string& filename){
+  return save_cms_file(cms, filename);
+}
+template <typename T, typename C, bool CU, typename H>
+bool save_binary(const WindowedCountMinSketch<T, C, CU, H>& cms, const s::string& filename){
+  return save_cms_file(cms, filename);
+}
+template <typename T, typename C, bool CU, typename H>
+bool load_binary(RuntimeCountMinSketch<T, C, CU, H>& cms, const s::string& filename){
+  return load_cms_file(cms, filename);
+}
+template <typename T, typename C, bool CU, typename H>
+bool load_binary(WindowedCountMinSketch<T, C, CU, H>& cms, const s::string& filename){
+  return load_cms_file(cms, filename);
+}
+
+#endif//COUNT_MIN_SKETCH_FILE
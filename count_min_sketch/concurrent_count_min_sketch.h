@@ -0,0 +1,136 @@
+#ifndef COUNT_MIN_SKETCH_CONCURRENT
+#define COUNT_MIN_SKETCH_CONCURRENT
+
+#include <cassert>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <type_traits>
+
+#include "runtime_count_min_sketch.h"
+
+namespace s = std;
+
+/* Concurrent Count-Min Sketch
+ *
+ * the layout of RuntimeCountMinSketch with the counters held in atomics, so any number of
+ * threads may count and estimate at the same time without a lock. a count is a compare and
+ * swap per row, which is what saturation needs, and an estimate d relaxed loads. an estimate
+ * racing with counts of the same key may or may not include them; all counts done before a
+ * thread is joined are seen after the join.
+ *
+ * there is no conservative update: two threads reading the same minimum would both raise
+ * the counters to min + 1 and one count would be lost, so estimates would no longer be upper
+ * bounds. there is no shared total either, it would be the one cache line every count
+ * writes; total() sums the first row instead, exact until a counter of it saturates.
+ *
+ * per thread RuntimeCountMinSketches merge into a concurrent one, and snapshot() copies one
+ * out.
+ */
+
+template <typename T, typename C = uint32_t, typename H = ByteHash64<T>>
+class ConcurrentCountMinSketch {
+  static_assert(s::is_unsigned<C>::value && sizeof(C) <= sizeof(uint64_t), "counters are unsigned integers of at most 64 bits");
+  static_assert(s::atomic<C>::is_always_lock_free, "counters must be lock free atomics");
+
+  H mHash;
+  size_t mWidth;
+  size_t mDepth;
+  s::unique_ptr<s::atomic<C>[]> mCounters;
+
+  size_t ncounters() const { return mWidth * mDepth; }
+  void indexes(uint64_t h, size_t* idx) const {
+    DoubleHash g(h);
+    for (size_t r = 0; r < mDepth; ++r)
+      idx[r] = r * mWidth + g.next(mWidth);
+  }
+  //the new value of c
+  static C add(s::atomic<C>& c, uint64_t n){
+    C v = c.load(s::memory_order_relaxed), nv;
+    do {
+      if (v == s::numeric_limits<C>::max()) return v;
+      nv = cms_saturating_add(v, n);
+    } while (not c.compare_exchange_weak(v, nv, s::memory_order_relaxed));
+    return nv;
+  }
+public:
+  ConcurrentCountMinSketch(size_t width, size_t depth, H hash = H()):
+    mHash(hash), mWidth(s::max((size_t)1, width)), mDepth(s::min(CMS_MAX_DEPTH, s::max((size_t)1, depth))),
+    mCounters(new s::atomic<C>[mWidth * mDepth]) {
+    assert(depth <= CMS_MAX_DEPTH);
+    clear();
+  }
+  //(eps, delta) would otherwise convert to a width and depth of 0, from_error takes those
+  template <typename F, typename G, typename = typename s::enable_if<s::is_floating_point<F>::value || s::is_floating_point<G>::value>::type>
+  ConcurrentCountMinSketch(F, G, H = H()) = delete;
+  ConcurrentCountMinSketch(const ConcurrentCountMinSketch&) = delete;
+  ConcurrentCountMinSketch& operator=(const ConcurrentCountMinSketch&) = delete;
+  ~ConcurrentCountMinSketch() = default;
+
+  //error at most eps of the total count with probability 1 - delta
+  static ConcurrentCountMinSketch from_error(double eps, double delta, H hash = H()){
+    return ConcurrentCountMinSketch(cms_width(eps), cms_depth(delta), hash);
+  }
+
+  uint64_t count_hash(uint64_t h, uint64_t n = 1){
+    size_t idx[CMS_MAX_DEPTH];
+    indexes(h, idx);
+    C m = s::numeric_limits<C>::max();
+    for (size_t r = 0; r < mDepth; ++r)
+      m = s::min(m, add(mCounters[idx[r]], n));
+    return m;
+  }
+  uint64_t estimate_hash(uint64_t h) const {
+    size_t idx[CMS_MAX_DEPTH];
+    indexes(h, idx);
+    C m = s::numeric_limits<C>::max();
+    for (size_t r = 0; r < mDepth; ++r)
+      m = s::min(m, mCounters[idx[r]].load(s::memory_order_relaxed));
+    return m;
+  }
+
+  uint64_t count(const T& v, uint64_t n = 1){
+    return count_hash(mHash(v), n);
+  }
+  uint64_t estimate(const T& v) const {
+    return estimate_hash(mHash(v));
+  }
+
+  template <bool CU>
+  void merge(const RuntimeCountMinSketch<T, C, CU, H>& o){
+    assert(o.width() == mWidth && o.depth() == mDepth);
+    const C* c = o.data();
+    for (size_t i = 0; i < ncounters(); ++i)
+      if (c[i]) add(mCounters[i], c[i]);
+  }
+
+  uint64_t total() const {
+    uint64_t t = 0;
+    for (size_t i = 0; i < mWidth; ++i)
+      t += mCounters[i].load(s::memory_order_relaxed);
+    return t;
+  }
+  size_t width() const { return mWidth; }
+  size_t depth() const { return mDepth; }
+  size_t bytes() const { return ncounters() * sizeof(C); }
+  double error() const {
+    return std::exp(1.) * (double)total() / (double)mWidth;
+  }
+
+  //non-atomic copy; concurrent counts may or may not be in it
+  RuntimeCountMinSketch<T, C, false, H> snapshot() const {
+    s::vector<C> c(ncounters());
+    for (size_t i = 0; i < ncounters(); ++i)
+      c[i] = mCounters[i].load(s::memory_order_relaxed);
+    return RuntimeCountMinSketch<T, C, false, H>(c.data(), mWidth, mDepth, total(), mHash);
+  }
+
+  //not safe against concurrent counts
+  void clear(){
+    for (size_t i = 0; i < ncounters(); ++i)
+      mCounters[i].store(0, s::memory_order_relaxed);
+  }
+};
+
+#endif//COUNT_MIN_SKETCH_CONCURRENT
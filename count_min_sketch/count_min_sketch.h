@@ -1,7 +1,50 @@
+#ifndef COUNT_MIN_SKETCH
+#define COUNT_MIN_SKETCH
+
+#include <cmath>
 #include <cstring>
+#include <cstdint>
+#include <limits>
 #include <tuple>
 #include <algorithm>
 
+#include "../hash/byte_hash.h"
+
+namespace s = std;
+
+/* Count-Min Sketch (Cormode and Muthukrishnan)
+ *
+ * d rows of w counters, each row with its own hash; counting a key increments its counter
+ * in every row, its estimate is the smallest of them. an estimate is never below the true
+ * count and, with N the total of all counts, above it by more than e N / w with
+ * probability at most e^-d:
+ *
+ *   w = ceil(e / eps), d = ceil(ln(1 / delta))
+ *
+ * bounds the error to eps N with probability 1 - delta.
+ *
+ * conservative update (Estan and Varghese) only raises the counters of a key up to its new
+ * estimate, min + n, instead of adding n to all of them; estimates stay upper bounds and on
+ * skewed streams the error typically halves.
+ */
+
+//w = ceil(e / eps) counters per row for an additive error of eps N
+inline size_t cms_width(double eps){
+  return s::max((size_t)1, (size_t)std::ceil(std::exp(1.) / eps));
+}
+
+//d = ceil(ln(1 / delta)) rows for the error bound to hold with probability 1 - delta
+inline size_t cms_depth(double delta){
+  return s::max((size_t)1, (size_t)std::ceil(std::log(1. / delta)));
+}
+
+//c + n, stuck at the largest value of C
+template <typename C>
+inline C cms_saturating_add(C c, uint64_t n){
+  constexpr C MAX = s::numeric_limits<C>::max();
+  return n >= (uint64_t)(MAX - c) ? MAX : (C)(c + n);
+}
+
 template <typename T, size_t V, typename... Hs>
 class CountMinSketch {
   template <size_t Idx>
@@ -13,7 +56,15 @@ class CountMinSketch {
   }
 
   template <size_t Idx>
-  constexpr size_t estimate(const T& val){
+  constexpr void hash_raise(const T& val, size_t to){
+    size_t& c = mHashIndexes[std::get<Idx>(mHashes)(val) % V + Idx * V];
+    c = std::max(c, to);
+    if constexpr(Idx > 0)
+      hash_raise<Idx - 1>(val, to);
+  }
+
+  template <size_t Idx>
+  constexpr size_t estimate(const T& val) const {
     if constexpr(Idx > 0){
       size_t hash = std::get<Idx>(mHashes)(val);
       size_t isize = mHashIndexes[hash % V + Idx * V];
@@ -28,14 +79,19 @@ public:
   CountMinSketch(Hs... hashes): mHashes(hashes...) {}
 
   CountMinSketch(const CountMinSketch&) = default;
-  CountMinSketch& operator=(const CountMindSketch&) = default;
+  CountMinSketch& operator=(const CountMinSketch&) = default;
   ~CountMinSketch() = default;
 
   void count(const T& v){
     hash_count<sizeof...(Hs) - 1>(v);
   }
 
-  size_t min_estimate(const T& v){
+  //conservative update: counters below the new estimate are raised to it, the others stay
+  void conservative_count(const T& v){
+    hash_raise<sizeof...(Hs) - 1>(v, min_estimate(v) + 1);
+  }
+
+  size_t min_estimate(const T& v) const {
     return estimate<sizeof...(Hs) - 1>(v);
   }
 
@@ -46,3 +102,5 @@ private:
   std::tuple<Hs...> mHashes;
   size_t            mHashIndexes[V * sizeof...(Hs)];
 };
+
+#endif//COUNT_MIN_SKETCH
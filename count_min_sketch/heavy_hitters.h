@@ -0,0 +1,117 @@
+#ifndef COUNT_MIN_SKETCH_HEAVY_HITTERS
+#define COUNT_MIN_SKETCH_HEAVY_HITTERS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+
+#include "runtime_count_min_sketch.h"
+
+namespace s = std;
+
+/* Heavy Hitters
+ *
+ * the k keys with the highest estimates of a count-min sketch, kept as the stream is
+ * counted: a min heap of k (estimate, key) with the position of every key in it, so a count
+ * is the sketch update plus, for a key in the heap, one sift down, or for a key whose new
+ * estimate beats the smallest in the heap, replacing the root.
+ *
+ * estimates only grow, so a key that leaves the heap had the smallest estimate of it then;
+ * a key is in the heap after a count if its estimate is in the top k. the heap holds the
+ * estimate of each key at its last count, which is what top() reports, sorted highest first.
+ *
+ * S is a sketch whose count() returns the key's estimate after the update; the conservative
+ * RuntimeCountMinSketch by default as it overestimates the least. not thread safe: with a
+ * ConcurrentCountMinSketch the heap needs a lock of its own.
+ */
+
+template <typename T, typename S = RuntimeCountMinSketch<T, uint32_t, true>, typename KH = s::hash<T>>
+class HeavyHitters {
+  using Entry = s::pair<uint64_t, T>;
+
+  S mSketch;
+  size_t mK;
+  s::vector<Entry> mHeap;
+  s::unordered_map<T, size_t, KH> mPos;
+
+  void place(size_t i, Entry&& e){
+    mPos[e.second] = i;
+    mHeap[i] = s::move(e);
+  }
+  void sift_down(size_t i){
+    Entry e = s::move(mHeap[i]);
+    for (size_t c = 2 * i + 1; c < mHeap.size(); c = 2 * i + 1){
+      if (c + 1 < mHeap.size() && mHeap[c + 1].first < mHeap[c].first) ++c;
+      if (e.first <= mHeap[c].first) break;
+      place(i, s::move(mHeap[c]));
+      i = c;
+    }
+    place(i, s::move(e));
+  }
+  void sift_up(size_t i){
+    Entry e = s::move(mHeap[i]);
+    for (size_t p = (i - 1) / 2; i > 0 && mHeap[p].first > e.first; p = (i - 1) / 2){
+      place(i, s::move(mHeap[p]));
+      i = p;
+    }
+    place(i, s::move(e));
+  }
+public:
+  HeavyHitters(size_t k, S sketch):
+    mSketch(s::move(sketch)), mK(s::max((size_t)1, k)) {
+    mHeap.reserve(mK);
+    mPos.reserve(mK);
+  }
+
+  //returns the key's estimate after the update
+  uint64_t count(const T& v, uint64_t n = 1){
+    uint64_t est = mSketch.count(v, n);
+    auto it = mPos.find(v);
+    if (it != mPos.end()){
+      mHeap[it->second].first = est;
+      sift_down(it->second);
+    } else if (mHeap.size() < mK){
+      mHeap.emplace_back(est, v);
+      sift_up(mHeap.size() - 1);
+    } else if (est > mHeap[0].first){
+      mPos.erase(mHeap[0].second);
+      mHeap[0] = Entry(est, v);
+      sift_down(0);
+    }
+    return est;
+  }
+  uint64_t estimate(const T& v) const {
+    return mSketch.estimate(v);
+  }
+
+  //the tracked keys and their estimates, highest first
+  s::vector<s::pair<T, uint64_t>> top() const {
+    s::vector<s::pair<T, uint64_t>> ret;
+    ret.reserve(mHeap.size());
+    for (const Entry& e : mHeap)
+      ret.emplace_back(e.second, e.first);
+    s::sort(ret.begin(), ret.end(), [](const s::pair<T, uint64_t>& a, const s::pair<T, uint64_t>& b){
+      return a.second > b.second;
+    });
+    return ret;
+  }
+  //smallest estimate in the heap, a key counted higher than this enters it
+  uint64_t threshold() const {
+    return mHeap.size() < mK ? 0 : mHeap[0].first;
+  }
+
+  size_t k() const { return mK; }
+  const S& sketch() const { return mSketch; }
+
+  void clear(){
+    mSketch.clear();
+    mHeap.clear();
+    mPos.clear();
+  }
+};
+
+#endif//COUNT_MIN_SKETCH_HEAVY_HITTERS
@@ -0,0 +1,143 @@
+#ifndef COUNT_MIN_SKETCH_RUNTIME
+#define COUNT_MIN_SKETCH_RUNTIME
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "count_min_sketch.h"
+#include "../hash/double_hash.h"
+
+namespace s = std;
+
+/* Runtime Sized Count-Min Sketch
+ *
+ * a count-min sketch whose width w and depth d are constructor arguments, or follow from the
+ * error eps and failure probability delta as in count_min_sketch.h through from_error. d is at
+ * most CMS_MAX_DEPTH, i.e. delta at least e^-32. the d row indexes of a key come from one 64
+ * bit hash by double hashing, the rows are stored one after the other.
+ *
+ * C is the counter type, uint8_t, uint16_t, uint32_t or uint64_t: a narrower counter fits
+ * more of the sketch in cache for the same w and d. counters saturate at the largest value
+ * of C instead of wrapping, so estimates stay upper bounds, and an estimate at that value
+ * means "at least". CONSERVATIVE selects conservative update.
+ *
+ * count() returns the key's estimate after the update, which is what a heavy hitter tracker
+ * needs without a second lookup.
+ */
+
+constexpr size_t CMS_MAX_DEPTH = 32;
+
+template <typename T, typename C = uint32_t, bool CONSERVATIVE = false, typename H = ByteHash64<T>>
+class RuntimeCountMinSketch {
+  static_assert(s::is_unsigned<C>::value && sizeof(C) <= sizeof(uint64_t), "counters are unsigned integers of at most 64 bits");
+
+  H mHash;
+  size_t mWidth;
+  size_t mDepth;
+  uint64_t mTotal;
+  s::vector<C> mCounters; //row r at [r * w, (r + 1) * w)
+public:
+  RuntimeCountMinSketch(size_t width, size_t depth, H hash = H()):
+    mHash(hash), mWidth(s::max((size_t)1, width)), mDepth(s::min(CMS_MAX_DEPTH, s::max((size_t)1, depth))), mTotal(0),
+    mCounters(mWidth * mDepth) {
+    assert(depth <= CMS_MAX_DEPTH);
+  }
+  //(eps, delta) would otherwise convert to a width and depth of 0, from_error takes those
+  template <typename F, typename G, typename = typename s::enable_if<s::is_floating_point<F>::value || s::is_floating_point<G>::value>::type>
+  RuntimeCountMinSketch(F, G, H = H()) = delete;
+  //copy of w * d counters laid out row after row
+  RuntimeCountMinSketch(const C* counters, size_t width, size_t depth, uint64_t total, H hash = H()):
+    RuntimeCountMinSketch(width, depth, hash) {
+    s::copy(counters, counters + mWidth * mDepth, mCounters.begin());
+    mTotal = total;
+  }
+
+  //error at most eps of the total count with probability 1 - delta
+  static RuntimeCountMinSketch from_error(double eps, double delta, H hash = H()){
+    return RuntimeCountMinSketch(cms_width(eps), cms_depth(delta), hash);
+  }
+
+  uint64_t count_hash(uint64_t h, uint64_t n = 1){
+    size_t idx[CMS_MAX_DEPTH];
+    indexes(h, idx);
+    mTotal += n;
+    if (CONSERVATIVE){
+      C m = s::numeric_limits<C>::max();
+      for (size_t r = 0; r < mDepth; ++r)
+        m = s::min(m, mCounters[idx[r]]);
+      C to = cms_saturating_add(m, n);
+      for (size_t r = 0; r < mDepth; ++r)
+        mCounters[idx[r]] = s::max(mCounters[idx[r]], to);
+      return to;
+    } else {
+      C m = s::numeric_limits<C>::max();
+      for (size_t r = 0; r < mDepth; ++r){
+        C& c = mCounters[idx[r]];
+        c = cms_saturating_add(c, n);
+        m = s::min(m, c);
+      }
+      return m;
+    }
+  }
+  uint64_t estimate_hash(uint64_t h) const {
+    size_t idx[CMS_MAX_DEPTH];
+    indexes(h, idx);
+    return estimate_indexes(idx);
+  }
+
+  //the d counter indexes of a hash, the same in every sketch of this w and d
+  void indexes(uint64_t h, size_t* idx) const {
+    DoubleHash g(h);
+    for (size_t r = 0; r < mDepth; ++r)
+      idx[r] = r * mWidth + g.next(mWidth);
+  }
+  uint64_t estimate_indexes(const size_t* idx) const {
+    C m = s::numeric_limits<C>::max();
+    for (size_t r = 0; r < mDepth; ++r)
+      m = s::min(m, mCounters[idx[r]]);
+    return m;
+  }
+
+  uint64_t count(const T& v, uint64_t n = 1){
+    return count_hash(mHash(v), n);
+  }
+  uint64_t estimate(const T& v) const {
+    return estimate_hash(mHash(v));
+  }
+
+  //the counts of o added to this one, saturating; o must have the same w, d and hash. the
+  //result is a sketch of both streams whichever update either used
+  template <bool CU>
+  void merge(const RuntimeCountMinSketch<T, C, CU, H>& o){
+    assert(o.width() == mWidth && o.depth() == mDepth);
+    const C* c = o.data();
+    for (size_t i = 0; i < mCounters.size(); ++i)
+      mCounters[i] = cms_saturating_add(mCounters[i], c[i]);
+    mTotal += o.total();
+  }
+
+  //N, the sum of all counts
+  uint64_t total() const { return mTotal; }
+  size_t width() const { return mWidth; }
+  size_t depth() const { return mDepth; }
+  const H& hash() const { return mHash; }
+  size_t bytes() const { return mCounters.size() * sizeof(C); }
+  const C* data() const { return mCounters.data(); }
+  //e N / w, the error no estimate exceeds with probability 1 - e^-d
+  double error() const {
+    return std::exp(1.) * (double)mTotal / (double)mWidth;
+  }
+
+  void clear(){
+    s::fill(mCounters.begin(), mCounters.end(), 0);
+    mTotal = 0;
+  }
+};
+
+#endif//COUNT_MIN_SKETCH_RUNTIME
@@ -0,0 +1,165 @@
+#include <count_min_sketch.h>
+#include <runtime_count_min_sketch.h>
+#include <concurrent_count_min_sketch.h>
+#include <heavy_hitters.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <murmur.h>
+
+template <uint32_t SEED>
+struct SeededMurmur {
+  size_t operator()(const std::string& v) const noexcept {
+    return murmur3((const uint8_t*)v.c_str(), v.length(), SEED);
+  }
+};
+
+using Classic = CountMinSketch<std::string, 64, SeededMurmur<1>, SeededMurmur<2>, SeededMurmur<3>>;
+
+TEST(CountMinSketch, Classic){
+  Classic cms{SeededMurmur<1>(), SeededMurmur<2>(), SeededMurmur<3>()};
+  cms.clear();
+  for (size_t i = 0; i < 5; ++i) cms.count("death");
+  for (size_t i = 0; i < 3; ++i) cms.conservative_count("war");
+  const Classic& c = cms;
+  EXPECT_LE(5UL, c.min_estimate("death"));
+  EXPECT_LE(3UL, c.min_estimate("war"));
+  Classic copy = cms;
+  copy = cms;
+  EXPECT_EQ(c.min_estimate("death"), copy.min_estimate("death"));
+}
+
+//a zipf like stream: key i is counted N / (i + 1) times
+static std::vector<std::pair<uint64_t, uint64_t>> skewed(size_t keys, uint64_t n){
+  std::vector<std::pair<uint64_t, uint64_t>> ret;
+  for (uint64_t i = 0; i < keys; ++i) ret.emplace_back(i, std::max((uint64_t)1, n / (i + 1)));
+  return ret;
+}
+
+template <typename S>
+static double mean_error(S& cms, const std::vector<std::pair<uint64_t, uint64_t>>& stream){
+  for (auto& kv : stream) cms.count(kv.first, kv.second);
+  double err = 0.;
+  for (auto& kv : stream){
+    uint64_t e = cms.estimate(kv.first);
+    EXPECT_GE(e, kv.second);
+    err += (double)(e - kv.second);
+  }
+  return err / stream.size();
+}
+
+TEST(CountMinSketch, Runtime){
+  auto cms = RuntimeCountMinSketch<uint64_t>::from_error(0.001, 0.01);
+  EXPECT_EQ(2719UL, cms.width());
+  EXPECT_EQ(5UL, cms.depth());
+  EXPECT_EQ(2719UL * 5 * 4, cms.bytes());
+  EXPECT_EQ(3UL, cms.count(7, 3));
+  EXPECT_EQ(4UL, cms.count(7));
+  EXPECT_EQ(4UL, cms.estimate(7));
+  EXPECT_EQ(0UL, cms.estimate(8));
+  EXPECT_EQ(4UL, cms.total());
+  cms.clear();
+  EXPECT_EQ(0UL, cms.estimate(7));
+  EXPECT_EQ(0UL, cms.total());
+}
+
+TEST(CountMinSketch, Conservative){
+  auto stream = skewed(20000, 100000);
+  RuntimeCountMinSketch<uint64_t> standard(4096, 4);
+  RuntimeCountMinSketch<uint64_t, uint32_t, true> conservative(4096, 4);
+  double se = mean_error(standard, stream), ce = mean_error(conservative, stream);
+  EXPECT_EQ(standard.total(), conservative.total());
+  EXPECT_LT(se, standard.error());
+  EXPECT_LT(ce * 1.5, se);
+}
+
+TEST(CountMinSketch, Saturation){
+  RuntimeCountMinSketch<uint64_t, uint8_t> cms(64, 4);
+  EXPECT_EQ(256UL, cms.bytes());
+  EXPECT_EQ(200UL, cms.count(1, 200));
+  EXPECT_EQ(255UL, cms.count(1, 100));
+  EXPECT_EQ(255UL, cms.count(1));
+  EXPECT_EQ(255UL, cms.estimate(1));
+  RuntimeCountMinSketch<uint64_t, uint16_t, true> cu(64, 4);
+  EXPECT_EQ(65535UL, cu.count(1, 1000000));
+  EXPECT_EQ(65535UL, cu.estimate(1));
+}
+
+TEST(CountMinSketch, Merge){
+  auto stream = skewed(1000, 10000);
+  RuntimeCountMinSketch<uint64_t> a(512, 4), b(512, 4), all(512, 4);
+  RuntimeCountMinSketch<uint64_t, uint32_t, true> c(512, 4);
+  for (size_t i = 0; i < stream.size(); ++i){
+    if (i % 3 == 0)      a.count(stream[i].first, stream[i].second);
+    else if (i % 3 == 1) b.count(stream[i].first, stream[i].second);
+    else                 c.count(stream[i].first, stream[i].second);
+    all.count(stream[i].first, stream[i].second);
+  }
+  a.merge(b);
+  for (auto& kv : stream) ASSERT_GE(all.estimate(kv.first), kv.second);
+  a.merge(c);
+  EXPECT_EQ(all.total(), a.total());
+  for (auto& kv : stream) ASSERT_GE(a.estimate(kv.first), kv.second);
+}
+
+TEST(CountMinSketch, Concurrent){
+  constexpr size_t THREADS = 4, N = 20000;
+  ConcurrentCountMinSketch<uint64_t> cms(2048, 4);
+  RuntimeCountMinSketch<uint64_t> single(2048, 4);
+  std::vector<std::thread> ts;
+  for (size_t t = 0; t < THREADS; ++t)
+    ts.emplace_back([&cms]{
+      for (uint64_t i = 0; i < N; ++i) cms.count(i % 1000);
+    });
+  for (std::thread& t : ts) t.join();
+  for (size_t t = 0; t < THREADS; ++t)
+    for (uint64_t i = 0; i < N; ++i) single.count(i % 1000);
+  EXPECT_EQ(THREADS * N, cms.total());
+  for (uint64_t i = 0; i < 1000; ++i) ASSERT_EQ(single.estimate(i), cms.estimate(i));
+
+  RuntimeCountMinSketch<uint64_t> snap = cms.snapshot();
+  EXPECT_EQ(THREADS * N, snap.total());
+  cms.merge(snap);
+  for (uint64_t i = 0; i < 1000; ++i) ASSERT_EQ(2 * single.estimate(i), cms.estimate(i));
+
+  ConcurrentCountMinSketch<uint64_t, uint8_t> narrow(64, 2);
+  EXPECT_EQ(255UL, narrow.count(3, 1000));
+
+  auto sized = ConcurrentCountMinSketch<uint64_t>::from_error(0.001, 0.01);
+  EXPECT_EQ(2719UL, sized.width());
+  EXPECT_EQ(5UL, sized.depth());
+}
+
+TEST(CountMinSketch, HeavyHitters){
+  auto stream = skewed(5000, 10000);
+  HeavyHitters<uint64_t> hh(10, RuntimeCountMinSketch<uint64_t, uint32_t, true>::from_error(0.0005, 0.01));
+  //interleaved, one at a time
+  for (uint64_t round = 0; round < 10000; ++round)
+    for (auto& kv : stream){
+      if (round >= kv.second) break;
+      hh.count(kv.first);
+    }
+  auto top = hh.top();
+  ASSERT_EQ(10UL, top.size());
+  for (size_t i = 0; i < top.size(); ++i){
+    EXPECT_EQ(i, top[i].first);
+    EXPECT_GE(top[i].second, stream[i].second);
+  }
+  EXPECT_EQ(top.back().second, hh.threshold());
+  hh.clear();
+  EXPECT_TRUE(hh.top().empty());
+  EXPECT_EQ(0UL, hh.estimate(0));
+
+  using Words = RuntimeCountMinSketch<std::string, uint16_t, true>;
+  HeavyHitters<std::string, Words> words(2, Words(256, 3));
+  for (const char* w : {"a", "b", "a", "c", "a", "b", "d", "e", "b", "a"}) words.count(w);
+  auto wt = words.top();
+  ASSERT_EQ(2UL, wt.size());
+  EXPECT_EQ("a", wt[0].first);
+  EXPECT_EQ(4UL, wt[0].second);
+  EXPECT_EQ("b", wt[1].first);
+  EXPECT_EQ(3UL, wt[1].second);
+}
@@ -0,0 +1,169 @@
+#include <windowed_count_min_sketch.h>
+#include <cms_file.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <sstream>
+
+using Windowed = WindowedCountMinSketch<uint64_t>;
+
+TEST(WindowedCountMinSketch, Slide){
+  //60 ticks in 6 slots of 10
+  Windowed cms(1024UL, 4UL, 60, 6);
+  EXPECT_EQ(10UL, cms.span());
+  EXPECT_EQ(60UL, cms.window());
+  EXPECT_EQ(6UL * 1024 * 4 * 4, cms.bytes());
+  for (uint64_t t = 0; t < 60; ++t) cms.count(7, t);
+  EXPECT_EQ(60UL, cms.estimate(7, 59));
+  EXPECT_EQ(60UL, cms.total(59));
+  //each slot of 10 ticks drops out as time moves past it
+  EXPECT_EQ(50UL, cms.estimate(7, 60));
+  EXPECT_EQ(50UL, cms.estimate(7, 69));
+  EXPECT_EQ(40UL, cms.estimate(7, 70));
+  EXPECT_EQ(0UL, cms.estimate(7, 119));
+  EXPECT_EQ(0UL, cms.estimate(8, 59));
+  //a slot is reused for its new epoch
+  cms.count(7, 65, 3);
+  EXPECT_EQ(53UL, cms.estimate(7, 65));
+  EXPECT_EQ(3UL, cms.estimate(7, 115));
+  EXPECT_EQ(0UL, cms.estimate(7, 120));
+  cms.clear();
+  EXPECT_EQ(0UL, cms.estimate(7, 65));
+}
+
+TEST(WindowedCountMinSketch, Late){
+  Windowed cms(256UL, 3UL, 40, 4);
+  cms.count(1, 100);
+  //late but in the ring
+  cms.count(1, 75);
+  EXPECT_EQ(2UL, cms.estimate(1, 100));
+  //older than the ring: dropped
+  cms.count(1, 30);
+  EXPECT_EQ(2UL, cms.estimate(1, 100));
+  //not yet in the window at an earlier time
+  EXPECT_EQ(1UL, cms.estimate(1, 99));
+}
+
+TEST(WindowedCountMinSketch, Merge){
+  Windowed a(512UL, 4UL, 100, 10), b(512UL, 4UL, 100, 10), all(512UL, 4UL, 100, 10);
+  for (uint64_t t = 0; t < 300; ++t){
+    uint64_t k = t % 17;
+    if (t % 2) a.count(k, t);
+    else       b.count(k, t);
+    all.count(k, t);
+  }
+  //too old for b's ring, dropped
+  b.count(3, 150);
+  a.merge(b);
+  for (uint64_t k = 0; k < 17; ++k){
+    EXPECT_EQ(all.estimate(k, 299), a.estimate(k, 299));
+    EXPECT_GE(a.estimate(k, 299), 100 / 17UL);
+  }
+  EXPECT_EQ(all.total(299), a.total(299));
+}
+
+TEST(CountMinSketchFile, Runtime){
+  auto cms = RuntimeCountMinSketch<std::string, uint16_t, true>::from_error(0.01, 0.01);
+  for (size_t i = 0; i < 100; ++i) cms.count(std::to_string(i % 10), i);
+  std::stringstream ss;
+  ASSERT_TRUE(write_binary(cms, ss));
+  EXPECT_EQ(64 + cms.bytes(), ss.str().size());
+  RuntimeCountMinSketch<std::string, uint16_t> back(1, 1);
+  ASSERT_TRUE(read_binary(back, ss));
+  EXPECT_EQ(cms.width(), back.width());
+  EXPECT_EQ(cms.depth(), back.depth());
+  EXPECT_EQ(cms.total(), back.total());
+  for (size_t i = 0; i < 10; ++i) EXPECT_EQ(cms.estimate(std::to_string(i)), back.estimate(std::to_string(i)));
+
+  //wrong counter width, truncated, and not a sketch at all
+  RuntimeCountMinSketch<std::string, uint32_t> wide(1, 1);
+  std::stringstream w(ss.str());
+  EXPECT_FALSE(read_binary(wide, w));
+  std::stringstream t(ss.str().substr(0, 100));
+  EXPECT_FALSE(read_binary(back, t));
+  EXPECT_EQ(cms.total(), back.total());
+  std::stringstream junk(std::string(200, 'x'));
+  EXPECT_FALSE(read_binary(back, junk));
+}
+
+TEST(CountMinSketchFile, Windowed){
+  Windowed cms(128UL, 2UL, 30, 3);
+  for (uint64_t t = 0; t < 50; ++t) cms.count(t % 5, t, 2);
+  std::string filename = "test_windowed_count_min_sketch.bin";
+  ASSERT_TRUE(save_binary(cms, filename));
+  Windowed back(1UL, 1UL, 1, 1);
+  ASSERT_TRUE(load_binary(back, filename));
+  EXPECT_EQ(cms.window(), back.window());
+  EXPECT_EQ(cms.slots(), back.slots());
+  EXPECT_EQ(cms.total(49), back.total(49));
+  for (uint64_t k = 0; k < 5; ++k) EXPECT_EQ(cms.estimate(k, 49), back.estimate(k, 49));
+  //an aggregator merges what it read
+  back.merge(cms);
+  EXPECT_EQ(2 * cms.total(49), back.total(49));
+  //a windowed file is not a plain sketch
+  RuntimeCountMinSketch<uint64_t> plain(1, 1);
+  EXPECT_FALSE(load_binary(plain, filename));
+  EXPECT_FALSE(load_binary(back, "no_such_file.bin"));
+  std::remove(filename.c_str());
+}
+
+TEST(CountMinSketchFile, WindowedCorrupted){
+  Windowed cms(64, 2, 31, 3);
+  for (uint64_t t = 0; t < 40; ++t) cms.count(t % 5, t);
+  std::stringstream ss;
+  ASSERT_TRUE(write_binary(cms, ss));
+  std::string good = ss.str();
+  auto read_with = [&](uint64_t slots, uint64_t span){
+    std::string t = good;
+    memcpy(&t[offsetof(CountMinFileHeader, slots)], &slots, sizeof(slots));
+    memcpy(&t[offsetof(CountMinFileHeader, span)], &span, sizeof(span));
+    std::stringstream in(t);
+    Windowed back(1, 1, 1, 1);
+    bool ok = read_binary(back, in);
+    return ok && back.span() == span && back.slots() == slots;
+  };
+  EXPECT_TRUE(read_with(3, 11));
+  //too many slots, a span * slots that wraps, counters that do not fit in memory
+  EXPECT_FALSE(read_with(CMS_FILE_MAX_SLOTS + 1, 1));
+  EXPECT_FALSE(read_with(UINT64_MAX, 1));
+  EXPECT_FALSE(read_with(2, (uint64_t)1 << 63));
+  std::string t = good;
+  uint64_t width = SIZE_MAX / sizeof(uint32_t) / 2 / 2;
+  memcpy(&t[offsetof(CountMinFileHeader, width)], &width, sizeof(width));
+  std::stringstream in(t);
+  Windowed back(1, 1, 1, 1);
+  EXPECT_FALSE(read_binary(back, in));
+  EXPECT_EQ(1U, back.slots());
+}
+
+//a hash with state: the sketch a stream is read into keeps its own
+struct SeededHash {
+  uint32_t seed;
+  uint64_t operator()(const uint64_t& v) const {
+    return murmur3_x64_128((const uint8_t*)&v, sizeof(v), seed).h1;
+  }
+};
+
+TEST(CountMinSketchFile, ReadKeepsHash){
+  RuntimeCountMinSketch<uint64_t, uint32_t, false, SeededHash> cms(64, 3, SeededHash{9});
+  for (uint64_t k = 0; k < 20; ++k) cms.count(k, k + 1);
+  std::stringstream ss;
+  ASSERT_TRUE(write_binary(cms, ss));
+  RuntimeCountMinSketch<uint64_t, uint32_t, false, SeededHash> back(1, 1, SeededHash{9});
+  ASSERT_TRUE(read_binary(back, ss));
+  EXPECT_EQ(9U, back.hash().seed);
+  for (uint64_t k = 0; k < 20; ++k) EXPECT_EQ(cms.estimate(k), back.estimate(k));
+
+  WindowedCountMinSketch<uint64_t, uint32_t, false, SeededHash> win(64, 3, 30, 3, SeededHash{9});
+  for (uint64_t t = 0; t < 20; ++t) win.count(t % 4, t);
+  std::stringstream ws;
+  ASSERT_TRUE(write_binary(win, ws));
+  WindowedCountMinSketch<uint64_t, uint32_t, false, SeededHash> wback(1, 1, 1, 1, SeededHash{9});
+  ASSERT_TRUE(read_binary(wback, ws));
+  EXPECT_EQ(9U, wback.hash().seed);
+  for (uint64_t k = 0; k < 4; ++k) EXPECT_EQ(win.estimate(k, 19), wback.estimate(k, 19));
+  wback.count(1, 19);
+  EXPECT_EQ(win.estimate(1, 19) + 1, wback.estimate(1, 19));
+}
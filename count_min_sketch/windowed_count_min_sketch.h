@@ -0,0 +1,129 @@
+#ifndef COUNT_MIN_SKETCH_WINDOWED
+#define COUNT_MIN_SKETCH_WINDOWED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "runtime_count_min_sketch.h"
+
+namespace s = std;
+
+/* Sliding Window Count-Min Sketch
+ *
+ * counts over the last window ticks of time (seconds, milliseconds, whatever the caller's
+ * clock gives) instead of since the last clear(): a ring of B sub-sketches, each covering
+ * span = window / B ticks. a count at time t goes to the sub-sketch of epoch t / span, which
+ * is cleared first if it last held an older epoch; an estimate at time t adds up the
+ * estimates of the sub-sketches of epochs (t / span - B, t / span], whose counters sit at
+ * the same indexes so the key is hashed once. so the window covers between window - span
+ * and window ticks of history and slides a span at a time; more sub-sketches make it slide
+ * smoother at the cost of B lookups per estimate.
+ *
+ * the sum of the per sub-sketch minimums is an upper bound of the count in the window, and
+ * a tighter one than the minimum of a summed sketch would be.
+ *
+ * time may go back a little, a count lands in its own epoch while that is still in the
+ * ring; a count older than the ring is dropped.
+ *
+ * sketches of the same shape, per shard or per process, merge epoch by epoch: counters of
+ * the same epoch add, the newer epoch of a ring slot wins. see cms_file.h to write one out
+ * and read it back in an aggregator.
+ */
+
+template <typename T, typename C = uint32_t, bool CONSERVATIVE = false, typename H = ByteHash64<T>>
+class WindowedCountMinSketch {
+public:
+  using Sketch = RuntimeCountMinSketch<T, C, CONSERVATIVE, H>;
+private:
+  H mHash;
+  uint64_t mSpan;
+  s::vector<Sketch> mSlots;
+  s::vector<uint64_t> mEpochs; //epoch each slot holds, 0 with zero counters is empty
+
+  size_t slot_of(uint64_t epoch) const { return (size_t)(epoch % mSlots.size()); }
+  bool live(size_t i, uint64_t epoch) const {
+    return mEpochs[i] <= epoch && mEpochs[i] + mSlots.size() > epoch;
+  }
+public:
+  WindowedCountMinSketch(size_t width, size_t depth, uint64_t window, size_t slots, H hash = H()):
+    mHash(hash), mSpan(s::max((uint64_t)1, (window + s::max((size_t)1, slots) - 1) / s::max((size_t)1, slots))),
+    mSlots(s::max((size_t)1, slots), Sketch(width, depth, hash)), mEpochs(mSlots.size(), 0) {}
+
+  //a ring of slots sub-sketches of span ticks each, e.g. the shape read back from a file
+  static WindowedCountMinSketch from_span(size_t width, size_t depth, uint64_t span, size_t slots, H hash = H()){
+    WindowedCountMinSketch ret(width, depth, slots, slots, hash);
+    ret.mSpan = s::max((uint64_t)1, span);
+    return ret;
+  }
+
+  void count_hash(uint64_t h, uint64_t now, uint64_t n = 1){
+    uint64_t epoch = now / mSpan;
+    size_t i = slot_of(epoch);
+    if (mEpochs[i] < epoch){
+      mSlots[i].clear();
+      mEpochs[i] = epoch;
+    } else if (mEpochs[i] > epoch)
+      return;
+    mSlots[i].count_hash(h, n);
+  }
+  uint64_t estimate_hash(uint64_t h, uint64_t now) const {
+    size_t idx[CMS_MAX_DEPTH];
+    mSlots[0].indexes(h, idx);
+    uint64_t epoch = now / mSpan, e = 0;
+    for (size_t i = 0; i < mSlots.size(); ++i)
+      if (live(i, epoch)) e += mSlots[i].estimate_indexes(idx);
+    return e;
+  }
+
+  void count(const T& v, uint64_t now, uint64_t n = 1){
+    count_hash(mHash(v), now, n);
+  }
+  uint64_t estimate(const T& v, uint64_t now) const {
+    return estimate_hash(mHash(v), now);
+  }
+
+  //o must have the same window, slots, width, depth and hash
+  void merge(const WindowedCountMinSketch& o){
+    assert(o.mSpan == mSpan && o.mSlots.size() == mSlots.size());
+    for (size_t i = 0; i < mSlots.size(); ++i){
+      if (o.mEpochs[i] > mEpochs[i]){
+        mSlots[i] = o.mSlots[i];
+        mEpochs[i] = o.mEpochs[i];
+      } else if (o.mEpochs[i] == mEpochs[i])
+        mSlots[i].merge(o.mSlots[i]);
+    }
+  }
+
+  //sum of the counts in the window at time now
+  uint64_t total(uint64_t now) const {
+    uint64_t epoch = now / mSpan, t = 0;
+    for (size_t i = 0; i < mSlots.size(); ++i)
+      if (live(i, epoch)) t += mSlots[i].total();
+    return t;
+  }
+  uint64_t span() const { return mSpan; }
+  uint64_t window() const { return mSpan * mSlots.size(); }
+  size_t slots() const { return mSlots.size(); }
+  size_t width() const { return mSlots[0].width(); }
+  size_t depth() const { return mSlots[0].depth(); }
+  const H& hash() const { return mHash; }
+  size_t bytes() const { return mSlots.size() * mSlots[0].bytes(); }
+  const Sketch& slot(size_t i) const { return mSlots[i]; }
+  uint64_t epoch(size_t i) const { return mEpochs[i]; }
+  //replace slot i, e.g. when reading a sketch back; sk must have the same width and depth
+  void set_slot(size_t i, uint64_t epoch, const Sketch& sk){
+    assert(sk.width() == width() && sk.depth() == depth());
+    mSlots[i] = sk;
+    mEpochs[i] = epoch;
+  }
+
+  void clear(){
+    for (Sketch& sk : mSlots) sk.clear();
+    s::fill(mEpochs.begin(), mEpochs.end(), 0);
+  }
+};
+
+#endif//COUNT_MIN_SKETCH_WINDOWED
@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <random>
+
+#include <fft_plan.h>
+
+//fft_v1.h and fft_v2.h define the same names, give each its own namespace
+namespace v1 {
+#include <fft_v1.h>
+}
+namespace v2 {
+#include <fft_v2.h>
+}
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+using cmplx = s::complex<double>;
+
+static s::vector<cmplx> random_signal(size_t n){
+  s::mt19937 gen(n);
+  s::uniform_real_distribution<double> dist(-1., 1.);
+  s::vector<cmplx> a(n);
+  for (cmplx& c : a)
+    c = cmplx(dist(gen), dist(gen));
+  return a;
+}
+
+static void bm_fft_v1(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  for (auto _ : st){
+    s::vector<cmplx> y = v1::fft(a);
+    b::DoNotOptimize(y.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_v1)->RangeMultiplier(2)->Range(1 << 10, 1 << 22)->Unit(b::kMicrosecond);
+
+static void bm_fft_v2(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  for (auto _ : st){
+    s::vector<cmplx> y = v2::fft(a);
+    b::DoNotOptimize(y.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_v2)->RangeMultiplier(2)->Range(1 << 10, 1 << 22)->Unit(b::kMicrosecond);
+
+/* the plans are made once outside the loop and transforms run in place on the same buffer.
+ * forward and inverse alternate: forward transforms alone divide by n every time, after a few
+ * of them the values are denormal and every operation on them is many times slower */
+static void bm_fft_plan(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  FFTPlan<double> plan[2] = {FFTPlan<double>(st.range(0)), FFTPlan<double>(st.range(0), FFT_DIRECTION::INVERSE)};
+  size_t i = 0;
+  for (auto _ : st){
+    plan[i++ % 2].execute(a);
+    b::DoNotOptimize(a.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_plan)->RangeMultiplier(2)->Range(1 << 10, 1 << 22)->Unit(b::kMicrosecond);
+
+static void bm_fft_plan_split(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  s::vector<double> re, im;
+  for (cmplx c : a){
+    re.push_back(c.real());
+    im.push_back(c.imag());
+  }
+  FFTPlan<double> plan[2] = {FFTPlan<double>(st.range(0)), FFTPlan<double>(st.range(0), FFT_DIRECTION::INVERSE)};
+  size_t i = 0;
+  for (auto _ : st){
+    plan[i++ % 2].execute(re.data(), im.data());
+    b::DoNotOptimize(re.data());
+    b::DoNotOptimize(im.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_plan_split)->RangeMultiplier(2)->Range(1 << 10, 1 << 22)->Unit(b::kMicrosecond);
+
+static void bm_fft_plan_float(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  s::vector<s::complex<float>> y(a.begin(), a.end());
+  FFTPlan<float> plan[2] = {FFTPlan<float>(st.range(0)), FFTPlan<float>(st.range(0), FFT_DIRECTION::INVERSE)};
+  size_t i = 0;
+  for (auto _ : st){
+    plan[i++ % 2].execute(y);
+    b::DoNotOptimize(y.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_plan_float)->RangeMultiplier(2)->Range(1 << 10, 1 << 22)->Unit(b::kMicrosecond);
+
+//sizes other than powers of 2: mixed radix (1000, 3000, 5000, 6561, 100000), Bluestein (4099,
+//65537), against the next power of 2 they would otherwise be padded to
+static void bm_fft_plan_any(b::State& st){
+  s::vector<cmplx> a = random_signal(st.range(0));
+  FFTPlan<double> plan[2] = {FFTPlan<double>(st.range(0)), FFTPlan<double>(st.range(0), FFT_DIRECTION::INVERSE)};
+  s::vector<double> work(plan[0].work_size());
+  size_t i = 0;
+  for (auto _ : st){
+    plan[i++ % 2].execute(a.data(), work.data());
+    b::DoNotOptimize(a.data());
+  }
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK(bm_fft_plan_any)->Arg(1000)->Arg(1024)->Arg(3000)->Arg(4096)->Arg(4099)->Arg(5000)->Arg(6561)->Arg(8192)
+                          ->Arg(65537)->Arg(100000)->Arg(131072)->Unit(b::kMicrosecond);
@@ -0,0 +1,71 @@
+#include <vector>
+#include <complex>
+#include <random>
+
+#include <fft_batch.h>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+using cmplx = s::complex<float>;
+
+static s::vector<cmplx> random_signal(size_t n){
+  s::mt19937 gen(n);
+  s::uniform_real_distribution<float> dist(-1., 1.);
+  s::vector<cmplx> a(n);
+  for (cmplx& c : a)
+    c = cmplx(dist(gen), dist(gen));
+  return a;
+}
+
+/* 4096 signals of range(0) points on range(1) + 1 threads; forward and inverse alternate so
+ * the values do not shrink by n every time into denormals */
+static void bm_fft_batch(b::State& st){
+  size_t n = st.range(0), count = 4096;
+  default_pool().resize(st.range(1));
+  s::vector<cmplx> a = random_signal(n * count);
+  FFTPlan<float> plan[2] = {FFTPlan<float>(n), FFTPlan<float>(n, FFT_DIRECTION::INVERSE)};
+  size_t i = 0;
+  for (auto _ : st){
+    fft_batch(plan[i++ % 2], a.data(), count);
+    b::DoNotOptimize(a.data());
+  }
+  st.SetItemsProcessed(st.iterations() * n * count);
+  default_pool().resize(0);
+}
+BENCHMARK(bm_fft_batch)->ArgsProduct({{256, 1000, 1024}, {0, 1, 3, 7}})->UseRealTime()->Unit(b::kMillisecond);
+
+//the same signals one plan execute at a time on the calling thread
+static void bm_fft_batch_serial(b::State& st){
+  size_t n = st.range(0), count = 4096;
+  s::vector<cmplx> a = random_signal(n * count);
+  FFTPlan<float> plan[2] = {FFTPlan<float>(n), FFTPlan<float>(n, FFT_DIRECTION::INVERSE)};
+  s::vector<float> work(plan[0].work_size());
+  size_t i = 0;
+  for (auto _ : st){
+    for (size_t k = 0; k < count; ++k)
+      plan[i % 2].execute(&a[k * n], work.data());
+    ++i;
+    b::DoNotOptimize(a.data());
+  }
+  st.SetItemsProcessed(st.iterations() * n * count);
+}
+BENCHMARK(bm_fft_batch_serial)->Arg(256)->Arg(1000)->Arg(1024)->UseRealTime()->Unit(b::kMillisecond);
+
+//range(0) x range(0) image on range(1) + 1 threads
+static void bm_fft_2d(b::State& st){
+  size_t n = st.range(0);
+  default_pool().resize(st.range(1));
+  s::vector<cmplx> a = random_signal(n * n), work(n * n);
+  FFT2DPlan<float> plan[2] = {FFT2DPlan<float>(n, n), FFT2DPlan<float>(n, n, FFT_DIRECTION::INVERSE)};
+  size_t i = 0;
+  for (auto _ : st){
+    plan[i++ % 2].execute(a.data(), work.data());
+    b::DoNotOptimize(a.data());
+  }
+  st.SetItemsProcessed(st.iterations() * n * n);
+  default_pool().resize(0);
+}
+BENCHMARK(bm_fft_2d)->ArgsProduct({{512, 1080, 2048}, {0, 1, 3, 7}})->UseRealTime()->Unit(b::kMillisecond);
@@ -0,0 +1,100 @@
+#ifndef DFT_FFT_BATCH
+#define DFT_FFT_BATCH
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include <complex>
+
+#include "fft_plan.h"
+#include "../thread_pool/thread_pool.h"
+#include "../matrix/transpose.h"
+
+namespace s = std;
+
+/* Batched and 2D FFT
+ *
+ * fft_batch runs one plan over many signals in one call. the signals are independent, so
+ * contiguous ranges of them are handed to the threads of default_pool(); every range gets a
+ * single work buffer that is reused for all of its signals.
+ *
+ * FFT2DPlan transforms a rows x cols row major array: the rows are transformed as a batch,
+ * the array is transposed with the cache blocked transpose of matrix/transpose.h so the
+ * columns become contiguous rows, those are transformed as a batch and the result is
+ * transposed back. every transform reads and writes contiguous memory, which a column
+ * transform in place with a stride of cols would not.
+ *
+ * the threads are those of default_pool(), default_pool().resize(n) sets how many there are.
+ * the scaling follows the plans: the forward transforms divide by the size of every
+ * dimension, the inverse ones do not.
+ */
+
+//a range of signals is at least this many points, smaller ranges cost more to dispatch
+constexpr size_t FFT_BATCH_GRAIN = 1 << 14;
+
+//count signals of plan.size() points, signal k starts at data + k * dist
+template <typename T>
+void fft_batch(const FFTPlan<T>& plan, s::complex<T>* data, size_t count, size_t dist){
+  size_t n = plan.size();
+  assert(dist >= n);
+  size_t grain = s::max((size_t)1, FFT_BATCH_GRAIN / n);
+  default_pool().parallel_for(0, count, grain, [&](size_t b, size_t e){
+    s::vector<T> work(plan.work_size());
+    for (size_t k = b; k < e; ++k)
+      plan.execute(data + k * dist, work.data());
+  });
+}
+template <typename T>
+void fft_batch(const FFTPlan<T>& plan, s::complex<T>* data, size_t count){
+  fft_batch(plan, data, count, plan.size());
+}
+
+//split signals, signal k has its real parts at re + k * dist and imaginary parts at im + k * dist
+template <typename T>
+void fft_batch(const FFTPlan<T>& plan, T* re, T* im, size_t count, size_t dist){
+  size_t n = plan.size();
+  assert(dist >= n);
+  size_t grain = s::max((size_t)1, FFT_BATCH_GRAIN / n);
+  default_pool().parallel_for(0, count, grain, [&](size_t b, size_t e){
+    s::vector<T> work(plan.work_size());
+    for (size_t k = b; k < e; ++k)
+      plan.execute(re + k * dist, im + k * dist, work.data());
+  });
+}
+
+template <typename T>
+class FFT2DPlan {
+  using cmplx = s::complex<T>;
+
+  size_t mRows;
+  size_t mCols;
+  FFTPlan<T> mRowPlan; //cols points
+  FFTPlan<T> mColPlan; //rows points
+public:
+  FFT2DPlan(size_t rows, size_t cols, FFT_DIRECTION dir = FFT_DIRECTION::FORWARD):
+    mRows(rows), mCols(cols), mRowPlan(cols, dir), mColPlan(rows, dir) {}
+
+  size_t rows() const { return mRows; }
+  size_t cols() const { return mCols; }
+  FFT_DIRECTION direction() const { return mRowPlan.direction(); }
+
+  //data holds rows x cols values by row and is transformed in place; work holds as many
+  void execute(cmplx* data, cmplx* work) const {
+    fft_batch(mRowPlan, data, mRows);
+    //transpose_oop reads a column buffer: a row major rows x cols array is the column buffer
+    //of its cols x rows transpose
+    transpose_oop(data, work, mCols, mRows);
+    fft_batch(mColPlan, work, mCols);
+    transpose_oop(work, data, mRows, mCols);
+  }
+  void execute(cmplx* data) const {
+    s::vector<cmplx> work(mRows * mCols);
+    execute(data, work.data());
+  }
+  void execute(s::vector<cmplx>& data) const {
+    assert(data.size() == mRows * mCols);
+    execute(data.data());
+  }
+};
+
+#endif//DFT_FFT_BATCH
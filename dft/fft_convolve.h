@@ -0,0 +1,168 @@
+#ifndef DFT_FFT_CONVOLVE
+#define DFT_FFT_CONVOLVE
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include <complex>
+
+#include "fft_real.h"
+
+namespace s = std;
+
+/* FFT Convolution of Real Signals
+ *
+ * FFTConvolver filters a stream of real samples with a fixed FIR filter h of nh taps,
+ * y[t] = sum_k h[k] x[t - k], a block at a time through real FFTs of size n. the spectrum of
+ * the filter is computed once; every block of up to l = n - nh + 1 samples then costs one
+ * forward transform, n / 2 + 1 complex multiplications and one inverse transform.
+ *
+ *   OVERLAP::ADD:  each block is transformed alone, zero padded; the last nh - 1 outputs of
+ *                  its convolution spill into the next block and are added there
+ *   OVERLAP::SAVE: each block is transformed together with the nh - 1 samples before it; the
+ *                  first nh - 1 outputs are wrapped around and thrown away
+ *
+ * process() takes any number of samples and returns the same number of filtered samples
+ * without delay; the filter state carries over from call to call until reset().
+ *
+ * fft_convolve and fft_correlate are the one shot full length versions:
+ *   fft_convolve:  y[i] = sum_k x[i - k] h[k], nx + nh - 1 values
+ *   fft_correlate: y[i] = sum_k x[i + k - (nh - 1)] h[k], nx + nh - 1 values; y[i] is the
+ *                  correlation at lag i - (nh - 1)
+ */
+
+enum class OVERLAP : int {
+  ADD,
+  SAVE,
+};
+
+template <typename T>
+class FFTConvolver {
+  using cmplx = s::complex<T>;
+
+  size_t mTaps;
+  size_t mBlock;              //input samples per transform
+  OVERLAP mMethod;
+  RealFFTPlan<T> mPlan;
+  s::vector<cmplx> mH;        //spectrum of the filter, multiplied by n
+  s::vector<T> mBuf;          //n samples in the time domain
+  s::vector<cmplx> mSpec;     //n / 2 + 1 bins
+  s::vector<T> mState;        //nh - 1 samples: the pending tail for ADD, the past input for SAVE
+
+  static size_t default_size(size_t nh){
+    size_t n = 64;
+    while (n < 4 * nh) n <<= 1;
+    return n;
+  }
+
+  //mBuf holds the time domain input, it is replaced by its circular convolution with h
+  void filter(){
+    mPlan.forward(mBuf.data(), mSpec.data());
+    for (size_t k = 0; k < mSpec.size(); ++k)
+      mSpec[k] *= mH[k];
+    mPlan.inverse(mSpec.data(), mBuf.data());
+  }
+
+  void process_add(const T* in, T* out, size_t c){
+    size_t nt = mTaps - 1;
+    s::copy(in, in + c, mBuf.begin());
+    s::fill(mBuf.begin() + c, mBuf.end(), T());
+    filter();
+    for (size_t i = 0; i < c; ++i)
+      out[i] = mBuf[i] + (i < nt ? mState[i] : T());
+    for (size_t i = 0; i < nt; ++i)
+      mState[i] = mBuf[c + i] + (c + i < nt ? mState[c + i] : T());
+  }
+
+  void process_save(const T* in, T* out, size_t c){
+    size_t nt = mTaps - 1;
+    s::copy(mState.begin(), mState.end(), mBuf.begin());
+    s::copy(in, in + c, mBuf.begin() + nt);
+    s::fill(mBuf.begin() + nt + c, mBuf.end(), T());
+    //the input history for the next block are the last nh - 1 samples of this one
+    if (c >= nt) s::copy(in + c - nt, in + c, mState.begin());
+    else {
+      s::copy(mState.begin() + c, mState.end(), mState.begin());
+      s::copy(in, in + c, mState.end() - c);
+    }
+    filter();
+    s::copy(mBuf.begin() + nt, mBuf.begin() + nt + c, out);
+  }
+public:
+  //fft_size is the transform size n, a power of 2 of at least nh; 0 picks one about 4 times
+  //the filter length, which keeps the work per sample near its minimum
+  FFTConvolver(const T* h, size_t nh, OVERLAP method = OVERLAP::ADD, size_t fft_size = 0):
+    mTaps(nh), mBlock(0), mMethod(method), mPlan(fft_size ? fft_size : default_size(nh)) {
+    assert(nh > 0);
+    size_t n = mPlan.size();
+    assert(n >= nh);
+    mBlock = n - nh + 1;
+    mBuf.assign(n, T());
+    mSpec.resize(mPlan.bins());
+    mState.assign(nh - 1, T());
+
+    s::copy(h, h + nh, mBuf.begin());
+    mH.resize(mPlan.bins());
+    mPlan.forward(mBuf.data(), mH.data());
+    for (cmplx& c : mH)
+      c *= (T)n;
+  }
+  FFTConvolver(const s::vector<T>& h, OVERLAP method = OVERLAP::ADD, size_t fft_size = 0):
+    FFTConvolver(h.data(), h.size(), method, fft_size) {}
+
+  size_t taps() const { return mTaps; }
+  size_t fft_size() const { return mPlan.size(); }
+  size_t block_size() const { return mBlock; }
+  OVERLAP method() const { return mMethod; }
+
+  //filter n samples of the stream, in and out may be the same array
+  void process(const T* in, T* out, size_t n){
+    for (size_t i = 0; i < n; i += mBlock){
+      size_t c = s::min(mBlock, n - i);
+      if (mMethod == OVERLAP::ADD) process_add(in + i, out + i, c);
+      else                         process_save(in + i, out + i, c);
+    }
+  }
+  void process(s::vector<T>& data){
+    process(data.data(), data.data(), data.size());
+  }
+
+  //forget the stream so far, as if every past sample was 0
+  void reset(){
+    s::fill(mState.begin(), mState.end(), T());
+  }
+};
+
+//y receives nx + nh - 1 values
+template <typename T>
+void fft_convolve(const T* x, size_t nx, const T* h, size_t nh, T* y){
+  FFTConvolver<T> conv(h, nh);
+  conv.process(x, y, nx);
+  //the last nh - 1 outputs are the response to the zeros after the signal
+  s::fill(y + nx, y + nx + nh - 1, T());
+  conv.process(y + nx, y + nx, nh - 1);
+}
+template <typename T>
+s::vector<T> fft_convolve(const s::vector<T>& x, const s::vector<T>& h){
+  if (x.empty() || h.empty()) return s::vector<T>();
+  s::vector<T> y(x.size() + h.size() - 1);
+  fft_convolve(x.data(), x.size(), h.data(), h.size(), y.data());
+  return y;
+}
+
+//correlation is convolution with the reversed template
+template <typename T>
+void fft_correlate(const T* x, size_t nx, const T* h, size_t nh, T* y){
+  s::vector<T> rh(h, h + nh);
+  s::reverse(rh.begin(), rh.end());
+  fft_convolve(x, nx, rh.data(), nh, y);
+}
+template <typename T>
+s::vector<T> fft_correlate(const s::vector<T>& x, const s::vector<T>& h){
+  if (x.empty() || h.empty()) return s::vector<T>();
+  s::vector<T> y(x.size() + h.size() - 1);
+  fft_correlate(x.data(), x.size(), h.data(), h.size(), y.data());
+  return y;
+}
+
+#endif//DFT_FFT_CONVOLVE
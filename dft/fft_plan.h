@@ -0,0 +1,515 @@
+#ifndef DFT_FFT_PLAN
+#define DFT_FFT_PLAN
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <complex>
+
+namespace s = std;
+
+/* FFT Plan
+ *
+ * everything about a transform that depends only on its size and direction is computed once
+ * when the plan is made: the bit reversal permutation and the twiddle factors of every stage.
+ * executing the plan is an in-place iterative transform that never allocates and never calls
+ * cos or sin, so a plan is made once per size and reused for every signal of that size.
+ *
+ * any n > 0 is supported, the plan picks the algorithm from the factors of n:
+ *
+ *   power of 2: radix-4 decimation in time, in place. after the bit reversal every two
+ *               consecutive radix-2 stages are fused into one radix-4 stage (with a single
+ *               radix-2 stage first when log2 n is odd). that halves the passes over the data
+ *               and turns a quarter of the twiddle multiplications into a swap of the real and
+ *               imaginary parts.
+ *   2, 3, 5, 7: mixed radix Stockham autosort, one pass per factor with a radix 8, 4, 2, 3,
+ *               5 or 7 butterfly. every pass goes from one buffer to the other, so the output
+ *               comes out in order without a digit reversal. the passes work on split real and
+ *               imaginary arrays with contiguous inner loops the compiler vectorizes.
+ *   otherwise:  Bluestein's chirp-z algorithm: with jk = (j^2 + k^2 - (k - j)^2) / 2 the
+ *               transform becomes a convolution with a chirp, done with mixed radix FFTs of
+ *               the smallest size m >= 2n - 1 with no prime factor above 7. the spectrum of
+ *               the chirp is computed with the plan.
+ *
+ * the last two need a work buffer of work_size() elements of T; execute() allocates one per
+ * call unless it is given one, which is the way to reuse a plan without allocating.
+ *
+ * data is either interleaved, an array of complex<T>, or split into an array of real parts and
+ * an array of imaginary parts. the scaling follows fft and ifft: the forward transform divides
+ * by n, the inverse does not.
+ */
+
+enum class FFT_DIRECTION : int {
+  FORWARD,
+  INVERSE,
+};
+
+template <typename T>
+class FFTPlan {
+  using cmplx = s::complex<T>;
+
+  enum class ALGORITHM : int {
+    RADIX4,
+    MIXED,
+    BLUESTEIN,
+  };
+
+  size_t mN;
+  size_t mLog;
+  FFT_DIRECTION mDir;
+  ALGORITHM mAlgo;
+  s::vector<uint32_t> mRev;     //RADIX4: mRev[i] is i with its log2 n bits reversed
+  s::vector<T> mTwRe;           //RADIX4: twiddles of the stages one after another; the stage
+  s::vector<T> mTwIm;           //combining blocks of m holds w^j, w^2j, w^3j for j < m, w = e^(-+2pi i / 4m)
+                                //MIXED: the radix p pass over length l holds w^jt at (t - 1) * l / p + j
+                                //for 0 < t < p and j < l / p, w = e^(-+2pi i / l)
+  s::vector<size_t> mFactors;   //MIXED: radix of every pass
+  s::vector<cmplx> mChirp;      //BLUESTEIN: e^(-+pi i j^2 / n)
+  s::vector<cmplx> mChirpSpec;  //BLUESTEIN: unscaled transform of the conjugate chirp, size m
+  s::vector<FFTPlan> mBlue;     //BLUESTEIN: forward and inverse plans of size m
+
+  //the stages start with blocks of m = 1, or m = 2 after a radix-2 stage when log2 n is odd
+  size_t first_m() const {
+    return mLog % 2 ? 2 : 1;
+  }
+
+  void make_radix4(){
+    mRev.resize(mN);
+    for (size_t i = 0; i < mN; ++i){
+      size_t r = 0;
+      for (size_t b = 0; b < mLog; ++b)
+        r |= ((i >> b) & 1) << (mLog - 1 - b);
+      mRev[i] = r;
+    }
+
+    double sign = mDir == FFT_DIRECTION::FORWARD ? -1. : 1.;
+    for (size_t m = first_m(); m * 4 <= mN; m *= 4)
+      for (size_t p = 1; p <= 3; ++p)
+        for (size_t j = 0; j < m; ++j){
+          double a = sign * 2. * M_PI * (double)(p * j) / (double)(4 * m);
+          mTwRe.push_back((T)cos(a));
+          mTwIm.push_back((T)sin(a));
+        }
+  }
+
+  //factors of n into 8, 4, 2, 3, 5 and 7; false if anything else is left. a radix 8 pass does
+  //the work of three radix-2 passes in one sweep over the data
+  bool factor(){
+    size_t n = mN;
+    while (n % 8 == 0){ mFactors.push_back(8); n /= 8; }
+    while (n % 4 == 0){ mFactors.push_back(4); n /= 4; }
+    for (size_t p : {2, 3, 5, 7})
+      while (n % p == 0){ mFactors.push_back(p); n /= p; }
+    if (n == 1) return true;
+    mFactors.clear();
+    return false;
+  }
+
+  void make_mixed(){
+    double sign = mDir == FFT_DIRECTION::FORWARD ? -1. : 1.;
+    size_t len = mN;
+    for (size_t p : mFactors){
+      size_t m = len / p;
+      for (size_t t = 1; t < p; ++t)
+        for (size_t j = 0; j < m; ++j){
+          double a = sign * 2. * M_PI * (double)((j * t) % len) / (double)len;
+          mTwRe.push_back((T)cos(a));
+          mTwIm.push_back((T)sin(a));
+        }
+      len = m;
+    }
+  }
+
+  //smallest m >= n with no prime factor above 7, a size the mixed radix passes handle
+  static size_t smooth_size(size_t n){
+    for (size_t m = n;; ++m){
+      size_t k = m;
+      for (size_t p : {2, 3, 5, 7})
+        while (k % p == 0) k /= p;
+      if (k == 1) return m;
+    }
+  }
+
+  void make_bluestein(){
+    size_t m = smooth_size(2 * mN - 1);
+    mBlue.emplace_back(m, FFT_DIRECTION::FORWARD);
+    mBlue.emplace_back(m, FFT_DIRECTION::INVERSE);
+
+    //j^2 is taken mod 2n, where the chirp repeats, to keep the angle accurate
+    double sign = mDir == FFT_DIRECTION::FORWARD ? -1. : 1.;
+    for (size_t j = 0; j < mN; ++j){
+      double a = sign * M_PI * (double)((j * j) % (2 * mN)) / (double)mN;
+      mChirp.push_back(cmplx((T)cos(a), (T)sin(a)));
+    }
+    //the convolution is circular over m, negative offsets wrap around to the end
+    mChirpSpec.assign(m, cmplx());
+    for (size_t j = 0; j < mN; ++j){
+      mChirpSpec[j] = s::conj(mChirp[j]);
+      if (j > 0) mChirpSpec[m - j] = s::conj(mChirp[j]);
+    }
+    mBlue[0].execute(mChirpSpec.data());
+    for (cmplx& c : mChirpSpec)
+      c *= (T)m;
+  }
+
+  //multiply (r, i) by -i forward, by i inverse, the sign of the imaginary part of the roots of
+  //unity
+  template <bool FWD>
+  static void rot(T& r, T& i){
+    T t = r;
+    if (FWD){ r = i; i = -t; }
+    else    { r = -i; i = t; }
+  }
+
+  //in place DFT of the P values in ar / ai
+  template <size_t P, bool FWD>
+  __attribute__((always_inline))
+  static void butterfly(T* ar, T* ai){
+    if constexpr (P == 2){
+      T tr = ar[1], ti = ai[1];
+      ar[1] = ar[0] - tr; ai[1] = ai[0] - ti;
+      ar[0] = ar[0] + tr; ai[0] = ai[0] + ti;
+    } else if constexpr (P == 3){
+      const T s3 = (T)0.866025403784438646764; //sin(2pi / 3)
+      T t1r = ar[1] + ar[2], t1i = ai[1] + ai[2];
+      T t2r = ar[0] - t1r * (T)0.5, t2i = ai[0] - t1i * (T)0.5;
+      T t3r = (ar[1] - ar[2]) * s3, t3i = (ai[1] - ai[2]) * s3;
+      rot<FWD>(t3r, t3i);
+      ar[0] = ar[0] + t1r; ai[0] = ai[0] + t1i;
+      ar[1] = t2r + t3r;   ai[1] = t2i + t3i;
+      ar[2] = t2r - t3r;   ai[2] = t2i - t3i;
+    } else if constexpr (P == 4){
+      T s0r = ar[0] + ar[2], s0i = ai[0] + ai[2], d0r = ar[0] - ar[2], d0i = ai[0] - ai[2];
+      T s1r = ar[1] + ar[3], s1i = ai[1] + ai[3], d1r = ar[1] - ar[3], d1i = ai[1] - ai[3];
+      rot<FWD>(d1r, d1i);
+      ar[0] = s0r + s1r; ai[0] = s0i + s1i;
+      ar[1] = d0r + d1r; ai[1] = d0i + d1i;
+      ar[2] = s0r - s1r; ai[2] = s0i - s1i;
+      ar[3] = d0r - d1r; ai[3] = d0i - d1i;
+    } else if constexpr (P == 8){
+      //two radix-4 butterflies over the even and the odd inputs, joined by w8^k
+      const T h = (T)0.707106781186547524401; //sqrt(2) / 2
+      T er[4] = {ar[0], ar[2], ar[4], ar[6]}, ei[4] = {ai[0], ai[2], ai[4], ai[6]};
+      T odr[4] = {ar[1], ar[3], ar[5], ar[7]}, odi[4] = {ai[1], ai[3], ai[5], ai[7]};
+      butterfly<4, FWD>(er, ei);
+      butterfly<4, FWD>(odr, odi);
+      //w8 is (1 -+ i) / sqrt 2, w8^2 is -+i and w8^3 = w8 w8^2
+      T o1r = FWD ? (odr[1] + odi[1]) * h : (odr[1] - odi[1]) * h;
+      T o1i = FWD ? (odi[1] - odr[1]) * h : (odi[1] + odr[1]) * h;
+      T o2r = odr[2], o2i = odi[2];
+      rot<FWD>(o2r, o2i);
+      T o3r = FWD ? (odr[3] + odi[3]) * h : (odr[3] - odi[3]) * h;
+      T o3i = FWD ? (odi[3] - odr[3]) * h : (odi[3] + odr[3]) * h;
+      rot<FWD>(o3r, o3i);
+      ar[0] = er[0] + odr[0]; ai[0] = ei[0] + odi[0]; ar[4] = er[0] - odr[0]; ai[4] = ei[0] - odi[0];
+      ar[1] = er[1] + o1r;    ai[1] = ei[1] + o1i;    ar[5] = er[1] - o1r;    ai[5] = ei[1] - o1i;
+      ar[2] = er[2] + o2r;    ai[2] = ei[2] + o2i;    ar[6] = er[2] - o2r;    ai[6] = ei[2] - o2i;
+      ar[3] = er[3] + o3r;    ai[3] = ei[3] + o3i;    ar[7] = er[3] - o3r;    ai[7] = ei[3] - o3i;
+    } else if constexpr (P == 5){
+      const T c1 = (T)0.309016994374947424102, c2 = (T)-0.809016994374947424102; //cos(2pi k / 5)
+      const T s1 = (T)0.951056516295153572116, s2 = (T)0.587785252292473129169;  //sin(2pi k / 5)
+      T t1r = ar[1] + ar[4], t1i = ai[1] + ai[4], t2r = ar[2] + ar[3], t2i = ai[2] + ai[3];
+      T u1r = ar[1] - ar[4], u1i = ai[1] - ai[4], u2r = ar[2] - ar[3], u2i = ai[2] - ai[3];
+      T e1r = ar[0] + t1r * c1 + t2r * c2, e1i = ai[0] + t1i * c1 + t2i * c2;
+      T e2r = ar[0] + t1r * c2 + t2r * c1, e2i = ai[0] + t1i * c2 + t2i * c1;
+      T o1r = u1r * s1 + u2r * s2, o1i = u1i * s1 + u2i * s2;
+      T o2r = u1r * s2 - u2r * s1, o2i = u1i * s2 - u2i * s1;
+      rot<FWD>(o1r, o1i);
+      rot<FWD>(o2r, o2i);
+      ar[0] = ar[0] + t1r + t2r; ai[0] = ai[0] + t1i + t2i;
+      ar[1] = e1r + o1r; ai[1] = e1i + o1i; ar[4] = e1r - o1r; ai[4] = e1i - o1i;
+      ar[2] = e2r + o2r; ai[2] = e2i + o2i; ar[3] = e2r - o2r; ai[3] = e2i - o2i;
+    } else if constexpr (P == 7){
+      const T c1 = (T)0.623489801858733530525, c2 = (T)-0.222520933956314404289, c3 = (T)-0.900968867902419126236;
+      const T s1 = (T)0.781831482468029808708, s2 = (T)0.974927912181823607018,  s3 = (T)0.433883739117558120475;
+      T t1r = ar[1] + ar[6], t1i = ai[1] + ai[6], t2r = ar[2] + ar[5], t2i = ai[2] + ai[5], t3r = ar[3] + ar[4], t3i = ai[3] + ai[4];
+      T u1r = ar[1] - ar[6], u1i = ai[1] - ai[6], u2r = ar[2] - ar[5], u2i = ai[2] - ai[5], u3r = ar[3] - ar[4], u3i = ai[3] - ai[4];
+      T e1r = ar[0] + t1r * c1 + t2r * c2 + t3r * c3, e1i = ai[0] + t1i * c1 + t2i * c2 + t3i * c3;
+      T e2r = ar[0] + t1r * c2 + t2r * c3 + t3r * c1, e2i = ai[0] + t1i * c2 + t2i * c3 + t3i * c1;
+      T e3r = ar[0] + t1r * c3 + t2r * c1 + t3r * c2, e3i = ai[0] + t1i * c3 + t2i * c1 + t3i * c2;
+      T o1r = u1r * s1 + u2r * s2 + u3r * s3, o1i = u1i * s1 + u2i * s2 + u3i * s3;
+      T o2r = u1r * s2 - u2r * s3 - u3r * s1, o2i = u1i * s2 - u2i * s3 - u3i * s1;
+      T o3r = u1r * s3 - u2r * s1 + u3r * s2, o3i = u1i * s3 - u2i * s1 + u3i * s2;
+      rot<FWD>(o1r, o1i);
+      rot<FWD>(o2r, o2i);
+      rot<FWD>(o3r, o3i);
+      ar[0] = ar[0] + t1r + t2r + t3r; ai[0] = ai[0] + t1i + t2i + t3i;
+      ar[1] = e1r + o1r; ai[1] = e1i + o1i; ar[6] = e1r - o1r; ai[6] = e1i - o1i;
+      ar[2] = e2r + o2r; ai[2] = e2i + o2i; ar[5] = e2r - o2r; ai[5] = e2i - o2i;
+      ar[3] = e3r + o3r; ai[3] = e3i + o3i; ar[4] = e3r - o3r; ai[4] = e3i - o3i;
+    }
+  }
+
+  /* the butterflies of one Stockham pass of radix P over sequences of length l = P * m, st of
+   * them interleaved, for j < m and q < st:
+   *   y[q + st (P j + t)] = w^jt DFT_P(x[q + st (j + r m)] for r < P)[t]
+   * elements of x are SI apart and of y SO apart, 1 for split buffers and 2 for interleaved.
+   * the twiddle row of t is tr / ti + (t - 1) m, the last pass (m = 1) has none and scales.
+   *
+   * while st is at least STOCKHAM_VEC the loop over q is innermost: every load and store is
+   * contiguous and the twiddles are constant, so the compiler vectorizes it. the first passes
+   * have small st and loop over j innermost instead, reading each of the P inputs contiguously
+   * and the twiddle rows in order */
+  static constexpr size_t STOCKHAM_VEC = 4;
+
+  //the butterfly of one (j, q): inputs at x + r xs, outputs at y + t ys, twiddles of t at
+  //tr[(t - 1) m + j]; inlined into both loop orders so the arrays become registers
+  template <size_t P, bool FWD, bool LAST>
+  __attribute__((always_inline))
+  static void stockham_bfly(const T* __restrict__ xr, const T* __restrict__ xi, size_t xs,
+                            T* __restrict__ yr, T* __restrict__ yi, size_t ys,
+                            const T* __restrict__ tr, const T* __restrict__ ti, size_t m, size_t j, T scale){
+    T ar[P], ai[P];
+#pragma GCC unroll 8
+    for (size_t r = 0; r < P; ++r){
+      ar[r] = xr[r * xs];
+      ai[r] = xi[r * xs];
+    }
+    butterfly<P, FWD>(ar, ai);
+    if (LAST){
+#pragma GCC unroll 8
+      for (size_t t = 0; t < P; ++t){
+        yr[t * ys] = ar[t] * scale;
+        yi[t * ys] = ai[t] * scale;
+      }
+    } else {
+      yr[0] = ar[0];
+      yi[0] = ai[0];
+#pragma GCC unroll 8
+      for (size_t t = 1; t < P; ++t){
+        T wr = tr[(t - 1) * m + j], wi = ti[(t - 1) * m + j];
+        yr[t * ys] = ar[t] * wr - ai[t] * wi;
+        yi[t * ys] = ar[t] * wi + ai[t] * wr;
+      }
+    }
+  }
+
+  template <size_t P, bool FWD, size_t SI, size_t SO, bool LAST>
+  static void stockham(const T* __restrict__ xr, const T* __restrict__ xi, T* __restrict__ yr, T* __restrict__ yi,
+                       size_t m, size_t st, const T* __restrict__ tr, const T* __restrict__ ti, T scale){
+    size_t xs = SI * st * m, ys = SO * st;
+    if (st >= STOCKHAM_VEC)
+      for (size_t j = 0; j < m; ++j){
+        const T *x0r = xr + SI * st * j, *x0i = xi + SI * st * j;
+        T *y0r = yr + SO * st * P * j, *y0i = yi + SO * st * P * j;
+#pragma GCC ivdep
+        for (size_t q = 0; q < st; ++q)
+          stockham_bfly<P, FWD, LAST>(x0r + SI * q, x0i + SI * q, xs, y0r + SO * q, y0i + SO * q, ys, tr, ti, m, j, scale);
+      }
+    else
+      for (size_t q = 0; q < st; ++q)
+#pragma GCC ivdep
+        for (size_t j = 0; j < m; ++j)
+          stockham_bfly<P, FWD, LAST>(xr + SI * (q + st * j), xi + SI * (q + st * j), xs,
+                                      yr + SO * (q + st * P * j), yi + SO * (q + st * P * j), ys, tr, ti, m, j, scale);
+  }
+
+  template <bool FWD, size_t SI, size_t SO, bool LAST>
+  static void stockham_radix(size_t p, const T* xr, const T* xi, T* yr, T* yi, size_t m, size_t st,
+                             const T* tr, const T* ti, T scale){
+    switch (p){
+    case 2: stockham<2, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    case 3: stockham<3, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    case 4: stockham<4, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    case 5: stockham<5, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    case 7: stockham<7, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    case 8: stockham<8, FWD, SI, SO, LAST>(xr, xi, yr, yi, m, st, tr, ti, scale); break;
+    }
+  }
+
+  /* work holds 2n values, a split buffer a. the first pass reads the data and writes a, the
+   * passes in between alternate between a and the data's own memory used as a split buffer b,
+   * and the last pass writes the data in its own layout with the forward scaling folded in.
+   * the last pass has to read a for that; if it would read b it writes a and a copy follows */
+  template <size_t S, bool FWD>
+  void run_mixed(T* re, T* im, T* work) const {
+    size_t np = mFactors.size();
+    T scale = FWD ? (T)1 / (T)mN : (T)1;
+    T *ar = work, *ai = work + mN;
+    T *br = re, *bi = S == 2 ? re + mN : im;
+    const T* tr = mTwRe.data();
+    const T* ti = mTwIm.data();
+    size_t len = mN, st = 1;
+
+    //pass i < np - 1 writes a when i is even and b when i is odd
+    for (size_t i = 0; i + 1 < np; ++i){
+      size_t p = mFactors[i], m = len / p;
+      if (i == 0)       stockham_radix<FWD, S, 1, false>(p, re, im, ar, ai, m, st, tr, ti, scale);
+      else if (i % 2)   stockham_radix<FWD, 1, 1, false>(p, ar, ai, br, bi, m, st, tr, ti, scale);
+      else              stockham_radix<FWD, 1, 1, false>(p, br, bi, ar, ai, m, st, tr, ti, scale);
+      tr += (p - 1) * m;
+      ti += (p - 1) * m;
+      len = m;
+      st *= p;
+    }
+
+    size_t p = mFactors[np - 1];
+    if (np == 1){
+      stockham_radix<FWD, S, 1, true>(p, re, im, ar, ai, 1, st, tr, ti, scale);
+    } else if (np % 2 == 0){
+      stockham_radix<FWD, 1, S, true>(p, ar, ai, re, im, 1, st, tr, ti, scale);
+      return;
+    } else
+      stockham_radix<FWD, 1, 1, true>(p, br, bi, ar, ai, 1, st, tr, ti, scale);
+    for (size_t i = 0; i < mN; ++i){
+      re[i * S] = ar[i];
+      im[i * S] = ai[i];
+    }
+  }
+
+  //work holds 2m values, interleaved
+  template <size_t S, bool FWD>
+  void run_bluestein(T* re, T* im, T* work) const {
+    size_t m = mBlue[0].size();
+    cmplx* a = reinterpret_cast<cmplx*>(work);
+    for (size_t j = 0; j < mN; ++j){
+      const cmplx& w = mChirp[j];
+      a[j] = cmplx(re[j * S] * w.real() - im[j * S] * w.imag(), re[j * S] * w.imag() + im[j * S] * w.real());
+    }
+    s::fill(a + mN, a + m, cmplx());
+
+    //the forward transform divides by m and the inverse does not, with the unscaled chirp
+    //spectrum that leaves the circular convolution itself
+    mBlue[0].execute(a, work + 2 * m);
+    for (size_t k = 0; k < m; ++k){
+      const cmplx& b = mChirpSpec[k];
+      a[k] = cmplx(a[k].real() * b.real() - a[k].imag() * b.imag(), a[k].real() * b.imag() + a[k].imag() * b.real());
+    }
+    mBlue[1].execute(a, work + 2 * m);
+
+    T scale = FWD ? (T)1 / (T)mN : (T)1;
+    for (size_t k = 0; k < mN; ++k){
+      const cmplx& w = mChirp[k];
+      re[k * S] = (a[k].real() * w.real() - a[k].imag() * w.imag()) * scale;
+      im[k * S] = (a[k].real() * w.imag() + a[k].imag() * w.real()) * scale;
+    }
+  }
+
+  template <size_t S, bool FWD>
+  void dispatch(T* re, T* im, T* work) const {
+    switch (mAlgo){
+    case ALGORITHM::RADIX4:    run<S, FWD>(re, im); break;
+    case ALGORITHM::MIXED:     run_mixed<S, FWD>(re, im, work); break;
+    case ALGORITHM::BLUESTEIN: run_bluestein<S, FWD>(re, im, work); break;
+    }
+  }
+
+  /* one radix-4 butterfly over each of the m quarters starting at r0..r3 / i0..i3; the quarters
+   * of a block never overlap, telling the compiler so lets it vectorize across j */
+  template <size_t S, bool FWD>
+  static void radix4(T* __restrict__ r0, T* __restrict__ r1, T* __restrict__ r2, T* __restrict__ r3,
+                     T* __restrict__ i0, T* __restrict__ i1, T* __restrict__ i2, T* __restrict__ i3,
+                     const T* __restrict__ twr, const T* __restrict__ twi, size_t m){
+    const T *w1r = twr, *w1i = twi, *w2r = twr + m, *w2i = twi + m, *w3r = twr + 2 * m, *w3i = twi + 2 * m;
+    for (size_t j = 0; j < m; ++j){
+      size_t k = j * S;
+      //the second quarter takes w^2j from the fused radix-2 stage, the last two w^j and w^3j
+      T b1r = r1[k] * w2r[j] - i1[k] * w2i[j], b1i = r1[k] * w2i[j] + i1[k] * w2r[j];
+      T b2r = r2[k] * w1r[j] - i2[k] * w1i[j], b2i = r2[k] * w1i[j] + i2[k] * w1r[j];
+      T b3r = r3[k] * w3r[j] - i3[k] * w3i[j], b3i = r3[k] * w3i[j] + i3[k] * w3r[j];
+      T s0r = r0[k] + b1r, s0i = i0[k] + b1i, d0r = r0[k] - b1r, d0i = i0[k] - b1i;
+      T s1r = b2r + b3r,   s1i = b2i + b3i,   d1r = b2r - b3r,   d1i = b2i - b3i;
+      r0[k] = s0r + s1r; i0[k] = s0i + s1i;
+      r2[k] = s0r - s1r; i2[k] = s0i - s1i;
+      //w^m is -i forward and i inverse
+      if (FWD){
+        r1[k] = d0r + d1i; i1[k] = d0i - d1r;
+        r3[k] = d0r - d1i; i3[k] = d0i + d1r;
+      } else {
+        r1[k] = d0r - d1i; i1[k] = d0i + d1r;
+        r3[k] = d0r + d1i; i3[k] = d0i - d1r;
+      }
+    }
+  }
+
+  //S is the distance between consecutive elements: 2 for interleaved, 1 for split
+  template <size_t S, bool FWD>
+  void run(T* re, T* im) const {
+    //bit reversal, with the forward scaling folded in so it costs no extra pass
+    T scale = FWD ? (T)1 / (T)mN : (T)1;
+    for (size_t i = 0; i < mN; ++i){
+      size_t r = mRev[i];
+      if (i < r){
+        T tr = re[i * S], ti = im[i * S];
+        re[i * S] = re[r * S] * scale; im[i * S] = im[r * S] * scale;
+        re[r * S] = tr * scale;        im[r * S] = ti * scale;
+      } else if (i == r){
+        re[i * S] *= scale; im[i * S] *= scale;
+      }
+    }
+
+    if (mLog % 2)
+      for (size_t i = 0; i < mN; i += 2){
+        T ar = re[i * S], ai = im[i * S], br = re[(i + 1) * S], bi = im[(i + 1) * S];
+        re[i * S] = ar + br;       im[i * S] = ai + bi;
+        re[(i + 1) * S] = ar - br; im[(i + 1) * S] = ai - bi;
+      }
+
+    const T* twr = mTwRe.data();
+    const T* twi = mTwIm.data();
+    for (size_t m = first_m(); m * 4 <= mN; m *= 4){
+      size_t q = m * S;
+      for (size_t base = 0; base < mN * S; base += 4 * q)
+        radix4<S, FWD>(re + base, re + base + q, re + base + 2 * q, re + base + 3 * q,
+                       im + base, im + base + q, im + base + 2 * q, im + base + 3 * q,
+                       twr, twi, m);
+      twr += 3 * m;
+      twi += 3 * m;
+    }
+  }
+public:
+  FFTPlan(size_t n, FFT_DIRECTION dir = FFT_DIRECTION::FORWARD): mN(n), mLog(0), mDir(dir) {
+    assert(n > 0);
+    while (((size_t)1 << mLog) < n) ++mLog;
+    if ((n & (n - 1)) == 0){
+      mAlgo = ALGORITHM::RADIX4;
+      make_radix4();
+    } else if (factor()){
+      mAlgo = ALGORITHM::MIXED;
+      make_mixed();
+    } else {
+      mAlgo = ALGORITHM::BLUESTEIN;
+      make_bluestein();
+    }
+  }
+
+  size_t size() const { return mN; }
+  FFT_DIRECTION direction() const { return mDir; }
+
+  //number of T in the work buffer execute needs, 0 for powers of 2
+  size_t work_size() const {
+    switch (mAlgo){
+    case ALGORITHM::MIXED:     return 2 * mN;
+    case ALGORITHM::BLUESTEIN: return 2 * mBlue[0].size() + mBlue[0].work_size();
+    default:                   return 0;
+    }
+  }
+
+  //interleaved: data holds n complex values, transformed in place
+  void execute(cmplx* data, T* work) const {
+    T* p = reinterpret_cast<T*>(data);
+    if (mDir == FFT_DIRECTION::FORWARD) dispatch<2, true>(p, p + 1, work);
+    else                                dispatch<2, false>(p, p + 1, work);
+  }
+  void execute(cmplx* data) const {
+    s::vector<T> work(work_size());
+    execute(data, work.data());
+  }
+  void execute(s::vector<cmplx>& data) const {
+    assert(data.size() == mN);
+    execute(data.data());
+  }
+
+  //split: re and im hold the n real and n imaginary parts, transformed in place
+  void execute(T* re, T* im, T* work) const {
+    if (mDir == FFT_DIRECTION::FORWARD) dispatch<1, true>(re, im, work);
+    else                                dispatch<1, false>(re, im, work);
+  }
+  void execute(T* re, T* im) const {
+    s::vector<T> work(work_size());
+    execute(re, im, work.data());
+  }
+};
+
+#endif//DFT_FFT_PLAN
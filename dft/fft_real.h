@@ -0,0 +1,99 @@
+#ifndef DFT_FFT_REAL
+#define DFT_FFT_REAL
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <complex>
+
+#include "fft_plan.h"
+
+namespace s = std;
+
+/* Real Input FFT
+ *
+ * the spectrum of n real values is conjugate symmetric, X[n - k] = conj(X[k]), so only the
+ * n / 2 + 1 bins X[0] .. X[n / 2] are computed and stored. the n reals are read as n / 2
+ * complex values (even samples the real parts, odd samples the imaginary parts) and go
+ * through a complex FFT of half the size; one O(n) pass then separates the spectra of the
+ * even and odd samples and combines them. that is half the memory and about half the work
+ * of a complex transform of the same signal.
+ *
+ *   forward: n reals to n / 2 + 1 complex bins, divided by n like fft
+ *   inverse: n / 2 + 1 complex bins back to n reals, unscaled like ifft
+ *
+ * n must be even. the half size transform of a size other than a power of 2 allocates its
+ * work buffer on every call.
+ */
+
+template <typename T>
+class RealFFTPlan {
+  using cmplx = s::complex<T>;
+
+  size_t mN;
+  FFTPlan<T> mFwd;         //half size complex plans
+  FFTPlan<T> mInv;
+  s::vector<cmplx> mTw;    //e^(-2pi i k / n) for k <= n / 2
+public:
+  explicit RealFFTPlan(size_t n):
+    mN(n), mFwd(n / 2, FFT_DIRECTION::FORWARD), mInv(n / 2, FFT_DIRECTION::INVERSE) {
+    assert(n >= 2 && n % 2 == 0);
+    for (size_t k = 0; k <= n / 2; ++k){
+      double a = -2. * M_PI * (double)k / (double)n;
+      mTw.push_back(cmplx((T)cos(a), (T)sin(a)));
+    }
+  }
+
+  size_t size() const { return mN; }
+  size_t bins() const { return mN / 2 + 1; }
+
+  //in holds n reals, out receives n / 2 + 1 bins; in and out must not overlap
+  void forward(const T* in, cmplx* out) const {
+    size_t m = mN / 2;
+    memcpy((void*)out, in, sizeof(T) * mN);
+    mFwd.execute(out);
+
+    //with Z the half size transform, divided by m, of z = x_even + i x_odd:
+    //  E[k] = (Z[k] + conj(Z[m - k])) / 2, O[k] = (Z[k] - conj(Z[m - k])) / 2i
+    //  X[k] = (E[k] + w^k O[k]) / 2 is the transform divided by n
+    T z0r = out[0].real(), z0i = out[0].imag();
+    out[0] = cmplx((z0r + z0i) / 2, 0);
+    out[m] = cmplx((z0r - z0i) / 2, 0);
+    const cmplx ni(0, (T)-0.5);
+    for (size_t k = 1; k <= m / 2; ++k){
+      cmplx zk = out[k], zj = out[m - k];
+      cmplx ek = (zk + s::conj(zj)) * (T)0.5, ok = (zk - s::conj(zj)) * ni;
+      cmplx ej = (zj + s::conj(zk)) * (T)0.5, oj = (zj - s::conj(zk)) * ni;
+      out[k]     = (ek + mTw[k] * ok) * (T)0.5;
+      out[m - k] = (ej + mTw[m - k] * oj) * (T)0.5;
+    }
+  }
+  void forward(const s::vector<T>& in, s::vector<cmplx>& out) const {
+    assert(in.size() == mN);
+    out.resize(bins());
+    forward(in.data(), out.data());
+  }
+
+  //in holds n / 2 + 1 bins, out receives n reals; in and out must not overlap
+  void inverse(const cmplx* in, T* out) const {
+    size_t m = mN / 2;
+    cmplx* z = reinterpret_cast<cmplx*>(out);
+
+    //the even samples are the inverse of E[k] = X[k] + X[k + m], the odd samples the inverse of
+    //O[k] = (X[k] - X[k + m]) w^-k, with X[k + m] = conj(X[m - k]); z = E + i O
+    const cmplx pi(0, 1);
+    for (size_t k = 0; k < m; ++k){
+      cmplx xk = in[k], xh = s::conj(in[m - k]);
+      z[k] = (xk + xh) + pi * ((xk - xh) * s::conj(mTw[k]));
+    }
+    mInv.execute(z);
+  }
+  void inverse(const s::vector<cmplx>& in, s::vector<T>& out) const {
+    assert(in.size() == bins());
+    out.resize(mN);
+    inverse(in.data(), out.data());
+  }
+};
+
+#endif//DFT_FFT_REAL
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <fft_batch.h>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+
+namespace s = std;
+
+using cmplx = s::complex<double>;
+
+s::vector<cmplx> random_signal(size_t n, unsigned seed){
+  s::mt19937 gen(seed);
+  s::uniform_real_distribution<double> dist(-1., 1.);
+  s::vector<cmplx> a;
+  for (size_t i = 0; i < n; ++i)
+    a.push_back(cmplx(dist(gen), dist(gen)));
+  return a;
+}
+
+TEST(FFTBatch, MatchesSingle){
+  for (size_t threads : {0, 3}){
+    default_pool().resize(threads);
+    for (size_t n : {8, 12, 256, 1000}){
+      size_t count = 100, dist = n + 3;
+      s::vector<cmplx> a = random_signal(count * dist, n);
+      s::vector<cmplx> expected = a;
+      FFTPlan<double> plan(n);
+      for (size_t k = 0; k < count; ++k)
+        plan.execute(&expected[k * dist]);
+      fft_batch(plan, a.data(), count, dist);
+      for (size_t i = 0; i < a.size(); ++i)
+        EXPECT_EQ(expected[i], a[i]) << "n = " << n << " threads = " << threads;
+    }
+  }
+  default_pool().resize(0);
+}
+
+TEST(FFTBatch, Split){
+  default_pool().resize(2);
+  size_t n = 60, count = 500;
+  s::vector<cmplx> a = random_signal(n * count, 1);
+  s::vector<double> re, im;
+  for (cmplx c : a){
+    re.push_back(c.real());
+    im.push_back(c.imag());
+  }
+  FFTPlan<double> plan(n, FFT_DIRECTION::INVERSE);
+  fft_batch(plan, a.data(), count);
+  fft_batch(plan, re.data(), im.data(), count, n);
+  for (size_t i = 0; i < a.size(); ++i){
+    EXPECT_NEAR(a[i].real(), re[i], 1e-15);
+    EXPECT_NEAR(a[i].imag(), im[i], 1e-15);
+  }
+  default_pool().resize(0);
+}
+
+TEST(FFT2DPlan, MatchesNaive){
+  size_t rows = 6, cols = 10;
+  s::vector<cmplx> a = random_signal(rows * cols, 2);
+  s::vector<cmplx> expected(rows * cols);
+  for (size_t u = 0; u < rows; ++u)
+    for (size_t v = 0; v < cols; ++v){
+      for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j){
+          double w = -2. * M_PI * ((double)(u * i) / rows + (double)(v * j) / cols);
+          expected[u * cols + v] += a[i * cols + j] * cmplx(cos(w), sin(w));
+        }
+      expected[u * cols + v] /= (double)(rows * cols);
+    }
+
+  FFT2DPlan<double> plan(rows, cols);
+  plan.execute(a);
+  for (size_t i = 0; i < a.size(); ++i){
+    EXPECT_NEAR(expected[i].real(), a[i].real(), 1e-14);
+    EXPECT_NEAR(expected[i].imag(), a[i].imag(), 1e-14);
+  }
+}
+
+TEST(FFT2DPlan, RoundTrip){
+  default_pool().resize(3);
+  for (auto dims : {s::make_pair(256, 128), s::make_pair(100, 37), s::make_pair(1, 64)}){
+    size_t rows = dims.first, cols = dims.second;
+    s::vector<cmplx> a = random_signal(rows * cols, rows);
+    s::vector<s::complex<float>> y(a.begin(), a.end());
+    FFT2DPlan<float>(rows, cols).execute(y);
+    FFT2DPlan<float>(rows, cols, FFT_DIRECTION::INVERSE).execute(y);
+    for (size_t i = 0; i < a.size(); ++i){
+      EXPECT_NEAR(a[i].real(), y[i].real(), 1e-4);
+      EXPECT_NEAR(a[i].imag(), y[i].imag(), 1e-4);
+    }
+  }
+  default_pool().resize(0);
+}
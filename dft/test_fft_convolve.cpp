@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <fft_convolve.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+namespace s = std;
+
+template <typename T>
+s::vector<T> random_real(size_t n, unsigned seed){
+  s::mt19937 gen(seed);
+  s::uniform_real_distribution<T> dist(-1., 1.);
+  s::vector<T> a;
+  for (size_t i = 0; i < n; ++i)
+    a.push_back(dist(gen));
+  return a;
+}
+
+template <typename T>
+s::vector<T> direct_convolve(const s::vector<T>& x, const s::vector<T>& h){
+  s::vector<T> y(x.size() + h.size() - 1);
+  for (size_t i = 0; i < x.size(); ++i)
+    for (size_t k = 0; k < h.size(); ++k)
+      y[i + k] += x[i] * h[k];
+  return y;
+}
+
+TEST(FFTConvolve, FullConvolution){
+  for (size_t nh : {1, 2, 7, 31, 100}){
+    s::vector<double> x = random_real<double>(1000, nh), h = random_real<double>(nh, nh + 1);
+    s::vector<double> expected = direct_convolve(x, h);
+    s::vector<double> y = fft_convolve(x, h);
+    ASSERT_EQ(expected.size(), y.size());
+    for (size_t i = 0; i < y.size(); ++i)
+      EXPECT_NEAR(expected[i], y[i], 1e-12) << "nh = " << nh << " i = " << i;
+  }
+}
+
+TEST(FFTConvolve, Correlation){
+  s::vector<double> x = random_real<double>(300, 1), h = random_real<double>(20, 2);
+  s::vector<double> y = fft_correlate(x, h);
+  ASSERT_EQ(x.size() + h.size() - 1, y.size());
+  for (size_t i = 0; i < y.size(); ++i){
+    double e = 0.;
+    for (size_t k = 0; k < h.size(); ++k){
+      long j = (long)i + (long)k - (long)(h.size() - 1);
+      if (j >= 0 && j < (long)x.size()) e += x[j] * h[k];
+    }
+    EXPECT_NEAR(e, y[i], 1e-12);
+  }
+}
+
+TEST(FFTConvolve, CorrelationFindsTemplate){
+  s::vector<float> x = random_real<float>(2000, 5), h(x.begin() + 1234, x.begin() + 1234 + 64);
+  s::vector<float> y = fft_correlate(x, h);
+  size_t best = s::max_element(y.begin(), y.end()) - y.begin();
+  EXPECT_EQ(1234 + h.size() - 1, best);
+}
+
+//filtering a stream in chunks of varying sizes gives the same output as one shot
+TEST(FFTConvolve, StreamingChunks){
+  for (OVERLAP method : {OVERLAP::ADD, OVERLAP::SAVE}){
+    s::vector<float> x = random_real<float>(5000, 9), h = random_real<float>(45, 10);
+    s::vector<float> expected = direct_convolve(x, h);
+    FFTConvolver<float> conv(h, method, 128);
+    EXPECT_EQ(128 - 45 + 1, conv.block_size());
+
+    s::mt19937 gen(11);
+    s::vector<float> y(x.size());
+    for (size_t i = 0; i < x.size();){
+      size_t c = s::min(x.size() - i, (size_t)(gen() % 300));
+      conv.process(&x[i], &y[i], c);
+      i += c;
+    }
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_NEAR(expected[i], y[i], 1e-4) << "i = " << i;
+  }
+}
+
+TEST(FFTConvolve, InPlaceAndReset){
+  for (OVERLAP method : {OVERLAP::ADD, OVERLAP::SAVE}){
+    s::vector<double> x = random_real<double>(700, 3), h = random_real<double>(16, 4);
+    s::vector<double> expected = direct_convolve(x, h);
+    FFTConvolver<double> conv(h, method);
+    s::vector<double> y = x;
+    conv.process(y);
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_NEAR(expected[i], y[i], 1e-12);
+
+    conv.reset();
+    y = x;
+    conv.process(y);
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_NEAR(expected[i], y[i], 1e-12);
+  }
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <fft_v2.h>
+#include <fft_plan.h>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+
+namespace s = std;
+
+using cmplx = s::complex<double>;
+
+s::vector<cmplx> random_signal(size_t n, unsigned seed){
+  s::mt19937 gen(seed);
+  s::uniform_real_distribution<double> dist(-1., 1.);
+  s::vector<cmplx> a;
+  for (size_t i = 0; i < n; ++i)
+    a.push_back(cmplx(dist(gen), dist(gen)));
+  return a;
+}
+
+TEST(FFTPlan, MatchesFFT){
+  for (size_t n = 1; n <= 4096; n <<= 1){
+    s::vector<cmplx> a = random_signal(n, n);
+    s::vector<cmplx> y = fft(a);
+    FFTPlan<double> plan(n);
+    plan.execute(a);
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(y[i].real(), a[i].real(), 1e-12) << "n = " << n;
+      EXPECT_NEAR(y[i].imag(), a[i].imag(), 1e-12) << "n = " << n;
+    }
+  }
+}
+
+TEST(FFTPlan, MatchesIFFT){
+  for (size_t n = 1; n <= 4096; n <<= 1){
+    s::vector<cmplx> y = random_signal(n, n + 1);
+    s::vector<cmplx> a = ifft(y);
+    FFTPlan<double> plan(n, FFT_DIRECTION::INVERSE);
+    plan.execute(y);
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(a[i].real(), y[i].real(), 1e-9) << "n = " << n;
+      EXPECT_NEAR(a[i].imag(), y[i].imag(), 1e-9) << "n = " << n;
+    }
+  }
+}
+
+TEST(FFTPlan, SplitMatchesInterleaved){
+  size_t n = 512;
+  s::vector<cmplx> a = random_signal(n, 7);
+  s::vector<double> re, im;
+  for (cmplx c : a){
+    re.push_back(c.real());
+    im.push_back(c.imag());
+  }
+  FFTPlan<double> plan(n);
+  plan.execute(a);
+  plan.execute(re.data(), im.data());
+  for (size_t i = 0; i < n; ++i){
+    EXPECT_DOUBLE_EQ(a[i].real(), re[i]);
+    EXPECT_DOUBLE_EQ(a[i].imag(), im[i]);
+  }
+}
+
+TEST(FFTPlan, RoundTripReused){
+  size_t n = 2048;
+  FFTPlan<float> fwd(n);
+  FFTPlan<float> inv(n, FFT_DIRECTION::INVERSE);
+  for (unsigned seed = 0; seed < 3; ++seed){
+    s::vector<cmplx> a = random_signal(n, seed);
+    s::vector<s::complex<float>> y(a.begin(), a.end());
+    fwd.execute(y);
+    inv.execute(y);
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(a[i].real(), y[i].real(), 1e-5);
+      EXPECT_NEAR(a[i].imag(), y[i].imag(), 1e-5);
+    }
+  }
+}
+
+TEST(FFTPlan, Impulse){
+  size_t n = 64;
+  s::vector<cmplx> a(n);
+  a[1] = 1.;
+  FFTPlan<double> plan(n);
+  plan.execute(a);
+  for (size_t k = 0; k < n; ++k){
+    EXPECT_NEAR(cos(-TWO_PI * k / n) / n, a[k].real(), 1e-15);
+    EXPECT_NEAR(sin(-TWO_PI * k / n) / n, a[k].imag(), 1e-15);
+  }
+}
+
+//O(n^2) reference with the same scaling as fft and ifft
+s::vector<cmplx> naive_dft(const s::vector<cmplx>& a, FFT_DIRECTION dir){
+  size_t n = a.size();
+  double sign = dir == FFT_DIRECTION::FORWARD ? -1. : 1.;
+  s::vector<cmplx> y(n);
+  for (size_t k = 0; k < n; ++k){
+    for (size_t j = 0; j < n; ++j){
+      double w = sign * TWO_PI * (double)((j * k) % n) / (double)n;
+      y[k] += a[j] * cmplx(cos(w), sin(w));
+    }
+    if (dir == FFT_DIRECTION::FORWARD) y[k] /= (double)n;
+  }
+  return y;
+}
+
+void expect_matches_dft(size_t n, FFT_DIRECTION dir, double eps){
+  s::vector<cmplx> a = random_signal(n, n * 3 + (int)dir);
+  s::vector<cmplx> y = naive_dft(a, dir);
+  FFTPlan<double> plan(n, dir);
+  plan.execute(a);
+  for (size_t i = 0; i < n; ++i){
+    EXPECT_NEAR(y[i].real(), a[i].real(), eps) << "n = " << n;
+    EXPECT_NEAR(y[i].imag(), a[i].imag(), eps) << "n = " << n;
+  }
+}
+
+TEST(FFTPlan, AnySize){
+  for (size_t n = 1; n <= 130; ++n){
+    expect_matches_dft(n, FFT_DIRECTION::FORWARD, 1e-12);
+    expect_matches_dft(n, FFT_DIRECTION::INVERSE, 1e-10);
+  }
+}
+
+TEST(FFTPlan, MixedRadix){
+  for (size_t n : {210, 343, 375, 1080, 3000, 5040}){
+    expect_matches_dft(n, FFT_DIRECTION::FORWARD, 1e-12);
+    expect_matches_dft(n, FFT_DIRECTION::INVERSE, 1e-9);
+  }
+}
+
+TEST(FFTPlan, Bluestein){
+  for (size_t n : {11, 97, 1009, 2018, 4099}){
+    expect_matches_dft(n, FFT_DIRECTION::FORWARD, 1e-12);
+    expect_matches_dft(n, FFT_DIRECTION::INVERSE, 1e-9);
+  }
+}
+
+TEST(FFTPlan, SplitWithWorkBuffer){
+  for (size_t n : {5000, 1031}){
+    s::vector<cmplx> a = random_signal(n, 5);
+    s::vector<double> re, im;
+    for (cmplx c : a){
+      re.push_back(c.real());
+      im.push_back(c.imag());
+    }
+    FFTPlan<double> plan(n);
+    s::vector<double> work(plan.work_size());
+    EXPECT_LT(0U, work.size());
+    plan.execute(a.data(), work.data());
+    plan.execute(re.data(), im.data(), work.data());
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(a[i].real(), re[i], 1e-15);
+      EXPECT_NEAR(a[i].imag(), im[i], 1e-15);
+    }
+  }
+}
+
+TEST(FFTPlan, RoundTripAnySizeFloat){
+  for (size_t n : {3000, 4097}){
+    FFTPlan<float> fwd(n);
+    FFTPlan<float> inv(n, FFT_DIRECTION::INVERSE);
+    s::vector<cmplx> a = random_signal(n, 1);
+    s::vector<s::complex<float>> y(a.begin(), a.end());
+    fwd.execute(y);
+    inv.execute(y);
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(a[i].real(), y[i].real(), 1e-4);
+      EXPECT_NEAR(a[i].imag(), y[i].imag(), 1e-4);
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <fft_real.h>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <random>
+
+namespace s = std;
+
+using cmplx = s::complex<double>;
+
+s::vector<double> random_real(size_t n, unsigned seed){
+  s::mt19937 gen(seed);
+  s::uniform_real_distribution<double> dist(-1., 1.);
+  s::vector<double> a;
+  for (size_t i = 0; i < n; ++i)
+    a.push_back(dist(gen));
+  return a;
+}
+
+TEST(RealFFTPlan, MatchesComplexFFT){
+  for (size_t n = 2; n <= 4096; n <<= 1){
+    s::vector<double> x = random_real(n, n);
+    s::vector<cmplx> y(x.begin(), x.end());
+    FFTPlan<double>(n).execute(y);
+
+    RealFFTPlan<double> plan(n);
+    s::vector<cmplx> ry;
+    plan.forward(x, ry);
+    ASSERT_EQ(n / 2 + 1, ry.size());
+    for (size_t k = 0; k < ry.size(); ++k){
+      EXPECT_NEAR(y[k].real(), ry[k].real(), 1e-12) << "n = " << n << " k = " << k;
+      EXPECT_NEAR(y[k].imag(), ry[k].imag(), 1e-12) << "n = " << n << " k = " << k;
+    }
+  }
+}
+
+TEST(RealFFTPlan, InverseMatchesComplexIFFT){
+  for (size_t n = 2; n <= 4096; n <<= 1){
+    s::vector<double> x = random_real(n, n + 1);
+    RealFFTPlan<double> plan(n);
+    s::vector<cmplx> spec;
+    plan.forward(x, spec);
+
+    //full conjugate symmetric spectrum for the complex inverse
+    s::vector<cmplx> full(n);
+    for (size_t k = 0; k < n; ++k)
+      full[k] = k <= n / 2 ? spec[k] : s::conj(spec[n - k]);
+    FFTPlan<double>(n, FFT_DIRECTION::INVERSE).execute(full);
+
+    s::vector<double> rx;
+    plan.inverse(spec, rx);
+    ASSERT_EQ(n, rx.size());
+    for (size_t i = 0; i < n; ++i){
+      EXPECT_NEAR(full[i].real(), rx[i], 1e-12) << "n = " << n;
+      EXPECT_NEAR(x[i], rx[i], 1e-12) << "n = " << n;
+    }
+  }
+}
+
+TEST(RealFFTPlan, RoundTripFloat){
+  size_t n = 1024;
+  s::vector<double> x = random_real(n, 3);
+  s::vector<float> fx(x.begin(), x.end()), rx;
+  s::vector<s::complex<float>> spec;
+  RealFFTPlan<float> plan(n);
+  plan.forward(fx, spec);
+  plan.inverse(spec, rx);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(fx[i], rx[i], 1e-5);
+}
+
+TEST(RealFFTPlan, Cosine){
+  size_t n = 32;
+  s::vector<double> x(n);
+  for (size_t i = 0; i < n; ++i)
+    x[i] = cos(2. * M_PI * 3. * i / n);
+  s::vector<cmplx> spec;
+  RealFFTPlan<double>(n).forward(x, spec);
+  for (size_t k = 0; k < spec.size(); ++k){
+    EXPECT_NEAR(k == 3 ? 0.5 : 0., spec[k].real(), 1e-15);
+    EXPECT_NEAR(0., spec[k].imag(), 1e-15);
+  }
+}
+
+TEST(RealFFTPlan, EvenSize){
+  size_t n = 3000;
+  s::vector<double> x = random_real(n, 4), rx;
+  s::vector<cmplx> y(x.begin(), x.end()), spec;
+  FFTPlan<double>(n).execute(y);
+  RealFFTPlan<double> plan(n);
+  plan.forward(x, spec);
+  for (size_t k = 0; k < spec.size(); ++k){
+    EXPECT_NEAR(y[k].real(), spec[k].real(), 1e-12);
+    EXPECT_NEAR(y[k].imag(), spec[k].imag(), 1e-12);
+  }
+  plan.inverse(spec, rx);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(x[i], rx[i], 1e-12);
+}
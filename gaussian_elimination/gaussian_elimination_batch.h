@@ -0,0 +1,212 @@
+#ifndef GAUSSIAN_ELIMINATION_BATCH
+#define GAUSSIAN_ELIMINATION_BATCH
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "../lu_decomposition/lu.h"
+#include "../thread_pool/thread_pool.h"
+
+namespace s = std;
+
+/* Batched Gaussian Elimination
+ *
+ * solves batch independent N x N systems A X = B, each with R right hand sides, laid out
+ * struct of arrays: element (i, j) of system k is at a[(i * N + j) * batch + k] and right
+ * hand side r of row i at b[(i * R + r) * batch + k]; x is laid out like b.
+ *
+ * consecutive systems sit next to each other in memory, so every step of the elimination is
+ * one vector instruction over a group of systems, 16 bytes worth of them on a generic target
+ * and 32 or 64 bytes when AVX2 or AVX-512 is available at runtime. partial
+ * pivoting differs per system, rows are swapped with selects instead of branches.
+ * with N and R known at compile time every loop bound is a constant and the working set of
+ * a group of systems stays in L1.
+ *
+ * a system whose pivot falls within eps of 0 is singular; its solution is left undefined and
+ * it is flagged in singular[k] when singular is given. the number of singular systems is
+ * returned.
+ */
+
+//VB byte wide vector of T, one lane per system; the compiler maps it onto the vector
+//registers of the target the kernel is compiled for
+template <typename T, size_t VB> struct GaussVec;
+template <> struct GaussVec<float, 16>  { typedef float  type __attribute__((vector_size(16))); };
+template <> struct GaussVec<double, 16> { typedef double type __attribute__((vector_size(16))); };
+template <> struct GaussVec<float, 32>  { typedef float  type __attribute__((vector_size(32))); };
+template <> struct GaussVec<double, 32> { typedef double type __attribute__((vector_size(32))); };
+template <> struct GaussVec<float, 64>  { typedef float  type __attribute__((vector_size(64))); };
+template <> struct GaussVec<double, 64> { typedef double type __attribute__((vector_size(64))); };
+
+//out = lanes of a where mask is set, b elsewhere; written with bit operations as gcc 12
+//fails to compile the ?: form of it for AVX-512. vectors go by reference, wide vectors by
+//value change the calling convention between targets
+template <typename V, typename M>
+__attribute__((always_inline)) inline void gauss_select(V& out, const M& mask, const V& a, const V& b){
+  V r = (V)(((M)a & mask) | ((M)b & ~mask));
+  out = r;
+}
+
+//eliminate the W = VB / sizeof(T) systems starting at k0, w of them are real; always inlined
+//so that it is compiled for the target of the dispatching caller
+template <typename T, size_t N, size_t R, size_t VB>
+__attribute__((always_inline)) inline
+size_t gaussian_elimination_group(T* x, const T* a, const T* b, size_t batch, size_t k0, size_t w,
+                                  unsigned char* singular, T eps){
+  using V = typename GaussVec<T, VB>::type;
+  constexpr size_t W = VB / sizeof(T);
+  constexpr size_t C = N + R;
+  V m[N][C];
+  const V zero = {}, one = zero + 1;
+  V bad = zero;
+
+  //pad the tail of the last group with identity systems
+  auto load = [&](V& dst, const T* src, T pad){
+    if (w == W) memcpy(&dst, src, sizeof(V));
+    else for (size_t l = 0; l < W; ++l) dst[l] = l < w ? src[l] : pad;
+  };
+  for (size_t i = 0; i < N; ++i){
+    for (size_t j = 0; j < N; ++j) load(m[i][j], &a[(i * N + j) * batch + k0], (T)(i == j));
+    for (size_t r = 0; r < R; ++r) load(m[i][N + r], &b[(i * R + r) * batch + k0], T());
+  }
+
+  for (size_t k = 0; k < N; ++k){
+    //partial pivoting: a row holding a larger candidate than the current pivot row trades
+    //places with it, lane by lane; when the scan ends row k holds the largest candidate
+    for (size_t i = k + 1; i < N; ++i){
+      V pv;
+      gauss_select(pv, m[k][k] < zero, -m[k][k], m[k][k]);
+      V v;
+      gauss_select(v, m[i][k] < zero, -m[i][k], m[i][k]);
+      auto sw = v > pv;
+      for (size_t j = k; j < C; ++j){
+        V t = m[k][j], u = m[i][j];
+        gauss_select(m[k][j], sw, u, t);
+        gauss_select(m[i][j], sw, t, u);
+      }
+    }
+    V pv;
+    gauss_select(pv, m[k][k] < zero, -m[k][k], m[k][k]);
+
+    //a singular system keeps going on a unit pivot so it cannot spread inf or nan
+    auto z = pv <= zero + eps;
+    gauss_select(bad, z, one, bad);
+    V piv;
+    gauss_select(piv, z, one, m[k][k]);
+    V inv = one / piv;
+    for (size_t j = k + 1; j < C; ++j) m[k][j] *= inv;
+    for (size_t i = k + 1; i < N; ++i){
+      V f = m[i][k];
+      for (size_t j = k + 1; j < C; ++j) m[i][j] -= f * m[k][j];
+    }
+  }
+
+  //back substitution on the unit upper triangle, the solution replaces the right hand side
+  for (size_t i = N; i-- > 0;)
+    for (size_t j = i + 1; j < N; ++j)
+      for (size_t r = 0; r < R; ++r) m[i][N + r] -= m[i][j] * m[j][N + r];
+
+  for (size_t i = 0; i < N; ++i)
+    for (size_t r = 0; r < R; ++r){
+      T* dst = &x[(i * R + r) * batch + k0];
+      for (size_t l = 0; l < w; ++l) dst[l] = m[i][N + r][l];
+    }
+  size_t nbad = 0;
+  for (size_t l = 0; l < w; ++l){
+    nbad += bad[l] != T();
+    if (singular) singular[k0 + l] = bad[l] != T();
+  }
+  return nbad;
+}
+
+//systems [k0, k1) in groups of VB / sizeof(T), one instance per target
+template <typename T, size_t N, size_t R, size_t VB>
+size_t gaussian_elimination_range(T* x, const T* a, const T* b, size_t batch, size_t k0, size_t k1,
+                                  unsigned char* singular, T eps){
+  constexpr size_t W = VB / sizeof(T);
+  size_t nbad = 0;
+  for (size_t k = k0; k < k1; k += W)
+    nbad += gaussian_elimination_group<T, N, R, VB>(x, a, b, batch, k, s::min(W, k1 - k), singular, eps);
+  return nbad;
+}
+#ifdef NN_GEMM_X86
+template <typename T, size_t N, size_t R>
+NN_AVX2 size_t gaussian_elimination_range_avx2(T* x, const T* a, const T* b, size_t batch, size_t k0, size_t k1,
+                                               unsigned char* singular, T eps){
+  constexpr size_t W = 32 / sizeof(T);
+  size_t nbad = 0;
+  for (size_t k = k0; k < k1; k += W)
+    nbad += gaussian_elimination_group<T, N, R, 32>(x, a, b, batch, k, s::min(W, k1 - k), singular, eps);
+  return nbad;
+}
+template <typename T, size_t N, size_t R>
+NN_AVX512 size_t gaussian_elimination_range_avx512(T* x, const T* a, const T* b, size_t batch, size_t k0, size_t k1,
+                                                   unsigned char* singular, T eps){
+  constexpr size_t W = 64 / sizeof(T);
+  size_t nbad = 0;
+  for (size_t k = k0; k < k1; k += W)
+    nbad += gaussian_elimination_group<T, N, R, 64>(x, a, b, batch, k, s::min(W, k1 - k), singular, eps);
+  return nbad;
+}
+#endif
+
+/* compile time sized systems; the kernel is picked by the same cpu detection as gemm and
+ * ranges of systems are spread over default_pool() */
+template <typename T, size_t N, size_t R = 1>
+size_t gaussian_elimination_batch(T* x, const T* a, const T* b, size_t batch,
+                                  unsigned char* singular = nullptr, T eps = LU_EPSILON<T>){
+  constexpr size_t GRAIN = 1024; //systems, a multiple of every group size
+  size_t nchunk = (batch + GRAIN - 1) / GRAIN;
+  s::atomic<size_t> nbad(0);
+  default_pool().parallel_for(0, nchunk, 1, [&](size_t cb, size_t ce){
+    size_t k0 = cb * GRAIN, k1 = s::min(batch, ce * GRAIN), cnt;
+    switch (gemm_arch()){
+#ifdef NN_GEMM_X86
+    case GAvx512: cnt = gaussian_elimination_range_avx512<T, N, R>(x, a, b, batch, k0, k1, singular, eps); break;
+    case GAvx2:   cnt = gaussian_elimination_range_avx2<T, N, R>(x, a, b, batch, k0, k1, singular, eps); break;
+#endif
+    default:      cnt = gaussian_elimination_range<T, N, R, 16>(x, a, b, batch, k0, k1, singular, eps); break;
+    }
+    nbad += cnt;
+  });
+  return nbad;
+}
+
+/* runtime sized systems: 1 <= n <= 16 with a single right hand side is forwarded to the
+ * compile time sized version; larger systems and any with nrhs > 1 are gathered and solved
+ * one at a time with LU */
+template <typename T>
+size_t gaussian_elimination_batch(T* x, const T* a, const T* b, size_t n, size_t nrhs, size_t batch,
+                                  unsigned char* singular = nullptr, T eps = LU_EPSILON<T>){
+#define GAUSS_BATCH_CASE(N) \
+  case N: \
+    if (nrhs == 1) return gaussian_elimination_batch<T, N, 1>(x, a, b, batch, singular, eps); \
+    break;
+  switch (n){
+    GAUSS_BATCH_CASE(1)  GAUSS_BATCH_CASE(2)  GAUSS_BATCH_CASE(3)  GAUSS_BATCH_CASE(4)
+    GAUSS_BATCH_CASE(5)  GAUSS_BATCH_CASE(6)  GAUSS_BATCH_CASE(7)  GAUSS_BATCH_CASE(8)
+    GAUSS_BATCH_CASE(9)  GAUSS_BATCH_CASE(10) GAUSS_BATCH_CASE(11) GAUSS_BATCH_CASE(12)
+    GAUSS_BATCH_CASE(13) GAUSS_BATCH_CASE(14) GAUSS_BATCH_CASE(15) GAUSS_BATCH_CASE(16)
+    default: break;
+  }
+#undef GAUSS_BATCH_CASE
+
+  size_t nbad = 0;
+  s::vector<T> sa(n * n), sb(n * nrhs), sx(n * nrhs);
+  for (size_t k = 0; k < batch; ++k){
+    for (size_t i = 0; i < n * n; ++i) sa[i] = a[i * batch + k];
+    for (size_t i = 0; i < n * nrhs; ++i) sb[i] = b[i * batch + k];
+    LU<T> lu(sa.data(), n, n, n, 1, eps);
+    bool bad = lu.singular();
+    lu.solve(sx.data(), sb.data(), nrhs);
+    for (size_t i = 0; i < n * nrhs; ++i) x[i * batch + k] = sx[i];
+    nbad += bad;
+    if (singular) singular[k] = bad;
+  }
+  return nbad;
+}
+
+#endif//GAUSSIAN_ELIMINATION_BATCH
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <random>
+#include <gaussian_elimination_batch.h>
+
+namespace s = std;
+
+//random diagonally dominant systems in struct of arrays layout
+template <typename T>
+void random_batch(s::vector<T>& a, s::vector<T>& b, size_t n, size_t nrhs, size_t batch){
+  s::mt19937 gen(n * 131 + batch);
+  s::uniform_real_distribution<T> dist(-1., 1.);
+  a.resize(n * n * batch);
+  b.resize(n * nrhs * batch);
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < n; ++j)
+      for (size_t k = 0; k < batch; ++k)
+        a[(i * n + j) * batch + k] = dist(gen) + (i == j ? (T)n * (k % 2 ? 1 : -1) : 0);
+  for (T& v : b) v = dist(gen);
+}
+
+//max |A x - b| over every system
+template <typename T>
+T max_residual(const s::vector<T>& x, const s::vector<T>& a, const s::vector<T>& b, size_t n, size_t nrhs, size_t batch){
+  T ret = 0;
+  for (size_t k = 0; k < batch; ++k)
+    for (size_t i = 0; i < n; ++i)
+      for (size_t r = 0; r < nrhs; ++r){
+        T sum = 0;
+        for (size_t j = 0; j < n; ++j)
+          sum += a[(i * n + j) * batch + k] * x[(j * nrhs + r) * batch + k];
+        ret = s::max(ret, s::abs(sum - b[(i * nrhs + r) * batch + k]));
+      }
+  return ret;
+}
+
+TEST(GaussianEliminationBatch, CompileTimeSize){
+  s::vector<double> a, b;
+  size_t batch = 1001;
+  random_batch(a, b, 4, 1, batch);
+  s::vector<double> x(b.size());
+  EXPECT_EQ(0U, (gaussian_elimination_batch<double, 4>(x.data(), a.data(), b.data(), batch)));
+  EXPECT_LT(max_residual(x, a, b, 4, 1, batch), 1e-12);
+
+  random_batch(a, b, 8, 3, batch);
+  x.resize(b.size());
+  EXPECT_EQ(0U, (gaussian_elimination_batch<double, 8, 3>(x.data(), a.data(), b.data(), batch)));
+  EXPECT_LT(max_residual(x, a, b, 8, 3, batch), 1e-12);
+}
+
+TEST(GaussianEliminationBatch, RuntimeSize){
+  for (size_t n : {1, 5, 12, 16, 20}){
+    s::vector<float> a, b;
+    size_t batch = 77;
+    random_batch(a, b, n, 1, batch);
+    s::vector<float> x(b.size());
+    EXPECT_EQ(0U, gaussian_elimination_batch(x.data(), a.data(), b.data(), n, 1, batch));
+    EXPECT_LT(max_residual(x, a, b, n, 1, batch), 1e-4f);
+  }
+  s::vector<double> a, b;
+  random_batch(a, b, 6, 2, 33);
+  s::vector<double> x(b.size());
+  EXPECT_EQ(0U, gaussian_elimination_batch(x.data(), a.data(), b.data(), 6, 2, 33));
+  EXPECT_LT(max_residual(x, a, b, 6, 2, 33), 1e-12);
+}
+
+TEST(GaussianEliminationBatch, PivotingAndSingular){
+  //system 0 needs a row swap, system 1 is singular, system 2 is the identity
+  size_t batch = 3;
+  s::vector<double> a(4 * batch, 0.), b(2 * batch, 0.), x(2 * batch);
+  auto set = [&](size_t k, double a00, double a01, double a10, double a11, double b0, double b1){
+    a[0 * batch + k] = a00; a[1 * batch + k] = a01;
+    a[2 * batch + k] = a10; a[3 * batch + k] = a11;
+    b[0 * batch + k] = b0;  b[1 * batch + k] = b1;
+  };
+  set(0, 0., 1., 2., 0., 3., 4.);
+  set(1, 1., 2., 2., 4., 1., 1.);
+  set(2, 1., 0., 0., 1., 5., 6.);
+  unsigned char singular[3];
+  EXPECT_EQ(1U, (gaussian_elimination_batch<double, 2>(x.data(), a.data(), b.data(), batch, singular)));
+  EXPECT_EQ(0, singular[0]);
+  EXPECT_EQ(1, singular[1]);
+  EXPECT_EQ(0, singular[2]);
+  EXPECT_DOUBLE_EQ(2., x[0 * batch + 0]);
+  EXPECT_DOUBLE_EQ(3., x[1 * batch + 0]);
+  EXPECT_DOUBLE_EQ(5., x[0 * batch + 2]);
+  EXPECT_DOUBLE_EQ(6., x[1 * batch + 2]);
+}
+
+TEST(GaussianEliminationBatch, GenericKernel){
+  //the portable kernel is only dispatched to on machines without AVX2
+  s::vector<float> a, b;
+  size_t batch = 203;
+  random_batch(a, b, 7, 2, batch);
+  s::vector<float> x(b.size());
+  EXPECT_EQ(0U, (gaussian_elimination_range<float, 7, 2, 16>(x.data(), a.data(), b.data(), batch, 0, batch, nullptr, 1e-6f)));
+  EXPECT_LT(max_residual(x, a, b, 7, 2, batch), 1e-4f);
+}
@@ -12,7 +12,7 @@ OPT=-O3
 LIBS=-lgtest -lgtest_main
 DEFINES=
 
-CXXFLAGS=-std=c++17 -MD -pedantic -pedantic-errors -Wall -Wextra $(DEFINES) $(INCLUDES) $(OPT) $(DEBUG)
+CXXFLAGS=-std=c++17 -MD -pedantic -pedantic-errors -Wall -Wextra -pthread $(DEFINES) $(INCLUDES) $(OPT) $(DEBUG)
 CXXLINKS=$(CXXFLAGS) $(LIBS)
 
 COMPILER=clang++
@@ -0,0 +1,62 @@
+#include <cstdint>
+
+#include <crc.h>
+
+#include <vector>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* one buffer of range(0) bytes per iteration, GB/s is bytes_per_second */
+
+static s::vector<uint8_t> make_data(size_t len){
+  s::mt19937 gen(len);
+  s::vector<uint8_t> data(len);
+  for (uint8_t& c : data) c = gen();
+  return data;
+}
+
+//the byte at a time loop crc.h used before the slicing tables
+static uint32_t crc_bytewise(uint32_t crc, const uint8_t* data, size_t len){
+  const auto& t = crc_table<CRC32_IEEE_POLY>.t[0];
+  for (size_t i = 0; i < len; ++i)
+    crc = (crc >> 8U) ^ t[(crc ^ data[i]) & 0xFFU];
+  return crc;
+}
+
+static uint32_t crc_slicing(uint32_t crc, const uint8_t* data, size_t len){
+  return crc_update_table<CRC32_IEEE_POLY>(crc, data, len);
+}
+
+static uint32_t crc_sse42(uint32_t crc, const uint8_t* data, size_t len){
+  return crc32c_update_sse42(crc, data, len);
+}
+
+static uint32_t crc_ieee(uint32_t crc, const uint8_t* data, size_t len){
+  return crc32_ieee(data, len, crc);
+}
+
+static uint32_t crc_c(uint32_t crc, const uint8_t* data, size_t len){
+  return crc32c(data, len, crc);
+}
+
+template <uint32_t (*F)(uint32_t, const uint8_t*, size_t)>
+static void bm_crc(b::State& st){
+  size_t len = st.range(0);
+  s::vector<uint8_t> data = make_data(len);
+  uint32_t crc = 0;
+  for (auto _ : st){
+    crc = F(crc, data.data(), len);
+    b::DoNotOptimize(crc);
+  }
+  st.SetBytesProcessed(st.iterations() * len);
+}
+
+BENCHMARK_TEMPLATE(bm_crc, crc_bytewise)->RangeMultiplier(8)->Range(64, 1 << 21);
+BENCHMARK_TEMPLATE(bm_crc, crc_slicing)->RangeMultiplier(8)->Range(64, 1 << 21);
+BENCHMARK_TEMPLATE(bm_crc, crc_sse42)->RangeMultiplier(8)->Range(64, 1 << 21);
+BENCHMARK_TEMPLATE(bm_crc, crc_ieee)->RangeMultiplier(8)->Range(64, 1 << 21);
+BENCHMARK_TEMPLATE(bm_crc, crc_c)->RangeMultiplier(8)->Range(64, 1 << 21);
@@ -0,0 +1,82 @@
+#include <cstdint>
+
+#include <hash_batch.h>
+
+#include <vector>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+namespace s = std;
+namespace b = benchmark;
+
+/* 64K keys of range(0) bytes each, one after another in memory; keys/sec is items_per_second
+ * and GB/s is bytes_per_second */
+constexpr size_t NKEYS = 1 << 16;
+
+static s::vector<uint8_t> make_keys(size_t len){
+  s::mt19937 gen(len);
+  s::vector<uint8_t> data(NKEYS * len + 8);
+  for (uint8_t& c : data) c = gen();
+  return data;
+}
+
+template <uint32_t (*F)(const uint8_t*, size_t, uint32_t)>
+static void bm_scalar(b::State& st){
+  size_t len = st.range(0);
+  s::vector<uint8_t> data = make_keys(len);
+  s::vector<uint32_t> out(NKEYS);
+  for (auto _ : st){
+    for (size_t i = 0; i < NKEYS; ++i)
+      out[i] = F(&data[i * len], len, 0);
+    b::DoNotOptimize(out.data());
+  }
+  st.SetItemsProcessed(st.iterations() * NKEYS);
+  st.SetBytesProcessed(st.iterations() * NKEYS * len);
+}
+
+template <void (*F)(const uint8_t*, size_t, size_t, uint32_t*, uint32_t)>
+static void bm_batch(b::State& st){
+  size_t len = st.range(0);
+  s::vector<uint8_t> data = make_keys(len);
+  s::vector<uint32_t> out(NKEYS);
+  for (auto _ : st){
+    F(data.data(), len, NKEYS, out.data(), 0);
+    b::DoNotOptimize(out.data());
+  }
+  st.SetItemsProcessed(st.iterations() * NKEYS);
+  st.SetBytesProcessed(st.iterations() * NKEYS * len);
+}
+
+//keys given by pointer and length, as a hash table or a dedup pass would have them
+template <void (*F)(const uint8_t* const*, const size_t*, size_t, uint32_t*, uint32_t)>
+static void bm_batch_ptr(b::State& st){
+  size_t len = st.range(0);
+  s::vector<uint8_t> data = make_keys(len);
+  s::vector<const uint8_t*> keys;
+  s::vector<size_t> lens(NKEYS, len);
+  for (size_t i = 0; i < NKEYS; ++i)
+    keys.push_back(&data[i * len]);
+  s::vector<uint32_t> out(NKEYS);
+  for (auto _ : st){
+    F(keys.data(), lens.data(), NKEYS, out.data(), 0);
+    b::DoNotOptimize(out.data());
+  }
+  st.SetItemsProcessed(st.iterations() * NKEYS);
+  st.SetBytesProcessed(st.iterations() * NKEYS * len);
+}
+
+static uint32_t fnv1a_32_seed(const uint8_t* data, size_t len, uint32_t){
+  return fnv1a_32(data, len);
+}
+static void fnv1a_32_batch_seed(const uint8_t* data, size_t len, size_t n, uint32_t* out, uint32_t){
+  fnv1a_32_batch(data, len, n, out);
+}
+
+BENCHMARK_TEMPLATE(bm_scalar, murmur3)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_batch, murmur3_batch)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_batch_ptr, murmur3_batch)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_scalar, jenkins)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_batch, jenkins_batch)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_scalar, fnv1a_32_seed)->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(bm_batch, fnv1a_32_batch_seed)->RangeMultiplier(2)->Range(4, 256);
@@ -0,0 +1,28 @@
+#ifndef HASH_BYTE_HASH
+#define HASH_BYTE_HASH
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "murmur.h"
+
+/* default hash of the Bloom filters, count-min sketches and HyperLogLog, which derive all
+ * of their probes from a single 64 bit hash: murmur3 x64_128 of the bytes of a trivially
+ * copyable key or of the characters of a string */
+template <typename T>
+struct ByteHash64 {
+  static_assert(std::is_trivially_copyable<T>::value, "ByteHash64 hashes the bytes of the key, give the container a hash functor");
+  uint64_t operator()(const T& v) const noexcept {
+    return murmur3_x64_128((const uint8_t*)&v, sizeof(T)).h1;
+  }
+};
+
+template <>
+struct ByteHash64<std::string> {
+  uint64_t operator()(const std::string& v) const noexcept {
+    return murmur3_x64_128((const uint8_t*)v.data(), v.length()).h1;
+  }
+};
+
+#endif//HASH_BYTE_HASH
@@ -1,40 +1,219 @@
+#ifndef HASH_CRC
+#define HASH_CRC
+
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#include "hash_cpu.h"
+
 /* Cyclic Redundancy Check Hashing Algorithm
+ *
+ * reflected (least significant bit first) 32 bit CRCs over any polynomial, three of them named:
+ *   crc32:       the reflected CCITT polynomial 0x8408 in a 32 bit register, what this header
+ *                has always computed, kept so existing digests do not change
+ *   crc32_ieee:  IEEE 802.3 0xEDB88320, the CRC of zlib, gzip, png and ethernet
+ *   crc32c:      Castagnoli 0x82F63B78, the CRC of iSCSI, ext4 and SSE4.2
+ *
+ * the lookup tables are generated at compile time. the portable path is slicing-by-16: 16
+ * bytes go through 16 independent table lookups per step instead of a chain of 16 dependent
+ * ones, with slicing-by-8 and byte at a time for the rest. picked at runtime:
+ *   - crc32c uses the SSE4.2 crc32 instruction, 8 bytes per instruction
+ *   - buffers of at least CRC_FOLD_MIN bytes are folded with carry-less multiplication
+ *     (PCLMULQDQ): 4 streams of 16 bytes are multiplied forward by x^512 modulo the
+ *     polynomial and added to the next 64 bytes, the 128 bits left at the end are reduced
+ *     with the tables. this works for every polynomial
+ *
+ * incremental use: crc32_ieee and crc32c continue from the crc of the data before, as in
+ * zlib, crc = crc32c(chunk, n, crc); or a CRCStream keeps the running state between update()
+ * calls and finalize() gives the crc of everything so far.
  */
 
+constexpr uint32_t CRC_CCITT_POLY   = 0x8408U;
+constexpr uint32_t CRC32_IEEE_POLY  = 0xEDB88320U;
+constexpr uint32_t CRC32C_POLY      = 0x82F63B78U;
+
 constexpr size_t CRC_TABLE_SIZE = 256;
-uint32_t crctable[CRC_TABLE_SIZE];
-
-void generate_table(){
-  crctable[0] = 0U;
-  uint32_t crc = 1U;
-  size_t i = 128U;
-  do {
-    if (crc & 0x1U)
-      crc = (crc >> 1U) ^ 0x8408U;
-    else
-      crc >>= 0x1U;
-
-    for (size_t j = 0; j < 256U; j += i * 2)
-      crctable[i + j] = crc ^ crctable[j];
-
-    i >>= 1U;
-  } while (i > 0);
-}
-
-uint32_t crc32(const uint8_t* data, size_t len, uint32_t /*seed not used*/ = 0){
-  static bool do_generate_table = true;
-  if (do_generate_table){
-    generate_table();
-    do_generate_table = false;
+constexpr size_t CRC_FOLD_MIN = 256; //bytes
+
+//t[0] is the classic byte table, t[k][i] is the crc of byte i followed by k zero bytes
+template <uint32_t POLY>
+struct CRCTable {
+  uint32_t t[16][CRC_TABLE_SIZE];
+
+  constexpr CRCTable(): t() {
+    for (uint32_t i = 0; i < CRC_TABLE_SIZE; ++i){
+      uint32_t crc = i;
+      for (size_t b = 0; b < 8; ++b)
+        crc = (crc >> 1U) ^ ((crc & 0x1U) ? POLY : 0U);
+      t[0][i] = crc;
+    }
+    for (size_t k = 1; k < 16; ++k)
+      for (size_t i = 0; i < CRC_TABLE_SIZE; ++i)
+        t[k][i] = (t[k - 1][i] >> 8U) ^ t[0][t[k - 1][i] & 0xFFU];
+  }
+};
+
+template <uint32_t POLY>
+inline constexpr CRCTable<POLY> crc_table{};
+
+inline uint32_t crc_load32(const uint8_t* p){
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* the functions named crc_update take and return the raw register, without the initial and
+ * final inversion */
+template <uint32_t POLY>
+uint32_t crc_update_table(uint32_t crc, const uint8_t* data, size_t len){
+  const auto& t = crc_table<POLY>.t;
+  for (; len >= 16; data += 16, len -= 16){
+    uint32_t a = crc_load32(data) ^ crc, b = crc_load32(data + 4);
+    uint32_t c = crc_load32(data + 8),    d = crc_load32(data + 12);
+    crc = t[15][a & 0xFFU] ^ t[14][(a >> 8) & 0xFFU] ^ t[13][(a >> 16) & 0xFFU] ^ t[12][a >> 24] ^
+          t[11][b & 0xFFU] ^ t[10][(b >> 8) & 0xFFU] ^ t[9][(b >> 16) & 0xFFU]  ^ t[8][b >> 24] ^
+          t[7][c & 0xFFU]  ^ t[6][(c >> 8) & 0xFFU]  ^ t[5][(c >> 16) & 0xFFU]  ^ t[4][c >> 24] ^
+          t[3][d & 0xFFU]  ^ t[2][(d >> 8) & 0xFFU]  ^ t[1][(d >> 16) & 0xFFU]  ^ t[0][d >> 24];
   }
-  
-  uint32_t hash = 0xFFFFFFFFU;
-  for (size_t i = 0; i < len; ++i){
-    uint32_t idx = (hash ^ data[i]) & 0xFFU;
-    hash = (hash >> 8U) ^ crctable[idx];
+  if (len >= 8){
+    uint32_t a = crc_load32(data) ^ crc, b = crc_load32(data + 4);
+    crc = t[7][a & 0xFFU] ^ t[6][(a >> 8) & 0xFFU] ^ t[5][(a >> 16) & 0xFFU] ^ t[4][a >> 24] ^
+          t[3][b & 0xFFU] ^ t[2][(b >> 8) & 0xFFU] ^ t[1][(b >> 16) & 0xFFU] ^ t[0][b >> 24];
+    data += 8;
+    len -= 8;
   }
-  hash ^= 0xFFFFFFFFU;
-  return hash;
+  for (size_t i = 0; i < len; ++i)
+    crc = (crc >> 8U) ^ t[0][(crc ^ data[i]) & 0xFFU];
+  return crc;
 }
+
+#ifdef HASH_X86
+
+HASH_SSE42 inline uint32_t crc32c_update_sse42(uint32_t crc, const uint8_t* data, size_t len){
+#ifdef __x86_64__
+  uint64_t c = crc;
+  for (; len >= 8; data += 8, len -= 8){
+    uint64_t v;
+    memcpy(&v, data, sizeof(v));
+    c = _mm_crc32_u64(c, v);
+  }
+  crc = (uint32_t)c;
+#endif
+  for (; len >= 4; data += 4, len -= 4)
+    crc = _mm_crc32_u32(crc, crc_load32(data));
+  for (size_t i = 0; i < len; ++i)
+    crc = _mm_crc32_u8(crc, data[i]);
+  return crc;
+}
+
+/* folding constant for a distance of n bits: x^n mod P, bit reflected and shifted up by one,
+ * so that the carry-less product of a reflected 64 bit half and the constant lines up with
+ * the reflected 128 bit block it is added to */
+constexpr uint32_t crc_reflect(uint32_t v){
+  uint32_t r = 0;
+  for (size_t i = 0; i < 32; ++i, v >>= 1)
+    r = (r << 1) | (v & 0x1U);
+  return r;
+}
+constexpr uint64_t crc_fold_constant(uint32_t poly, size_t n){
+  uint32_t p = crc_reflect(poly), r = 1; //x^0, most significant bit first
+  for (size_t i = 0; i < n; ++i)
+    r = (r << 1) ^ ((r & 0x80000000U) ? p : 0U);
+  return (uint64_t)crc_reflect(r) << 1;
+}
+
+//x * x^d: the low half is the high degree one and moves by d + 32 bits, the high half by d - 32
+HASH_PCLMUL inline __m128i crc_fold16(__m128i x, __m128i k){
+  return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+/* fold the first len / 16 * 16 bytes (at least 64) into 16 bytes with the same crc, written to
+ * rem; the crc of the data goes into the first 4 bytes */
+template <uint32_t POLY>
+HASH_PCLMUL void crc_fold_pclmul(uint32_t crc, const uint8_t* data, size_t len, uint8_t* rem){
+  constexpr uint64_t K4LO = crc_fold_constant(POLY, 4 * 128 + 32), K4HI = crc_fold_constant(POLY, 4 * 128 - 32);
+  constexpr uint64_t K1LO = crc_fold_constant(POLY, 128 + 32),     K1HI = crc_fold_constant(POLY, 128 - 32);
+  const __m128i k4 = _mm_set_epi64x((long long)K4HI, (long long)K4LO);
+  const __m128i k1 = _mm_set_epi64x((long long)K1HI, (long long)K1LO);
+  const __m128i* p = (const __m128i*)data;
+
+  __m128i x0 = _mm_xor_si128(_mm_loadu_si128(p), _mm_cvtsi32_si128(crc));
+  __m128i x1 = _mm_loadu_si128(p + 1);
+  __m128i x2 = _mm_loadu_si128(p + 2);
+  __m128i x3 = _mm_loadu_si128(p + 3);
+  p += 4;
+  len -= 64;
+  for (; len >= 64; p += 4, len -= 64){
+    x0 = _mm_xor_si128(crc_fold16(x0, k4), _mm_loadu_si128(p));
+    x1 = _mm_xor_si128(crc_fold16(x1, k4), _mm_loadu_si128(p + 1));
+    x2 = _mm_xor_si128(crc_fold16(x2, k4), _mm_loadu_si128(p + 2));
+    x3 = _mm_xor_si128(crc_fold16(x3, k4), _mm_loadu_si128(p + 3));
+  }
+  x0 = _mm_xor_si128(crc_fold16(x0, k1), x1);
+  x0 = _mm_xor_si128(crc_fold16(x0, k1), x2);
+  x0 = _mm_xor_si128(crc_fold16(x0, k1), x3);
+  for (; len >= 16; ++p, len -= 16)
+    x0 = _mm_xor_si128(crc_fold16(x0, k1), _mm_loadu_si128(p));
+  _mm_storeu_si128((__m128i*)rem, x0);
+}
+
+#endif//HASH_X86
+
+template <uint32_t POLY>
+uint32_t crc_update_small(uint32_t crc, const uint8_t* data, size_t len){
+#ifdef HASH_X86
+  if (POLY == CRC32C_POLY && hash_has_sse42())
+    return crc32c_update_sse42(crc, data, len);
+#endif
+  return crc_update_table<POLY>(crc, data, len);
+}
+
+template <uint32_t POLY>
+uint32_t crc_update(uint32_t crc, const uint8_t* data, size_t len){
+#ifdef HASH_X86
+  if (len >= CRC_FOLD_MIN && hash_has_pclmul()){
+    uint8_t rem[16];
+    size_t nfold = len & ~(size_t)15;
+    crc_fold_pclmul<POLY>(crc, data, len, rem);
+    crc = crc_update_small<POLY>(0U, rem, sizeof(rem));
+    return crc_update_small<POLY>(crc, data + nfold, len - nfold);
+  }
+#endif
+  return crc_update_small<POLY>(crc, data, len);
+}
+
+/* running crc of data given in pieces, finalize() can be called at any point and does not
+ * end the stream */
+template <uint32_t POLY>
+class CRCStream {
+  uint32_t mCRC;
+public:
+  CRCStream(): mCRC(0xFFFFFFFFU) {}
+  explicit CRCStream(uint32_t crc): mCRC(~crc) {}
+
+  void reset(){ mCRC = 0xFFFFFFFFU; }
+  CRCStream& update(const uint8_t* data, size_t len){
+    mCRC = crc_update<POLY>(mCRC, data, len);
+    return *this;
+  }
+  uint32_t finalize() const { return ~mCRC; }
+};
+
+using CRC32Stream     = CRCStream<CRC_CCITT_POLY>;
+using CRC32IEEEStream = CRCStream<CRC32_IEEE_POLY>;
+using CRC32CStream    = CRCStream<CRC32C_POLY>;
+
+inline uint32_t crc32(const uint8_t* data, size_t len, uint32_t /*seed not used*/ = 0){
+  return ~crc_update<CRC_CCITT_POLY>(0xFFFFFFFFU, data, len);
+}
+
+inline uint32_t crc32_ieee(const uint8_t* data, size_t len, uint32_t crc = 0){
+  return ~crc_update<CRC32_IEEE_POLY>(~crc, data, len);
+}
+
+inline uint32_t crc32c(const uint8_t* data, size_t len, uint32_t crc = 0){
+  return ~crc_update<CRC32C_POLY>(~crc, data, len);
+}
+
+#endif//HASH_CRC
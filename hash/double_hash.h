@@ -0,0 +1,58 @@
+#ifndef HASH_DOUBLE_HASH
+#define HASH_DOUBLE_HASH
+
+#include <cstddef>
+#include <cstdint>
+
+#include "murmur.h"
+
+/* Double Hashing
+ *
+ * a Bloom filter or count-min sketch needs k indexes per key; instead of k hash functions
+ * they are derived from the two halves of one wide digest (Kirsch and Mitzenmacher), with
+ * the cubic term of enhanced double hashing (Dillinger and Manolios) so that a small or
+ * even h2 does not make the indexes repeat:
+ *
+ *   g(i) = h1 + i * h2 + (i^3 - i) / 6   mod 2^64
+ *
+ * the false positive rate is that of k independent hashes. g(i) is mapped to [0, m) by
+ * multiplying and keeping the high 64 bits, which is uniform and needs no division.
+ */
+
+__extension__ typedef unsigned __int128 hash_uint128;
+
+inline uint64_t hash_range(uint64_t h, uint64_t m){
+  return (uint64_t)(((hash_uint128)h * m) >> 64U);
+}
+
+class DoubleHash {
+  uint64_t mX;
+  uint64_t mY;
+  uint64_t mI;
+public:
+  DoubleHash(uint64_t h1, uint64_t h2): mX(h1), mY(h2), mI(0) {}
+  explicit DoubleHash(const Hash128& h): DoubleHash(h.h1, h.h2) {}
+  //a single 64 bit digest, e.g. jenkins64; h2 is a remix of it
+  explicit DoubleHash(uint64_t h): DoubleHash(h, murmur3_fmix64(h ^ 0x9E3779B97F4A7C15ULL)) {}
+
+  //the next raw 64 bit hash g(i)
+  uint64_t next(){
+    uint64_t r = mX;
+    mX += mY;
+    mY += ++mI;
+    return r;
+  }
+  //the next index in [0, m)
+  uint64_t next(uint64_t m){
+    return hash_range(next(), m);
+  }
+};
+
+//idx[0..k) in [0, m) from one digest
+inline void double_hash(const Hash128& h, size_t k, uint64_t m, uint64_t* idx){
+  DoubleHash g(h);
+  for (size_t i = 0; i < k; ++i)
+    idx[i] = g.next(m);
+}
+
+#endif//HASH_DOUBLE_HASH
@@ -1,6 +1,10 @@
+#ifndef HASH_FNV
+#define HASH_FNV
+
 #include <cassert>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 // Fowler-Noll-Vo hash functions
 
 constexpr uint64_t fnv_basis64 = 0xCBF29CE484222325ULL;
@@ -15,7 +19,7 @@ constexpr uint32_t fnv_basis32 = 0x811C9DC5U;
 constexpr uint64_t fnv_prime64 = 0x100000001B3ULL;
 constexpr uint32_t fnv_prime32 = 0x1000193U;
 
-uint64_t fnv1_64(const uint8_t* data, size_t len){
+inline uint64_t fnv1_64(const uint8_t* data, size_t len){
   const uint64_t* data64 = (const uint64_t*)data;
   size_t len64 = (len & (~0x7ull)) / 8;
   uint64_t hash = fnv_basis64;
@@ -42,7 +46,7 @@ uint64_t fnv1_64(const uint8_t* data, size_t len){
   return hash;
 }
 
-uint32_t fnv1_32(const uint8_t* data, size_t len){
+inline uint32_t fnv1_32(const uint8_t* data, size_t len){
   const uint32_t* data32 = (const uint32_t*)data;
   size_t len32 = (len & (~0x3ULL)) / 4;
   uint64_t hash = fnv_basis32;
@@ -65,7 +69,7 @@ uint32_t fnv1_32(const uint8_t* data, size_t len){
   return hash;
 }
 
-uint64_t fnv1a_64(const uint8_t* data, size_t len){
+inline uint64_t fnv1a_64(const uint8_t* data, size_t len){
   const uint64_t* data64 = (const uint64_t*)data;
   size_t len64 = (len & (~0x7ull)) / 8;
   uint64_t hash = fnv_basis64;
@@ -92,7 +96,7 @@ uint64_t fnv1a_64(const uint8_t* data, size_t len){
   return hash;
 }
 
-uint32_t fnv1a_32(const uint8_t* data, size_t len){
+inline uint32_t fnv1a_32(const uint8_t* data, size_t len){
   const uint32_t* data32 = (const uint32_t*)data;
   size_t len32 = (len & (~0x3ULL)) / 4;
   uint64_t hash = fnv_basis32;
@@ -114,3 +118,73 @@ uint32_t fnv1a_32(const uint8_t* data, size_t len){
   }
   return hash;
 }
+
+/* incremental FNV: update() takes the data in pieces of any size and finalize() gives what
+ * the one shot function returns for all of it. like the one shot functions the stream
+ * consumes whole words of U, up to sizeof(U) - 1 bytes are held until the next update.
+ * XOR_FIRST is FNV-1a. finalize() can be called at any point and does not end the stream */
+template <typename U> struct FNVParam;
+template <> struct FNVParam<uint32_t> {
+  static constexpr uint32_t basis = fnv_basis32;
+  static constexpr uint32_t prime = fnv_prime32;
+};
+template <> struct FNVParam<uint64_t> {
+  static constexpr uint64_t basis = fnv_basis64;
+  static constexpr uint64_t prime = fnv_prime64;
+};
+
+template <typename U, bool XOR_FIRST>
+class FNVStream {
+  U mHash;
+  U mTail;     //the last mLen % sizeof(U) bytes, little endian
+  size_t mLen;
+
+  static U step(U hash, U k){
+    if (XOR_FIRST){
+      hash ^= k;
+      hash *= FNVParam<U>::prime;
+    } else {
+      hash *= FNVParam<U>::prime;
+      hash ^= k;
+    }
+    return hash;
+  }
+public:
+  FNVStream(): mHash(FNVParam<U>::basis), mTail(0), mLen(0) {}
+
+  void reset(){
+    mHash = FNVParam<U>::basis;
+    mTail = 0;
+    mLen = 0;
+  }
+  FNVStream& update(const uint8_t* data, size_t len){
+    size_t nb = mLen % sizeof(U);
+    mLen += len;
+    for (; nb != 0 && len > 0; --len){
+      mTail |= (U)*data++ << (nb * 8U);
+      if (++nb == sizeof(U)){
+        mHash = step(mHash, mTail);
+        mTail = 0;
+        nb = 0;
+      }
+    }
+    for (; len >= sizeof(U); data += sizeof(U), len -= sizeof(U)){
+      U k;
+      memcpy(&k, data, sizeof(k));
+      mHash = step(mHash, k);
+    }
+    for (size_t i = 0; i < len; ++i)
+      mTail |= (U)data[i] << (i * 8U);
+    return *this;
+  }
+  U finalize() const {
+    return mLen % sizeof(U) ? step(mHash, mTail) : mHash;
+  }
+};
+
+using FNV1_32Stream  = FNVStream<uint32_t, false>;
+using FNV1a_32Stream = FNVStream<uint32_t, true>;
+using FNV1_64Stream  = FNVStream<uint64_t, false>;
+using FNV1a_64Stream = FNVStream<uint64_t, true>;
+
+#endif//HASH_FNV
@@ -0,0 +1,352 @@
+#ifndef HASH_BATCH
+#define HASH_BATCH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "murmur.h"
+#include "jenkins.h"
+#include "fnv.h"
+#include "hash_cpu.h"
+
+/* Multi-Buffer Batch Hashing
+ *
+ * hashing one short key is a chain of dependent multiplications and rotations, the CPU
+ * spends most of the time waiting on the previous step. a batch hashes 8 independent keys
+ * at once in the 8 32-bit lanes of an AVX2 register: 32 bytes of every key are loaded and
+ * transposed so that word w of all 8 keys sits in one register, and the 8 chains go through
+ * each step of the hash together. keys of 4 to 11 bytes skip the transpose, a gather puts a
+ * word of all 8 keys in a register directly.
+ *
+ * keys of a group of 8 may have different lengths, a lane whose key has run out of words is
+ * masked and keeps its value while the others go on; groups of keys of similar length waste
+ * the least. the last 1 to 3 bytes of every key are read one at a time or as the word that
+ * ends with the key, so the batch never reads past the end of a key.
+ *
+ * the digests are exactly those of murmur3, jenkins, fnv1_32 and fnv1a_32. without AVX2 at
+ * runtime the batch calls those one key at a time.
+ *
+ *   xxx_batch(keys, lens, n, out):  key i is lens[i] bytes at keys[i]
+ *   xxx_batch(data, len, n, out):   key i is len bytes at data + i * len
+ *
+ * keys must be shorter than 2GB.
+ */
+
+#ifdef HASH_X86
+
+/* one step of each hash on 8 lanes:
+ *   init:  state before the first word
+ *   body:  state after a full 4 byte word
+ *   tail:  state after the last 1 to 3 bytes, zero extended to a word, nb is their count
+ *   final: digest of the state, len is the key length */
+struct Murmur3Lanes {
+  HASH_AVX2 static __m256i rotl(__m256i x, int r){
+    return _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r));
+  }
+  HASH_AVX2 static __m256i mix(__m256i k){
+    k = _mm256_mullo_epi32(k, _mm256_set1_epi32(0xCC9E2D51));
+    k = rotl(k, 15);
+    return _mm256_mullo_epi32(k, _mm256_set1_epi32(0x1B873593));
+  }
+  HASH_AVX2 static __m256i init(uint32_t seed){
+    return _mm256_set1_epi32(seed);
+  }
+  HASH_AVX2 static __m256i body(__m256i h, __m256i k){
+    h = _mm256_xor_si256(h, mix(k));
+    h = rotl(h, 13);
+    return _mm256_add_epi32(_mm256_mullo_epi32(h, _mm256_set1_epi32(5)), _mm256_set1_epi32(0xE6546B64));
+  }
+  HASH_AVX2 static __m256i tail(__m256i h, __m256i k, __m256i){
+    return _mm256_xor_si256(h, mix(k));
+  }
+  HASH_AVX2 static __m256i final(__m256i h, __m256i len){
+    h = _mm256_xor_si256(h, len);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x85EBCA6B));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0xC2B2AE35));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+  }
+};
+
+//one at a time, a word is 4 single byte steps
+struct JenkinsLanes {
+  HASH_AVX2 static __m256i step(__m256i h, __m256i b){
+    h = _mm256_add_epi32(h, b);
+    h = _mm256_add_epi32(h, _mm256_slli_epi32(h, 10));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 6));
+  }
+  HASH_AVX2 static __m256i byte(__m256i k, int i){
+    return _mm256_and_si256(_mm256_srli_epi32(k, 8 * i), _mm256_set1_epi32(0xFF));
+  }
+  HASH_AVX2 static __m256i init(uint32_t seed){
+    return _mm256_set1_epi32(seed);
+  }
+  HASH_AVX2 static __m256i body(__m256i h, __m256i k){
+    for (int i = 0; i < 4; ++i)
+      h = step(h, byte(k, i));
+    return h;
+  }
+  HASH_AVX2 static __m256i tail(__m256i h, __m256i k, __m256i nb){
+    for (int i = 0; i < 3; ++i){
+      __m256i on = _mm256_cmpgt_epi32(nb, _mm256_set1_epi32(i));
+      h = _mm256_blendv_epi8(h, step(h, byte(k, i)), on);
+    }
+    return h;
+  }
+  HASH_AVX2 static __m256i final(__m256i h, __m256i){
+    h = _mm256_add_epi32(h, _mm256_slli_epi32(h, 3));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 11));
+    return _mm256_add_epi32(h, _mm256_slli_epi32(h, 15));
+  }
+};
+
+//fnv1_32 and fnv1a_32 keep a 64 bit state but only its low 32 bits reach the digest, and the
+//low bits of a product only depend on the low bits of its factors
+template <bool XOR_FIRST>
+struct FNV32Lanes {
+  HASH_AVX2 static __m256i init(uint32_t){
+    return _mm256_set1_epi32(fnv_basis32);
+  }
+  HASH_AVX2 static __m256i body(__m256i h, __m256i k){
+    const __m256i p = _mm256_set1_epi32(fnv_prime32);
+    if (XOR_FIRST) return _mm256_mullo_epi32(_mm256_xor_si256(h, k), p);
+    else           return _mm256_xor_si256(_mm256_mullo_epi32(h, p), k);
+  }
+  HASH_AVX2 static __m256i tail(__m256i h, __m256i k, __m256i nb){
+    __m256i on = _mm256_cmpgt_epi32(nb, _mm256_setzero_si256());
+    return _mm256_blendv_epi8(h, body(h, k), on);
+  }
+  HASH_AVX2 static __m256i final(__m256i h, __m256i){
+    return h;
+  }
+};
+
+//8 x 8 words: r[l] holds words 0..7 of lane l on the way in, word l of lanes 0..7 on the way out
+HASH_AVX2 inline void hash_transpose8(__m256i* r){
+  __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]), t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+  __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]), t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+  __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]), t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+  __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]), t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+  __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+  __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+  __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+  __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+  r[0] = _mm256_permute2x128_si256(u0, u4, 0x20); r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+  r[1] = _mm256_permute2x128_si256(u1, u5, 0x20); r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+  r[2] = _mm256_permute2x128_si256(u2, u6, 0x20); r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+  r[3] = _mm256_permute2x128_si256(u3, u7, 0x20); r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+//the last n & 3 bytes of a key of n bytes at p, zero extended to a word
+inline uint32_t hash_tail_word(const uint8_t* p, size_t n){
+  p += n & ~(size_t)3;
+  uint32_t t = 0;
+  switch (n & 3){
+  case 3: t |= (uint32_t)p[2] << 16; [[fallthrough]];
+  case 2: t |= (uint32_t)p[1] << 8;  [[fallthrough]];
+  case 1: t |= (uint32_t)p[0];
+  }
+  return t;
+}
+
+/* hash 8 keys, key l is len[l] bytes at p[l]; all keys are the same length when UNIFORM.
+ *
+ * the keys are read 32 bytes at a time, one load per lane, and transposed so that register j
+ * holds word j of every lane; the words past the end of a key are masked off the load and
+ * never touched */
+template <typename H, bool UNIFORM>
+HASH_AVX2 __m256i hash_lanes_avx2(const uint8_t* const* p, const int32_t* len, uint32_t seed){
+  alignas(32) int32_t tl[8];
+  int32_t minw = len[0] >> 2, maxw = minw;
+  for (size_t l = 0; l < 8; ++l){
+    if (not UNIFORM){
+      minw = std::min(minw, len[l] >> 2);
+      maxw = std::max(maxw, len[l] >> 2);
+    }
+    tl[l] = (int32_t)hash_tail_word(p[l], len[l]);
+  }
+
+  __m256i vlen = _mm256_loadu_si256((const __m256i*)len);
+  __m256i vnw = _mm256_srli_epi32(vlen, 2);
+  const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i h = H::init(seed);
+  __m256i k[8];
+  int32_t i = 0;
+  //every lane has 8 more words
+  for (; i + 8 <= minw; i += 8){
+    for (size_t l = 0; l < 8; ++l)
+      k[l] = _mm256_loadu_si256((const __m256i*)(p[l] + 4 * i));
+    hash_transpose8(k);
+    for (size_t j = 0; j < 8; ++j)
+      h = H::body(h, k[j]);
+  }
+  //some lanes have fewer than 8 words left
+  for (; i < maxw; i += 8){
+    __m256i m = _mm256_cmpgt_epi32(_mm256_set1_epi32(minw - i), iota);
+    for (size_t l = 0; l < 8; ++l){
+      if (not UNIFORM) m = _mm256_cmpgt_epi32(_mm256_set1_epi32((len[l] >> 2) - i), iota);
+      k[l] = _mm256_maskload_epi32((const int*)(p[l] + 4 * i), m);
+    }
+    hash_transpose8(k);
+    for (int32_t j = 0; j < 8 && i + j < maxw; ++j){
+      if (i + j < minw) h = H::body(h, k[j]);
+      else              h = _mm256_blendv_epi8(h, H::body(h, k[j]), _mm256_cmpgt_epi32(vnw, _mm256_set1_epi32(i + j)));
+    }
+  }
+  h = H::tail(h, _mm256_load_si256((const __m256i*)tl), _mm256_and_si256(vlen, _mm256_set1_epi32(3)));
+  return H::final(h, vlen);
+}
+
+/* keys of 4 to 11 bytes have at most 2 whole words, too few to pay for the transpose. they are
+ * gathered straight into the lanes instead, a word of all 8 keys at once; the tail is the last
+ * word of each key shifted down past the bytes hashed already, so no read goes past the end of
+ * a key.
+ *
+ * keys of len bytes at p, p + len, ..., p + 7 * len are offsets from p, given by pointer the
+ * keys are the 64 bit indices of two gathers of 4 lanes each */
+template <typename H>
+HASH_AVX2 __m256i hash_short_avx2(const uint8_t* p, int32_t len, uint32_t seed){
+  const __m256i at = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(len));
+  __m256i h = H::init(seed);
+  for (int32_t j = 0; j < (len >> 2); ++j)
+    h = H::body(h, _mm256_i32gather_epi32((const int*)p, _mm256_add_epi32(at, _mm256_set1_epi32(4 * j)), 1));
+  if (int32_t nb = len & 3){
+    __m256i k = _mm256_i32gather_epi32((const int*)p, _mm256_add_epi32(at, _mm256_set1_epi32(len - 4)), 1);
+    h = H::tail(h, _mm256_srli_epi32(k, 32 - 8 * nb), _mm256_set1_epi32(nb));
+  }
+  return H::final(h, _mm256_set1_epi32(len));
+}
+
+HASH_AVX2 inline __m256i hash_gather8(const __m256i* at, __m256i m){
+  __m128i k0 = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), (const int*)0, at[0], _mm256_castsi256_si128(m), 1);
+  __m128i k1 = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), (const int*)0, at[1], _mm256_extracti128_si256(m, 1), 1);
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(k0), k1, 1);
+}
+
+//vlen holds the 8 lengths as 32 bit lanes
+template <typename H>
+HASH_AVX2 __m256i hash_short_avx2(const uint8_t* const* p, const size_t* lens, __m256i vlen, uint32_t seed){
+  __m256i at[2], end[2];
+  for (size_t g = 0; g < 2; ++g){
+    at[g] = _mm256_loadu_si256((const __m256i*)(p + 4 * g));
+    end[g] = _mm256_add_epi64(at[g], _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(lens + 4 * g)), _mm256_set1_epi64x(4)));
+  }
+  const __m256i all = _mm256_set1_epi32(-1);
+  __m256i h = H::body(H::init(seed), hash_gather8(at, all));
+  __m256i two = _mm256_cmpgt_epi32(vlen, _mm256_set1_epi32(7));
+  if (not _mm256_testz_si256(two, two)){
+    for (size_t g = 0; g < 2; ++g)
+      at[g] = _mm256_add_epi64(at[g], _mm256_set1_epi64x(4));
+    h = _mm256_blendv_epi8(h, H::body(h, hash_gather8(at, two)), two);
+  }
+  //a lane without a tail shifts its word out entirely
+  __m256i nb = _mm256_and_si256(vlen, _mm256_set1_epi32(3));
+  __m256i k = _mm256_srlv_epi32(hash_gather8(end, all), _mm256_sub_epi32(_mm256_set1_epi32(32), _mm256_slli_epi32(nb, 3)));
+  return H::final(H::tail(h, k, nb), vlen);
+}
+
+//lanes past the last key hash the first key of the group again, their digests are dropped
+template <typename H>
+HASH_AVX2 void hash_batch_avx2(const uint8_t* const* keys, const size_t* lens, size_t n, uint32_t* out, uint32_t seed){
+  const uint8_t* p[8];
+  int32_t len[8];
+  alignas(32) uint32_t res[8];
+  const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  for (size_t i = 0; i < n; i += 8){
+    size_t w = std::min((size_t)8, n - i);
+    if (w == 8){
+      __m256i l0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(lens + i)), low);
+      __m256i l1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(lens + i + 4)), low);
+      __m256i vlen = _mm256_blend_epi32(l0, l1, 0xF0);
+      __m256i shrt = _mm256_and_si256(_mm256_cmpgt_epi32(vlen, _mm256_set1_epi32(3)), _mm256_cmpgt_epi32(_mm256_set1_epi32(12), vlen));
+      if (_mm256_movemask_ps(_mm256_castsi256_ps(shrt)) == 0xFF){
+        _mm256_storeu_si256((__m256i*)(out + i), hash_short_avx2<H>(keys + i, lens + i, vlen, seed));
+        continue;
+      }
+    }
+    for (size_t l = 0; l < 8; ++l){
+      p[l] = keys[i + (l < w ? l : 0)];
+      len[l] = (int32_t)lens[i + (l < w ? l : 0)];
+    }
+    __m256i h = hash_lanes_avx2<H, false>(p, len, seed);
+    if (w == 8) _mm256_storeu_si256((__m256i*)(out + i), h);
+    else {
+      _mm256_store_si256((__m256i*)res, h);
+      std::copy(res, res + w, out + i);
+    }
+  }
+}
+
+template <typename H>
+HASH_AVX2 void hash_batch_avx2(const uint8_t* data, size_t len, size_t n, uint32_t* out, uint32_t seed){
+  const uint8_t* p[8];
+  int32_t lens[8];
+  std::fill(lens, lens + 8, (int32_t)len);
+  alignas(32) uint32_t res[8];
+  size_t i = 0;
+  if (len >= 4 && len < 12)
+    for (; i + 8 <= n; i += 8)
+      _mm256_storeu_si256((__m256i*)(out + i), hash_short_avx2<H>(data + i * len, (int32_t)len, seed));
+  for (; i < n; i += 8){
+    size_t w = std::min((size_t)8, n - i);
+    for (size_t l = 0; l < 8; ++l)
+      p[l] = data + (i + (l < w ? l : 0)) * len;
+    __m256i h = hash_lanes_avx2<H, true>(p, lens, seed);
+    if (w == 8) _mm256_storeu_si256((__m256i*)(out + i), h);
+    else {
+      _mm256_store_si256((__m256i*)res, h);
+      std::copy(res, res + w, out + i);
+    }
+  }
+}
+
+#endif//HASH_X86
+
+#ifdef HASH_X86
+#define HASH_BATCH_AVX2(H, ...) if (hash_has_avx2()){ hash_batch_avx2<H>(__VA_ARGS__); return; }
+#else
+#define HASH_BATCH_AVX2(H, ...)
+#endif
+
+inline void murmur3_batch(const uint8_t* const* keys, const size_t* lens, size_t n, uint32_t* out, uint32_t seed = 0){
+  HASH_BATCH_AVX2(Murmur3Lanes, keys, lens, n, out, seed);
+  for (size_t i = 0; i < n; ++i) out[i] = murmur3(keys[i], lens[i], seed);
+}
+inline void murmur3_batch(const uint8_t* data, size_t len, size_t n, uint32_t* out, uint32_t seed = 0){
+  HASH_BATCH_AVX2(Murmur3Lanes, data, len, n, out, seed);
+  for (size_t i = 0; i < n; ++i) out[i] = murmur3(data + i * len, len, seed);
+}
+
+inline void jenkins_batch(const uint8_t* const* keys, const size_t* lens, size_t n, uint32_t* out, uint32_t seed = 0){
+  HASH_BATCH_AVX2(JenkinsLanes, keys, lens, n, out, seed);
+  for (size_t i = 0; i < n; ++i) out[i] = jenkins(keys[i], lens[i], seed);
+}
+inline void jenkins_batch(const uint8_t* data, size_t len, size_t n, uint32_t* out, uint32_t seed = 0){
+  HASH_BATCH_AVX2(JenkinsLanes, data, len, n, out, seed);
+  for (size_t i = 0; i < n; ++i) out[i] = jenkins(data + i * len, len, seed);
+}
+
+inline void fnv1_32_batch(const uint8_t* const* keys, const size_t* lens, size_t n, uint32_t* out){
+  HASH_BATCH_AVX2(FNV32Lanes<false>, keys, lens, n, out, 0);
+  for (size_t i = 0; i < n; ++i) out[i] = fnv1_32(keys[i], lens[i]);
+}
+inline void fnv1_32_batch(const uint8_t* data, size_t len, size_t n, uint32_t* out){
+  HASH_BATCH_AVX2(FNV32Lanes<false>, data, len, n, out, 0);
+  for (size_t i = 0; i < n; ++i) out[i] = fnv1_32(data + i * len, len);
+}
+
+inline void fnv1a_32_batch(const uint8_t* const* keys, const size_t* lens, size_t n, uint32_t* out){
+  HASH_BATCH_AVX2(FNV32Lanes<true>, keys, lens, n, out, 0);
+  for (size_t i = 0; i < n; ++i) out[i] = fnv1a_32(keys[i], lens[i]);
+}
+inline void fnv1a_32_batch(const uint8_t* data, size_t len, size_t n, uint32_t* out){
+  HASH_BATCH_AVX2(FNV32Lanes<true>, data, len, n, out, 0);
+  for (size_t i = 0; i < n; ++i) out[i] = fnv1a_32(data + i * len, len);
+}
+
+#undef HASH_BATCH_AVX2
+
+#endif//HASH_BATCH
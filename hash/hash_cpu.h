@@ -0,0 +1,46 @@
+#ifndef HASH_CPU
+#define HASH_CPU
+
+/* CPU Feature Detection
+ *
+ * the accelerated paths of the hash functions and the filters built on them are compiled for
+ * their instruction set with a target attribute and picked at runtime, the rest of the code
+ * stays baseline x86-64 and runs everywhere.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASH_X86
+#define HASH_AVX2 __attribute__((target("avx2")))
+#define HASH_SSE42 __attribute__((target("sse4.2")))
+#define HASH_PCLMUL __attribute__((target("sse4.2,pclmul")))
+#endif
+
+inline bool hash_has_avx2(){
+#ifdef HASH_X86
+  static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+inline bool hash_has_sse42(){
+#ifdef HASH_X86
+  static const bool sse42 = (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2"));
+  return sse42;
+#else
+  return false;
+#endif
+}
+
+inline bool hash_has_pclmul(){
+#ifdef HASH_X86
+  static const bool pclmul = (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul"));
+  return pclmul;
+#else
+  return false;
+#endif
+}
+
+#endif//HASH_CPU
@@ -1,8 +1,12 @@
+#ifndef HASH_JENKINS
+#define HASH_JENKINS
+
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 // Jenkins Hash Function
 
-uint32_t jenkins(const uint8_t* key, size_t len, uint32_t seed = 0U){
+inline uint32_t jenkins(const uint8_t* key, size_t len, uint32_t seed = 0U){
   uint32_t hash = seed;
   for (size_t i = 0; i < len; ++i){
     hash += key[i];
@@ -14,3 +18,91 @@ uint32_t jenkins(const uint8_t* key, size_t len, uint32_t seed = 0U){
   hash += hash << 15U;
   return hash;
 }
+
+/* incremental jenkins one at a time, byte by byte like jenkins(); the final avalanche is
+ * applied by finalize(), which can be called at any point and does not end the stream */
+class JenkinsStream {
+  uint32_t mHash;
+public:
+  explicit JenkinsStream(uint32_t seed = 0U): mHash(seed) {}
+
+  void reset(uint32_t seed = 0U){ mHash = seed; }
+  JenkinsStream& update(const uint8_t* data, size_t len){
+    uint32_t hash = mHash;
+    for (size_t i = 0; i < len; ++i){
+      hash += data[i];
+      hash += hash << 10U;
+      hash ^= hash >> 6U;
+    }
+    mHash = hash;
+    return *this;
+  }
+  uint32_t finalize() const {
+    uint32_t hash = mHash;
+    hash += hash << 3U;
+    hash ^= hash >> 11U;
+    hash += hash << 15U;
+    return hash;
+  }
+};
+
+/* Jenkins lookup3, 64 bit: hashlittle2 of Bob Jenkins' lookup3.c, which mixes 12 bytes per
+ * round into three 32 bit words and returns two of them. the low half of the seed is the
+ * reference's *pc and the high half *pb, the digest is c in the low and b in the high half */
+inline uint32_t jenkins_rotl(uint32_t x, unsigned r){
+  return (x << r) | (x >> (32U - r));
+}
+
+inline void jenkins_mix(uint32_t& a, uint32_t& b, uint32_t& c){
+  a -= c; a ^= jenkins_rotl(c, 4U);  c += b;
+  b -= a; b ^= jenkins_rotl(a, 6U);  a += c;
+  c -= b; c ^= jenkins_rotl(b, 8U);  b += a;
+  a -= c; a ^= jenkins_rotl(c, 16U); c += b;
+  b -= a; b ^= jenkins_rotl(a, 19U); a += c;
+  c -= b; c ^= jenkins_rotl(b, 4U);  b += a;
+}
+
+inline void jenkins_final(uint32_t& a, uint32_t& b, uint32_t& c){
+  c ^= b; c -= jenkins_rotl(b, 14U);
+  a ^= c; a -= jenkins_rotl(c, 11U);
+  b ^= a; b -= jenkins_rotl(a, 25U);
+  c ^= b; c -= jenkins_rotl(b, 16U);
+  a ^= c; a -= jenkins_rotl(c, 4U);
+  b ^= a; b -= jenkins_rotl(a, 14U);
+  c ^= b; c -= jenkins_rotl(b, 24U);
+}
+
+inline uint64_t jenkins64(const uint8_t* key, size_t len, uint64_t seed = 0ULL){
+  uint32_t a, b, c;
+  a = b = c = 0xDEADBEEFU + (uint32_t)len + (uint32_t)seed;
+  c += (uint32_t)(seed >> 32U);
+
+  for (; len > 12; key += 12, len -= 12){
+    uint32_t w[3];
+    memcpy(w, key, sizeof(w));
+    a += w[0];
+    b += w[1];
+    c += w[2];
+    jenkins_mix(a, b, c);
+  }
+  switch (len){
+  case 12: c += (uint32_t)key[11] << 24U; [[fallthrough]];
+  case 11: c += (uint32_t)key[10] << 16U; [[fallthrough]];
+  case 10: c += (uint32_t)key[9] << 8U;   [[fallthrough]];
+  case 9:  c += key[8];                   [[fallthrough]];
+  case 8:  b += (uint32_t)key[7] << 24U;  [[fallthrough]];
+  case 7:  b += (uint32_t)key[6] << 16U;  [[fallthrough]];
+  case 6:  b += (uint32_t)key[5] << 8U;   [[fallthrough]];
+  case 5:  b += key[4];                   [[fallthrough]];
+  case 4:  a += (uint32_t)key[3] << 24U;  [[fallthrough]];
+  case 3:  a += (uint32_t)key[2] << 16U;  [[fallthrough]];
+  case 2:  a += (uint32_t)key[1] << 8U;   [[fallthrough]];
+  case 1:  a += key[0];
+           jenkins_final(a, b, c);
+           break;
+  default: break; //empty key, no final mixing
+  }
+  return (uint64_t)c | ((uint64_t)b << 32U);
+}
+
+#endif//HASH_JENKINS
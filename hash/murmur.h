@@ -1,38 +1,27 @@
+#ifndef HASH_MURMUR
+#define HASH_MURMUR
+
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 // Murmur3 Hash Function
 
-uint32_t murmur3(const uint8_t* key, size_t len, uint32_t seed = 0){
-  uint32_t hash = seed;
-  size_t i = 0;
-  const uint32_t* key_x4 = (const uint32_t*)key;
-  if (len > 3UL){
-    size_t len_x4 = len >> 2U << 2U;
-    for (; i < len_x4; i += 4, ++key_x4){
-      uint32_t k = *key_x4;
-      k *= 0xCC9E2D51U;
-      k = (k << 15U) | (k >> 17U);
-      k *= 0x1B873593U;
-      hash ^= k;
-      hash = (hash << 13U) | (hash >> 19U);
-      hash = (hash * 5U) + 0xE6546B64U;
-    }
-  }
-  if (len & 3UL){
-    uint32_t k = *key_x4;
-    switch (len & 3UL){
-    case 3U: k &= 0xFFFFFFU; break;
-    case 2U: k &= 0xFFFFU;   break;
-    case 1U: k &= 0xFFU;     break;
-    default: assert(false);
-    }
-    k *= 0xCC9E2D51U;
-    k = (k << 15U) | (k >> 17U);
-    k *= 0x1B873593U;
-    hash ^= k;
-  }
+inline uint32_t murmur3_scramble(uint32_t k){
+  k *= 0xCC9E2D51U;
+  k = (k << 15U) | (k >> 17U);
+  k *= 0x1B873593U;
+  return k;
+}
+
+inline uint32_t murmur3_body(uint32_t hash, uint32_t k){
+  hash ^= murmur3_scramble(k);
+  hash = (hash << 13U) | (hash >> 19U);
+  return (hash * 5U) + 0xE6546B64U;
+}
+
+inline uint32_t murmur3_final(uint32_t hash, size_t len){
   hash ^= len;
   hash ^= hash >> 16U;
   hash *= 0x85EBCA6BU;
@@ -41,3 +30,134 @@ uint32_t murmur3(const uint8_t* key, size_t len, uint32_t seed = 0){
   hash ^= hash >> 16U;
   return hash;
 }
+
+inline uint32_t murmur3(const uint8_t* key, size_t len, uint32_t seed = 0){
+  uint32_t hash = seed;
+  size_t len_x4 = len >> 2U << 2U;
+  for (size_t i = 0; i < len_x4; i += 4){
+    uint32_t k;
+    memcpy(&k, key + i, sizeof(k));
+    hash = murmur3_body(hash, k);
+  }
+  //the tail is read a byte at a time, so nothing past key + len is touched
+  if (len & 3UL){
+    uint32_t k = 0;
+    for (size_t i = len_x4; i < len; ++i)
+      k |= (uint32_t)key[i] << ((i - len_x4) * 8U);
+    hash ^= murmur3_scramble(k);
+  }
+  return murmur3_final(hash, len);
+}
+
+/* incremental murmur3: the digest of data given in pieces is that of murmur3 over all of it.
+ * up to 3 bytes that do not make a whole word yet are held until the next update. finalize()
+ * can be called at any point and does not end the stream */
+class Murmur3Stream {
+  uint32_t mHash;
+  uint32_t mTail; //the last mLen % 4 bytes, little endian
+  size_t mLen;
+public:
+  explicit Murmur3Stream(uint32_t seed = 0): mHash(seed), mTail(0), mLen(0) {}
+
+  void reset(uint32_t seed = 0){
+    mHash = seed;
+    mTail = 0;
+    mLen = 0;
+  }
+  Murmur3Stream& update(const uint8_t* data, size_t len){
+    size_t nb = mLen & 3UL;
+    mLen += len;
+    for (; nb != 0 && len > 0; --len){
+      mTail |= (uint32_t)*data++ << (nb * 8U);
+      if (++nb == 4){
+        mHash = murmur3_body(mHash, mTail);
+        mTail = 0;
+        nb = 0;
+      }
+    }
+    for (; len >= 4; data += 4, len -= 4){
+      uint32_t k;
+      memcpy(&k, data, sizeof(k));
+      mHash = murmur3_body(mHash, k);
+    }
+    for (size_t i = 0; i < len; ++i)
+      mTail |= (uint32_t)data[i] << (i * 8U);
+    return *this;
+  }
+  uint32_t finalize() const {
+    uint32_t hash = mHash;
+    if (mLen & 3UL) hash ^= murmur3_scramble(mTail);
+    return murmur3_final(hash, mLen);
+  }
+};
+
+/* MurmurHash3 x64_128, the 128 bit variant tuned for 64 bit machines: two 64 bit lanes
+ * over 16 byte blocks. h1 and h2 are the two halves of the digest in the order of the
+ * reference implementation's output */
+struct Hash128 {
+  uint64_t h1;
+  uint64_t h2;
+};
+
+inline uint64_t murmur3_rotl64(uint64_t x, unsigned r){
+  return (x << r) | (x >> (64U - r));
+}
+
+inline uint64_t murmur3_fmix64(uint64_t k){
+  k ^= k >> 33U;
+  k *= 0xFF51AFD7ED558CCDULL;
+  k ^= k >> 33U;
+  k *= 0xC4CEB9FE1A85EC53ULL;
+  k ^= k >> 33U;
+  return k;
+}
+
+inline Hash128 murmur3_x64_128(const uint8_t* key, size_t len, uint32_t seed = 0){
+  constexpr uint64_t C1 = 0x87C37B91114253D5ULL;
+  constexpr uint64_t C2 = 0x4CF5AD432745937FULL;
+  uint64_t h1 = seed, h2 = seed;
+  size_t nblocks = len / 16;
+  for (size_t i = 0; i < nblocks; ++i, key += 16){
+    uint64_t k1, k2;
+    memcpy(&k1, key, sizeof(k1));
+    memcpy(&k2, key + 8, sizeof(k2));
+
+    k1 *= C1; k1 = murmur3_rotl64(k1, 31U); k1 *= C2; h1 ^= k1;
+    h1 = murmur3_rotl64(h1, 27U); h1 += h2; h1 = h1 * 5U + 0x52DCE729U;
+    k2 *= C2; k2 = murmur3_rotl64(k2, 33U); k2 *= C1; h2 ^= k2;
+    h2 = murmur3_rotl64(h2, 31U); h2 += h1; h2 = h2 * 5U + 0x38495AB5U;
+  }
+
+  uint64_t k1 = 0, k2 = 0;
+  switch (len & 15U){
+  case 15: k2 ^= (uint64_t)key[14] << 48U; [[fallthrough]];
+  case 14: k2 ^= (uint64_t)key[13] << 40U; [[fallthrough]];
+  case 13: k2 ^= (uint64_t)key[12] << 32U; [[fallthrough]];
+  case 12: k2 ^= (uint64_t)key[11] << 24U; [[fallthrough]];
+  case 11: k2 ^= (uint64_t)key[10] << 16U; [[fallthrough]];
+  case 10: k2 ^= (uint64_t)key[9] << 8U;   [[fallthrough]];
+  case 9:  k2 ^= (uint64_t)key[8];
+           k2 *= C2; k2 = murmur3_rotl64(k2, 33U); k2 *= C1; h2 ^= k2;
+           [[fallthrough]];
+  case 8:  k1 ^= (uint64_t)key[7] << 56U;  [[fallthrough]];
+  case 7:  k1 ^= (uint64_t)key[6] << 48U;  [[fallthrough]];
+  case 6:  k1 ^= (uint64_t)key[5] << 40U;  [[fallthrough]];
+  case 5:  k1 ^= (uint64_t)key[4] << 32U;  [[fallthrough]];
+  case 4:  k1 ^= (uint64_t)key[3] << 24U;  [[fallthrough]];
+  case 3:  k1 ^= (uint64_t)key[2] << 16U;  [[fallthrough]];
+  case 2:  k1 ^= (uint64_t)key[1] << 8U;   [[fallthrough]];
+  case 1:  k1 ^= (uint64_t)key[0];
+           k1 *= C1; k1 = murmur3_rotl64(k1, 31U); k1 *= C2; h1 ^= k1;
+           break;
+  default: break;
+  }
+
+  h1 ^= len; h2 ^= len;
+  h1 += h2; h2 += h1;
+  h1 = murmur3_fmix64(h1);
+  h2 = murmur3_fmix64(h2);
+  h1 += h2; h2 += h1;
+  return Hash128{h1, h2};
+}
+
+#endif//HASH_MURMUR
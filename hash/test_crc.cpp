@@ -2,6 +2,8 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <gtest/gtest.h>
 
 template <typename T> struct CRCHash;
@@ -35,3 +37,89 @@ TEST(CRCTestInt, Test1){
   CRCHash<int> hash;
   EXPECT_EQ(0xffff804a, hash(v));
 }
+
+//one bit at a time straight from the definition
+static uint32_t crc_bitwise(uint32_t poly, const uint8_t* data, size_t len, uint32_t crc){
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i){
+    crc ^= data[i];
+    for (size_t b = 0; b < 8; ++b)
+      crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+  }
+  return ~crc;
+}
+
+static std::vector<uint8_t> crc_data(size_t n){
+  std::vector<uint8_t> d(n);
+  uint32_t x = 12345;
+  for (uint8_t& c : d){
+    x = x * 1103515245U + 12345U;
+    c = x >> 24;
+  }
+  return d;
+}
+
+TEST(CRCTestCheck, Test1){
+  const uint8_t* check = (const uint8_t*)"123456789";
+  EXPECT_EQ(0xCBF43926U, crc32_ieee(check, 9));
+  EXPECT_EQ(0xE3069283U, crc32c(check, 9));
+  EXPECT_EQ(crc_bitwise(CRC_CCITT_POLY, check, 9, 0), crc32(check, 9));
+}
+
+TEST(CRCTestTable, AllLengths){
+  std::vector<uint8_t> d = crc_data(600);
+  for (size_t off = 0; off < 4; ++off)
+    for (size_t n = 0; n + off <= d.size(); n += 1 + n / 16){
+      const uint8_t* p = d.data() + off;
+      EXPECT_EQ(crc_bitwise(CRC32_IEEE_POLY, p, n, 0), ~crc_update_table<CRC32_IEEE_POLY>(~0U, p, n));
+      EXPECT_EQ(crc_bitwise(CRC32C_POLY, p, n, 0), ~crc_update_table<CRC32C_POLY>(~0U, p, n));
+      EXPECT_EQ(crc_bitwise(CRC_CCITT_POLY, p, n, 0), ~crc_update_table<CRC_CCITT_POLY>(~0U, p, n));
+    }
+}
+
+//the runtime picked paths: sse4.2 for crc32c and pclmul folding past CRC_FOLD_MIN bytes
+TEST(CRCTestDispatch, AllLengths){
+  std::vector<uint8_t> d = crc_data(5000);
+  for (size_t off = 0; off < 4; ++off)
+    for (size_t n = 0; n + off <= d.size(); n += 1 + n / 32){
+      const uint8_t* p = d.data() + off;
+      EXPECT_EQ(crc_bitwise(CRC32_IEEE_POLY, p, n, 0), crc32_ieee(p, n));
+      EXPECT_EQ(crc_bitwise(CRC32C_POLY, p, n, 0), crc32c(p, n));
+      EXPECT_EQ(crc_bitwise(CRC_CCITT_POLY, p, n, 0), crc32(p, n));
+    }
+}
+
+TEST(CRCTestDispatch, Seed){
+  std::vector<uint8_t> d = crc_data(1000);
+  EXPECT_EQ(crc_bitwise(CRC32_IEEE_POLY, d.data(), d.size(), 0xDEADBEEFU), crc32_ieee(d.data(), d.size(), 0xDEADBEEFU));
+  EXPECT_EQ(crc_bitwise(CRC32C_POLY, d.data(), d.size(), 0xDEADBEEFU), crc32c(d.data(), d.size(), 0xDEADBEEFU));
+}
+
+TEST(CRCTestStream, Chunks){
+  std::vector<uint8_t> d = crc_data(10000);
+  uint32_t ieee = crc32_ieee(d.data(), d.size());
+  uint32_t c = crc32c(d.data(), d.size());
+  uint32_t legacy = crc32(d.data(), d.size());
+  for (size_t chunk : {1, 7, 64, 300, 4096}){
+    CRC32IEEEStream si;
+    CRC32CStream sc;
+    CRC32Stream sl;
+    uint32_t chained = 0;
+    for (size_t i = 0; i < d.size(); i += chunk){
+      size_t n = std::min(chunk, d.size() - i);
+      si.update(&d[i], n);
+      sc.update(&d[i], n);
+      sl.update(&d[i], n);
+      chained = crc32c(&d[i], n, chained);
+    }
+    EXPECT_EQ(ieee, si.finalize());
+    EXPECT_EQ(c, sc.finalize());
+    EXPECT_EQ(legacy, sl.finalize());
+    EXPECT_EQ(c, chained);
+  }
+  CRC32CStream sc(crc32c(d.data(), 5000));
+  sc.update(&d[5000], 5000);
+  EXPECT_EQ(c, sc.finalize());
+  sc.reset();
+  EXPECT_EQ(crc32c(d.data(), 0), sc.finalize());
+}
@@ -0,0 +1,50 @@
+#include <double_hash.h>
+#include <jenkins.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+TEST(DoubleHash, Sequence){
+  uint64_t h1 = 0x0123456789ABCDEFULL, h2 = 0xFEDCBA9876543210ULL;
+  DoubleHash g(h1, h2);
+  for (uint64_t i = 0; i < 20; ++i)
+    EXPECT_EQ(h1 + i * h2 + (i * i * i - i) / 6, g.next());
+}
+
+//with h2 = 0 plain double hashing repeats one index k times, the cubic term makes all but
+//g(0) and g(1) distinct
+TEST(DoubleHash, ZeroStep){
+  DoubleHash g(42, 0);
+  std::vector<uint64_t> v;
+  for (size_t i = 0; i < 8; ++i) v.push_back(g.next());
+  std::sort(v.begin(), v.end());
+  EXPECT_EQ(7, std::unique(v.begin(), v.end()) - v.begin());
+}
+
+//every index in range and each of m buckets within 5 sigma of its expected count
+TEST(DoubleHash, Uniform){
+  constexpr size_t M = 1000, K = 7, N = 20000;
+  std::vector<size_t> cnt(M);
+  uint64_t idx[K];
+  for (uint32_t key = 0; key < N; ++key){
+    double_hash(murmur3_x64_128((const uint8_t*)&key, sizeof(key)), K, M, idx);
+    for (size_t i = 0; i < K; ++i){
+      ASSERT_LT(idx[i], M);
+      ++cnt[idx[i]];
+    }
+  }
+  double e = (double)N * K / M;
+  for (size_t c : cnt)
+    EXPECT_LT(std::abs((double)c - e), 5. * std::sqrt(e));
+}
+
+TEST(DoubleHash, Single64){
+  std::string s("hello world");
+  DoubleHash a(jenkins64((const uint8_t*)s.c_str(), s.length()));
+  DoubleHash b(jenkins64((const uint8_t*)s.c_str(), s.length()));
+  for (size_t i = 0; i < 10; ++i)
+    EXPECT_EQ(a.next(1000), b.next(1000));
+}
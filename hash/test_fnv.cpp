@@ -2,6 +2,8 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <gtest/gtest.h>
 
 template <typename T> struct FNV1_Hash;
@@ -67,3 +69,27 @@ TEST(FNV1ATestInt, Test1){
   FNV1A_Hash<int> hash;
   EXPECT_EQ(0x3c04d4b4, hash(i));
 }
+
+template <typename Stream, typename F>
+void fnv_stream_chunks(F oneshot){
+  std::vector<uint8_t> data(100 + 8);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i * 37 + 11;
+  const size_t piece[] = {1, 2, 3, 5, 7, 13};
+  for (size_t len = 0; len <= 100; ++len)
+    for (size_t start = 0; start < 6; ++start){
+      Stream st;
+      for (size_t i = 0, p = start; i < len; ++p){
+        size_t n = std::min(piece[p % 6], len - i);
+        st.update(&data[i], n);
+        i += n;
+      }
+      EXPECT_EQ(oneshot(data.data(), len), st.finalize());
+    }
+}
+
+TEST(FNVStream, Chunks){
+  fnv_stream_chunks<FNV1_32Stream>(fnv1_32);
+  fnv_stream_chunks<FNV1a_32Stream>(fnv1a_32);
+  fnv_stream_chunks<FNV1_64Stream>(fnv1_64);
+  fnv_stream_chunks<FNV1a_64Stream>(fnv1a_64);
+}
@@ -1,6 +1,8 @@
 #include <jenkins.h>
 
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <gtest/gtest.h>
 
 template <typename T> class JenkinsHash;
@@ -36,3 +38,30 @@ TEST(HashInt, Test1){
   JenkinsHash<int> hash;
   EXPECT_EQ(0x9300741f, hash(t));
 }
+
+TEST(HashStream, Chunks){
+  std::vector<uint8_t> data(100);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i * 37 + 11;
+  const size_t piece[] = {1, 2, 3, 5, 7, 13};
+  for (size_t len = 0; len <= 100; ++len)
+    for (size_t start = 0; start < 6; ++start){
+      JenkinsStream st(0x1234U);
+      for (size_t i = 0, p = start; i < len; ++p){
+        size_t n = std::min(piece[p % 6], len - i);
+        st.update(&data[i], n);
+        i += n;
+      }
+      EXPECT_EQ(jenkins(data.data(), len, 0x1234U), st.finalize());
+    }
+}
+
+//the driver5 values of lookup3.c, seed is pc | pb << 32 and the digest c | b << 32
+TEST(Hash64, Reference){
+  EXPECT_EQ(0xDEADBEEFDEADBEEFULL, jenkins64(nullptr, 0));
+  EXPECT_EQ(0xDEADBEEFBD5B7DDEULL, jenkins64(nullptr, 0, 0xDEADBEEF00000000ULL));
+  EXPECT_EQ(0xBD5B7DDE9C093CCDULL, jenkins64(nullptr, 0, 0xDEADBEEFDEADBEEFULL));
+  const uint8_t* s = (const uint8_t*)"Four score and seven years ago";
+  EXPECT_EQ(0xCE7226E617770551ULL, jenkins64(s, 30));
+  EXPECT_EQ(0xBD371DE4E3607CAEULL, jenkins64(s, 30, 0x100000000ULL));
+  EXPECT_EQ(0x6CBEA4B3CD628161ULL, jenkins64(s, 30, 1ULL));
+}
@@ -2,6 +2,8 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <gtest/gtest.h>
 
 template <typename T> class MurmurHash;
@@ -37,3 +39,57 @@ TEST(HashInt, Test1){
   MurmurHash<int> hash;
   EXPECT_EQ(0xcb6c191f, hash(v));
 }
+
+//keys at odd offsets that end at the end of their allocation, so a read past the key or a
+//misaligned word load shows under the sanitizers. the digests are the reference ones
+TEST(HashString, UnalignedTail){
+  std::string s("hello world");
+  for (size_t off = 0; off < 4; ++off){
+    std::vector<uint8_t> buf(off + s.length());
+    std::copy(s.begin(), s.end(), buf.begin() + off);
+    EXPECT_EQ(0x5e928f0fU, murmur3(buf.data() + off, s.length()));
+  }
+  const uint8_t abc[] = {'a', 'b', 'c'};
+  std::vector<uint8_t> key(abc, abc + 3);
+  EXPECT_EQ(0xB3DD93FAU, murmur3(key.data(), 3));
+  EXPECT_EQ(0x0U, murmur3(key.data(), 0));
+}
+
+//every length up to 100 fed in pieces of 1, 2, 3, 5, 7 and 13 bytes in turn
+TEST(HashStream, Chunks){
+  std::vector<uint8_t> data(100 + 8);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = i * 37 + 11;
+  const size_t piece[] = {1, 2, 3, 5, 7, 13};
+  for (size_t len = 0; len <= 100; ++len)
+    for (size_t start = 0; start < 6; ++start){
+      Murmur3Stream st(0x1234U);
+      for (size_t i = 0, p = start; i < len; ++p){
+        size_t n = std::min(piece[p % 6], len - i);
+        st.update(&data[i], n);
+        i += n;
+      }
+      EXPECT_EQ(murmur3(data.data(), len, 0x1234U), st.finalize());
+    }
+}
+
+TEST(HashStream, Reset){
+  std::string s("hello world");
+  Murmur3Stream st;
+  st.update((const uint8_t*)"garbage", 7);
+  st.reset();
+  st.update((const uint8_t*)s.c_str(), 5).update((const uint8_t*)s.c_str() + 5, 6);
+  EXPECT_EQ(0x5e928f0fU, st.finalize());
+}
+
+TEST(Hash128, Reference){
+  Hash128 e = murmur3_x64_128(nullptr, 0);
+  EXPECT_EQ(0ULL, e.h1);
+  EXPECT_EQ(0ULL, e.h2);
+  Hash128 h = murmur3_x64_128((const uint8_t*)"hello", 5);
+  EXPECT_EQ(0xCBD8A7B341BD9B02ULL, h.h1);
+  EXPECT_EQ(0x5B1E906A48AE1D19ULL, h.h2);
+  std::string fox("The quick brown fox jumps over the lazy dog");
+  Hash128 f = murmur3_x64_128((const uint8_t*)fox.c_str(), fox.length());
+  EXPECT_EQ(0xE34BBC7BBC071B6CULL, f.h1);
+  EXPECT_EQ(0x7A433CA9C49A9347ULL, f.h2);
+}
@@ -0,0 +1,471 @@
+#ifndef HYPERLOGLOG
+#define HYPERLOGLOG
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "../hash/byte_hash.h"
+#include "../hash/hash_cpu.h"
+
+namespace s = std;
+
+/* HyperLogLog++ (Flajolet et al., Heule, Nunkesser and Hall)
+ *
+ * estimates the number of distinct keys with m = 2^p registers: a key's 64 bit murmur3 hash
+ * picks register idx from its top p bits and keeps in it the largest rank seen, the number
+ * of leading zeros of the other 64 - p bits plus one. the relative standard error is
+ * 1.04 / sqrt(m), 0.81% at p = 14 in 12KB.
+ *
+ *   sparse:  while few registers are set the sketch is a sorted list of (idx', rank') at
+ *            precision p' = 25, 4 bytes an entry, and new entries go to an unsorted buffer
+ *            merged into the list when full. the estimate is linear counting over 2^25
+ *            registers, nearly exact. once the list would take more memory than the dense
+ *            registers it is converted, the ranks at p follow from those at p'.
+ *   dense:   m registers of 6 bits packed 4 to 3 bytes.
+ *
+ * the dense estimate is Ertl's improved estimator ("New cardinality estimation algorithms
+ * for HyperLogLog sketches", 2017), computed from the histogram of register values. it is
+ * unbiased from 0 to well past 2^64 / m keys, which is what HLL++'s empirical bias tables
+ * and the switch to linear counting do for the original estimator, without the tables.
+ *
+ * sketches of the same p merge into the sketch of the union of their keys, dense registers
+ * by taking the larger of each pair; with AVX2 at runtime 32 registers are unpacked, merged
+ * and repacked at a time.
+ *
+ * H is a functor returning a 64 bit hash of T, ByteHash64 by default.
+ */
+
+constexpr size_t HLL_MIN_PRECISION = 4;
+constexpr size_t HLL_MAX_PRECISION = 18;
+constexpr size_t HLL_SPARSE_PRECISION = 25;
+constexpr size_t HLL_REGISTER_BITS = 6;
+constexpr uint8_t HLL_REGISTER_MASK = 0x3F;
+constexpr size_t HLL_PAD = 32; //bytes past the registers so vector loads stay in the buffer
+
+//rank of the 64 - p bits of h below the index: leading zeros + 1
+inline uint8_t hll_rank(uint64_t h, size_t p){
+  uint64_t w = h << p;
+  return w == 0 ? (uint8_t)(64 - p + 1) : (uint8_t)(__builtin_clzll(w) + 1);
+}
+
+//sparse entry: idx' << 6 | rank', sorted by idx' and, for equal idx', by rank'
+inline uint32_t hll_sparse_encode(uint64_t h){
+  return (uint32_t)(h >> (64 - HLL_SPARSE_PRECISION)) << HLL_REGISTER_BITS | hll_rank(h, HLL_SPARSE_PRECISION);
+}
+inline uint32_t hll_sparse_index(uint32_t e){
+  return e >> HLL_REGISTER_BITS;
+}
+//false for an entry no hash encodes: idx' of more than p' bits, or rank' outside 1 to 64 - p' + 1
+inline bool hll_sparse_valid(uint32_t e){
+  uint32_t rank = e & HLL_REGISTER_MASK;
+  return hll_sparse_index(e) < ((uint32_t)1 << HLL_SPARSE_PRECISION) && rank >= 1 && rank <= 64 - HLL_SPARSE_PRECISION + 1;
+}
+
+//the register and rank at precision p of a sparse entry
+inline void hll_sparse_decode(uint32_t e, size_t p, size_t& idx, uint8_t& rank){
+  uint32_t i = hll_sparse_index(e);
+  size_t d = HLL_SPARSE_PRECISION - p;
+  uint32_t b = i & (((uint32_t)1 << d) - 1);
+  idx = i >> d;
+  if (b) rank = (uint8_t)(d - (32 - __builtin_clz(b)) + 1);
+  else   rank = (uint8_t)(d + (e & HLL_REGISTER_MASK));
+}
+
+//6 bit register i of a packed array: 4 registers to 3 bytes, little endian; v is cut to 6 bits
+inline uint8_t hll_get(const uint8_t* r, size_t i){
+  size_t bit = i * HLL_REGISTER_BITS;
+  uint16_t w;
+  memcpy(&w, r + bit / 8, sizeof(w));
+  return (uint8_t)(w >> (bit % 8)) & HLL_REGISTER_MASK;
+}
+inline void hll_set(uint8_t* r, size_t i, uint8_t v){
+  size_t bit = i * HLL_REGISTER_BITS;
+  uint16_t w;
+  memcpy(&w, r + bit / 8, sizeof(w));
+  w = (uint16_t)((w & ~((uint16_t)HLL_REGISTER_MASK << (bit % 8))) | ((uint16_t)(v & HLL_REGISTER_MASK) << (bit % 8)));
+  memcpy(r + bit / 8, &w, sizeof(w));
+}
+
+//a[i] = max(a[i], b[i]) for registers [0, m), 4 at a time out of each 3 byte group
+inline void hll_merge_registers(uint8_t* a, const uint8_t* b, size_t m){
+  for (size_t g = 0; g < m / 4; ++g){
+    uint32_t wa = 0, wb = 0;
+    memcpy(&wa, a + 3 * g, 3);
+    memcpy(&wb, b + 3 * g, 3);
+    uint32_t w = 0;
+    for (size_t k = 0; k < 4; ++k){
+      uint32_t sh = (uint32_t)(k * HLL_REGISTER_BITS);
+      w |= s::max((wa >> sh) & HLL_REGISTER_MASK, (wb >> sh) & HLL_REGISTER_MASK) << sh;
+    }
+    memcpy(a + 3 * g, &w, 3);
+  }
+}
+
+#ifdef HASH_X86
+//24 packed bytes at p to 32 byte registers; reads 28 bytes
+HASH_AVX2 inline __m256i hll_unpack_avx2(const uint8_t* p){
+  //each dword gets one 3 byte group
+  const __m256i spread = _mm256_setr_epi8(
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+    0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  __m256i w = _mm256_shuffle_epi8(_mm256_loadu2_m128i((const __m128i*)(p + 12), (const __m128i*)p), spread);
+  return _mm256_or_si256(
+    _mm256_or_si256(_mm256_and_si256(w, _mm256_set1_epi32(0x3F)),
+                    _mm256_and_si256(_mm256_slli_epi32(w, 2), _mm256_set1_epi32(0x3F00))),
+    _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(w, 4), _mm256_set1_epi32(0x3F0000)),
+                    _mm256_and_si256(_mm256_slli_epi32(w, 6), _mm256_set1_epi32(0x3F000000))));
+}
+
+//32 byte registers back to 24 packed bytes at p
+HASH_AVX2 inline void hll_pack_avx2(uint8_t* p, __m256i u){
+  const __m256i gather = _mm256_setr_epi8(
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  __m256i w = _mm256_or_si256(
+    _mm256_or_si256(_mm256_and_si256(u, _mm256_set1_epi32(0x3F)),
+                    _mm256_srli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x3F00)), 2)),
+    _mm256_or_si256(_mm256_srli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x3F0000)), 4),
+                    _mm256_srli_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x3F000000)), 6)));
+  alignas(32) uint8_t tmp[32];
+  _mm256_store_si256((__m256i*)tmp, _mm256_shuffle_epi8(w, gather));
+  memcpy(p, tmp, 12);
+  memcpy(p + 12, tmp + 16, 12);
+}
+
+//a[i] = max(a[i], b[i]), 32 registers at a time; both arrays have HLL_PAD bytes past the registers
+HASH_AVX2 inline void hll_merge_registers_avx2(uint8_t* a, const uint8_t* b, size_t m){
+  size_t i = 0;
+  for (; i + 32 <= m; i += 32){
+    size_t off = i / 4 * 3;
+    hll_pack_avx2(a + off, _mm256_max_epu8(hll_unpack_avx2(a + off), hll_unpack_avx2(b + off)));
+  }
+  if (i < m) hll_merge_registers(a + i / 4 * 3, b + i / 4 * 3, m - i);
+}
+#endif//HASH_X86
+
+//Ertl's sigma and tau series of the improved estimator
+inline double hll_sigma(double x){
+  if (x == 1.) return std::numeric_limits<double>::infinity();
+  double y = 1., z = x, zp;
+  do {
+    x *= x;
+    zp = z;
+    z += x * y;
+    y += y;
+  } while (z != zp);
+  return z;
+}
+inline double hll_tau(double x){
+  if (x == 0. || x == 1.) return 0.;
+  double y = 1., z = 1. - x, zp;
+  do {
+    x = std::sqrt(x);
+    zp = z;
+    y *= 0.5;
+    z -= (1. - x) * (1. - x) * y;
+  } while (z != zp);
+  return z / 3.;
+}
+
+//cardinality from the histogram c[0, q + 1] of m register values, q = 64 - p
+inline double hll_estimate(const uint32_t* c, size_t q, size_t m){
+  double md = (double)m;
+  double z = md * hll_tau(1. - (double)c[q + 1] / md);
+  for (size_t k = q; k >= 1; --k)
+    z = 0.5 * (z + (double)c[k]);
+  z += md * hll_sigma((double)c[0] / md);
+  return md * md / (2. * std::log(2.) * z);
+}
+
+template <typename T, typename H = ByteHash64<T>>
+class HyperLogLog {
+  H mHash;
+  size_t mP;
+  bool mSparse;
+  s::vector<uint32_t> mList;   //sparse, sorted, one entry per idx'
+  s::vector<uint32_t> mBuffer; //sparse, unsorted
+  s::vector<uint8_t> mRegisters; //dense, m * 6 / 8 bytes and HLL_PAD
+
+  size_t registers() const { return (size_t)1 << mP; }
+  size_t dense_bytes() const { return registers() * HLL_REGISTER_BITS / 8; }
+  //the list turns dense when it would be larger than the registers
+  size_t sparse_max() const { return dense_bytes() / sizeof(uint32_t); }
+  size_t buffer_max() const { return s::max((size_t)16, sparse_max() / 4); }
+
+  //sorted entries, for each idx' the one of the highest rank'
+  static void normalize(s::vector<uint32_t>& list, s::vector<uint32_t>& buffer){
+    s::sort(buffer.begin(), buffer.end());
+    size_t n = list.size();
+    list.insert(list.end(), buffer.begin(), buffer.end());
+    s::inplace_merge(list.begin(), list.begin() + n, list.end());
+    buffer.clear();
+    size_t o = 0;
+    for (size_t i = 0; i < list.size(); ++i){
+      if (i + 1 < list.size() && hll_sparse_index(list[i]) == hll_sparse_index(list[i + 1])) continue;
+      list[o++] = list[i];
+    }
+    list.resize(o);
+  }
+  void flush(){
+    normalize(mList, mBuffer);
+    if (mList.size() > sparse_max()) to_dense();
+  }
+  void to_dense(){
+    normalize(mList, mBuffer);
+    mRegisters.assign(dense_bytes() + HLL_PAD, 0);
+    for (uint32_t e : mList){
+      size_t idx;
+      uint8_t rank;
+      hll_sparse_decode(e, mP, idx, rank);
+      if (rank > hll_get(mRegisters.data(), idx)) hll_set(mRegisters.data(), idx, rank);
+    }
+    mList.clear();
+    mList.shrink_to_fit();
+    mBuffer.clear();
+    mBuffer.shrink_to_fit();
+    mSparse = false;
+  }
+  void merge_dense(const uint8_t* o){
+#ifdef HASH_X86
+    if (hash_has_avx2()){
+      hll_merge_registers_avx2(mRegisters.data(), o, registers());
+      return;
+    }
+#endif
+    hll_merge_registers(mRegisters.data(), o, registers());
+  }
+public:
+  explicit HyperLogLog(size_t p = 14, H hash = H()):
+    mHash(hash), mP(s::min(HLL_MAX_PRECISION, s::max(HLL_MIN_PRECISION, p))), mSparse(true) {}
+
+  void add_hash(uint64_t h){
+    if (mSparse){
+      mBuffer.push_back(hll_sparse_encode(h));
+      if (mBuffer.size() >= buffer_max()) flush();
+      return;
+    }
+    size_t idx = (size_t)(h >> (64 - mP));
+    uint8_t rank = hll_rank(h, mP);
+    if (rank > hll_get(mRegisters.data(), idx)) hll_set(mRegisters.data(), idx, rank);
+  }
+  void add(const T& v){
+    add_hash(mHash(v));
+  }
+
+  //estimated number of distinct keys added
+  double estimate() const {
+    if (mSparse){
+      s::vector<uint32_t> list = sparse_entries();
+      double m = (double)((uint64_t)1 << HLL_SPARSE_PRECISION);
+      return m * std::log(m / (m - (double)list.size()));
+    }
+    uint32_t c[64 + 2] = {0};
+    const uint8_t* r = mRegisters.data();
+    for (size_t g = 0; g < registers() / 4; ++g){
+      uint32_t w = 0;
+      memcpy(&w, r + 3 * g, 3);
+      c[w & HLL_REGISTER_MASK]++;
+      c[(w >> 6) & HLL_REGISTER_MASK]++;
+      c[(w >> 12) & HLL_REGISTER_MASK]++;
+      c[(w >> 18) & HLL_REGISTER_MASK]++;
+    }
+    return hll_estimate(c, 64 - mP, registers());
+  }
+
+  //the sketch of the union of both key sets; o must have the same precision and hash
+  void merge(const HyperLogLog& o){
+    assert(o.mP == mP);
+    if (&o == this) return; //the union with itself is the same sketch
+    if (mSparse && o.mSparse){
+      mBuffer.insert(mBuffer.end(), o.mList.begin(), o.mList.end());
+      mBuffer.insert(mBuffer.end(), o.mBuffer.begin(), o.mBuffer.end());
+      flush();
+      return;
+    }
+    if (mSparse) to_dense();
+    if (not o.mSparse){
+      merge_dense(o.mRegisters.data());
+      return;
+    }
+    for (const s::vector<uint32_t>* l : {&o.mList, &o.mBuffer})
+      for (uint32_t e : *l){
+        size_t idx;
+        uint8_t rank;
+        hll_sparse_decode(e, mP, idx, rank);
+        if (rank > hll_get(mRegisters.data(), idx)) hll_set(mRegisters.data(), idx, rank);
+      }
+  }
+
+  size_t precision() const { return mP; }
+  const H& hash() const { return mHash; }
+  bool is_sparse() const { return mSparse; }
+  //memory held by the representation in use
+  size_t bytes() const {
+    return mSparse ? (mList.size() + mBuffer.size()) * sizeof(uint32_t) : dense_bytes();
+  }
+  //relative standard error of the dense estimate
+  double error() const { return 1.04 / std::sqrt((double)registers()); }
+
+  //a sorted copy of the sparse entries, one per idx', or the packed dense registers, as
+  //written to a file
+  s::vector<uint32_t> sparse_entries() const {
+    s::vector<uint32_t> list = mList, buffer = mBuffer;
+    normalize(list, buffer);
+    return list;
+  }
+  const uint8_t* dense_registers() const { return mSparse ? nullptr : mRegisters.data(); }
+  //replace the content with sparse entries, or with packed dense registers; the entries must
+  //pass hll_sparse_valid
+  void set_sparse(const uint32_t* e, size_t n){
+    mSparse = true;
+    mRegisters.clear();
+    mList.clear();
+    mBuffer.assign(e, e + n);
+    flush();
+  }
+  void set_dense(const uint8_t* r){
+    mSparse = false;
+    mList.clear();
+    mBuffer.clear();
+    mRegisters.assign(dense_bytes() + HLL_PAD, 0);
+    memcpy(mRegisters.data(), r, dense_bytes());
+  }
+
+  void clear(){
+    mSparse = true;
+    mList.clear();
+    mBuffer.clear();
+    mRegisters.clear();
+  }
+};
+
+/* Binary HyperLogLog File
+ *
+ * a 64 byte header followed by the sparse entries or the packed dense registers exactly as
+ * they are in memory, in native byte order. like the count-min sketch files it goes to and
+ * from any stream, so shards can send their sketches to an aggregator that merges them:
+ *
+ *   write_binary / read_binary:  a sketch on a stream
+ *   save_binary / load_binary:   the same on a file
+ *
+ * the file does not record the hash functor, a sketch must be read with the H it was built with;
+ * read_binary keeps the functor of the sketch it reads into. sparse entries and registers
+ * that no hash can produce are rejected as corrupted.
+ */
+
+constexpr char     HLL_FILE_MAGIC[4] = {'H', 'L', 'L', 'P'};
+constexpr uint32_t HLL_FILE_VERSION = 1;
+constexpr uint32_t HLL_FILE_SPARSE = 0x1;
+
+struct HLLFileHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t precision;
+  uint32_t flags;
+  uint64_t entries; //sparse entries, 0 if dense
+  uint64_t bytes;   //bytes after the header
+  uint8_t  pad[32];
+};
+static_assert(sizeof(HLLFileHeader) == 64, "hyperloglog file header must be 64 bytes");
+
+//the sparse entries are written flushed, from a copy
+template <typename T, typename H>
+bool write_binary(const HyperLogLog<T, H>& hll, s::ostream& out){
+  HLLFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, HLL_FILE_MAGIC, sizeof(h.magic));
+  h.version = HLL_FILE_VERSION;
+  h.precision = (uint32_t)hll.precision();
+  if (hll.is_sparse()){
+    s::vector<uint32_t> e = hll.sparse_entries();
+    h.flags = HLL_FILE_SPARSE;
+    h.entries = e.size();
+    h.bytes = e.size() * sizeof(uint32_t);
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)e.data(), h.bytes);
+  } else {
+    h.bytes = hll.bytes();
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)hll.dense_registers(), h.bytes);
+  }
+  return not out.fail();
+}
+
+//hll is replaced by the sketch read with its own hash, untouched if it could not be read
+template <typename T, typename H>
+bool read_binary(HyperLogLog<T, H>& hll, s::istream& in, const s::string& name = "stream"){
+  HLLFileHeader h;
+  if (not in.read((char*)&h, sizeof(h)) || memcmp(h.magic, HLL_FILE_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != HLL_FILE_VERSION){
+    s::cout << name << " is not a hyperloglog sketch" << s::endl;
+    return false;
+  }
+  if (h.precision < HLL_MIN_PRECISION || h.precision > HLL_MAX_PRECISION){
+    s::cout << name << " is corrupted" << s::endl;
+    return false;
+  }
+  bool sparse = h.flags & HLL_FILE_SPARSE;
+  size_t m = (size_t)1 << h.precision;
+  if ((sparse && (h.entries > m || h.bytes != h.entries * sizeof(uint32_t))) ||
+      (not sparse && (h.entries != 0 || h.bytes != m * HLL_REGISTER_BITS / 8))){
+    s::cout << name << " is corrupted" << s::endl;
+    return false;
+  }
+  //room past the registers for the 2 byte reads of hll_get
+  s::vector<uint8_t> data(h.bytes + sizeof(uint16_t));
+  if (not in.read((char*)data.data(), h.bytes)){
+    s::cout << name << " is truncated" << s::endl;
+    return false;
+  }
+  s::vector<uint32_t> e(h.entries);
+  if (not e.empty()) memcpy(e.data(), data.data(), e.size() * sizeof(uint32_t));
+  bool valid = s::all_of(e.begin(), e.end(), hll_sparse_valid);
+  for (size_t i = 0; valid && not sparse && i < m; ++i)
+    valid = hll_get(data.data(), i) <= 64 - h.precision + 1;
+  if (not valid){
+    s::cout << name << " is corrupted" << s::endl;
+    return false;
+  }
+  HyperLogLog<T, H> ret(h.precision, hll.hash());
+  if (sparse) ret.set_sparse(e.data(), e.size());
+  else        ret.set_dense(data.data());
+  hll = s::move(ret);
+  return true;
+}
+
+template <typename T, typename H>
+bool save_binary(const HyperLogLog<T, H>& hll, const s::string& filename){
+  s::ofstream out(filename.c_str(), s::ios::out | s::ios::binary | s::ios::trunc);
+  if (not out.is_open()){
+    s::cout << "could not open file " << filename << " to save" << s::endl;
+    return false;
+  }
+  write_binary(hll, out);
+  out.close();
+  if (out.fail()){
+    s::cout << "failed writing file " << filename << s::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename T, typename H>
+bool load_binary(HyperLogLog<T, H>& hll, const s::string& filename){
+  s::ifstream in(filename.c_str(), s::ios::in | s::ios::binary);
+  if (not in.is_open()){
+    s::cout << "could not open input file " << filename << " to load" << s::endl;
+    return false;
+  }
+  return read_binary(hll, in, "file " + filename);
+}
+
+#endif//HYPERLOGLOG
@@ -0,0 +1,211 @@
+#include <hyperloglog.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <sstream>
+
+TEST(HyperLogLog, Registers){
+  uint8_t r[3 * 16 + HLL_PAD] = {0};
+  for (size_t i = 0; i < 64; ++i) hll_set(r, i, (uint8_t)(i % 64));
+  for (size_t i = 0; i < 64; ++i) ASSERT_EQ(i % 64, hll_get(r, i));
+  hll_set(r, 5, 63);
+  hll_set(r, 5, 1);
+  EXPECT_EQ(1, hll_get(r, 5));
+  EXPECT_EQ(4, hll_get(r, 4));
+  EXPECT_EQ(6, hll_get(r, 6));
+  //a value past 6 bits does not spill into the neighbours
+  hll_set(r, 5, 0xFF);
+  EXPECT_EQ(63, hll_get(r, 5));
+  EXPECT_EQ(4, hll_get(r, 4));
+  EXPECT_EQ(6, hll_get(r, 6));
+}
+
+TEST(HyperLogLog, Rank){
+  EXPECT_EQ(1, hll_rank(~0ULL, 14));
+  EXPECT_EQ(51, hll_rank(0, 14));
+  EXPECT_EQ(2, hll_rank(0x0001000000000000ULL, 14));
+  //the rank at p from a sparse entry is the rank of the hash at p
+  uint64_t x = 0x9E3779B97F4A7C15ULL;
+  for (size_t i = 0; i < 10000; ++i){
+    uint64_t h = (x *= 0xBF58476D1CE4E5B9ULL) >> (i % 50);
+    for (size_t p : {4, 10, 14, 18}){
+      size_t idx;
+      uint8_t rank;
+      hll_sparse_decode(hll_sparse_encode(h), p, idx, rank);
+      ASSERT_EQ(h >> (64 - p), idx);
+      ASSERT_EQ(hll_rank(h, p), rank);
+    }
+  }
+}
+
+TEST(HyperLogLog, Sparse){
+  HyperLogLog<std::string> hll;
+  EXPECT_EQ(0., hll.estimate());
+  for (size_t r = 0; r < 3; ++r)
+    for (size_t i = 0; i < 1000; ++i) hll.add("user" + std::to_string(i));
+  EXPECT_TRUE(hll.is_sparse());
+  EXPECT_NEAR(1000., hll.estimate(), 2.);
+  EXPECT_LT(hll.bytes(), 12288UL);
+  hll.clear();
+  EXPECT_EQ(0., hll.estimate());
+}
+
+//within 4 standard errors over the sparse and dense range
+TEST(HyperLogLog, Accuracy){
+  for (size_t p : {10, 14}){
+    HyperLogLog<uint64_t> hll(p);
+    uint64_t n = 0;
+    for (uint64_t target : {100UL, 1000UL, 10000UL, 100000UL, 1000000UL}){
+      for (; n < target; ++n) hll.add(n);
+      EXPECT_NEAR((double)n, hll.estimate(), 4. * hll.error() * (double)n) << "p " << p << " n " << n;
+    }
+    EXPECT_FALSE(hll.is_sparse());
+    EXPECT_EQ(((size_t)1 << p) * 6 / 8, hll.bytes());
+  }
+}
+
+TEST(HyperLogLog, Merge){
+  HyperLogLog<uint64_t> a(12), b(12), all(12), small(12);
+  for (uint64_t i = 0; i < 50000; ++i){
+    (i % 3 ? a : b).add(i);
+    all.add(i);
+  }
+  for (uint64_t i = 0; i < 100; ++i) small.add(i * 7);
+  EXPECT_FALSE(a.is_sparse());
+  EXPECT_FALSE(b.is_sparse());
+  a.merge(b);
+  EXPECT_EQ(all.estimate(), a.estimate());
+  //sparse into dense, dense into sparse, sparse into sparse
+  a.merge(small);
+  EXPECT_EQ(all.estimate(), a.estimate());
+  HyperLogLog<uint64_t> c(12), d(12);
+  c.add(1);
+  c.merge(all);
+  EXPECT_FALSE(c.is_sparse());
+  EXPECT_EQ(all.estimate(), c.estimate());
+  d.merge(small);
+  EXPECT_TRUE(d.is_sparse());
+  EXPECT_EQ(small.estimate(), d.estimate());
+  //merging a sketch into itself leaves it as it was
+  d.merge(d);
+  EXPECT_TRUE(d.is_sparse());
+  EXPECT_EQ(small.estimate(), d.estimate());
+  a.merge(a);
+  EXPECT_EQ(all.estimate(), a.estimate());
+}
+
+TEST(HyperLogLog, VectorMerge){
+  for (size_t m : {16, 32, 48, 1024, 1056}){
+    std::vector<uint8_t> a(m * 3 / 4 + HLL_PAD, 0), b(a), c(a);
+    uint64_t x = m;
+    for (size_t i = 0; i < m; ++i){
+      hll_set(a.data(), i, (uint8_t)((x = x * 6364136223846793005ULL + 1) >> 58));
+      hll_set(b.data(), i, (uint8_t)((x = x * 6364136223846793005ULL + 1) >> 58));
+    }
+    c = a;
+    hll_merge_registers(a.data(), b.data(), m);
+    hll_merge_registers_avx2(c.data(), b.data(), m);
+    ASSERT_EQ(a, c) << m;
+    for (size_t i = 0; i < m; ++i)
+      ASSERT_EQ(std::max(hll_get(b.data(), i), hll_get(a.data(), i)), hll_get(c.data(), i));
+  }
+}
+
+TEST(HyperLogLog, File){
+  HyperLogLog<uint64_t> sparse(14), dense(14);
+  for (uint64_t i = 0; i < 500; ++i) sparse.add(i);
+  for (uint64_t i = 0; i < 100000; ++i) dense.add(i);
+
+  std::stringstream ss;
+  ASSERT_TRUE(write_binary(sparse, ss));
+  HyperLogLog<uint64_t> back(4);
+  ASSERT_TRUE(read_binary(back, ss));
+  EXPECT_TRUE(back.is_sparse());
+  EXPECT_EQ(14UL, back.precision());
+  EXPECT_EQ(sparse.estimate(), back.estimate());
+
+  std::string filename = "test_hyperloglog.bin";
+  ASSERT_TRUE(save_binary(dense, filename));
+  ASSERT_TRUE(load_binary(back, filename));
+  EXPECT_FALSE(back.is_sparse());
+  EXPECT_EQ(dense.estimate(), back.estimate());
+  std::remove(filename.c_str());
+
+  std::stringstream t(ss.str().substr(0, 80));
+  EXPECT_FALSE(read_binary(back, t));
+  EXPECT_EQ(dense.estimate(), back.estimate());
+  std::stringstream junk(std::string(100, 'x'));
+  EXPECT_FALSE(read_binary(back, junk));
+  EXPECT_FALSE(load_binary(back, "no_such_file.bin"));
+}
+
+//a sketch written and read back through its header and entries, with entry i replaced by e
+static bool read_with_entry(const HyperLogLog<uint64_t>& sparse, size_t i, uint32_t e){
+  std::stringstream ss;
+  write_binary(sparse, ss);
+  std::string s = ss.str();
+  memcpy(&s[sizeof(HLLFileHeader) + i * sizeof(uint32_t)], &e, sizeof(e));
+  std::stringstream in(s);
+  HyperLogLog<uint64_t> back;
+  return read_binary(back, in);
+}
+
+TEST(HyperLogLog, FileCorrupted){
+  HyperLogLog<uint64_t> sparse(14);
+  for (uint64_t i = 0; i < 100; ++i) sparse.add(i);
+  const HyperLogLog<uint64_t>& c = sparse;
+  uint32_t e = c.sparse_entries()[3];
+  EXPECT_TRUE(read_with_entry(c, 3, e));
+  //rank' of 0 and past 64 - 25 + 1, idx' past 2^25
+  EXPECT_FALSE(read_with_entry(c, 3, e & ~(uint32_t)HLL_REGISTER_MASK));
+  EXPECT_FALSE(read_with_entry(c, 3, (e & ~(uint32_t)HLL_REGISTER_MASK) | 41));
+  EXPECT_TRUE(read_with_entry(c, 3, (e & ~(uint32_t)HLL_REGISTER_MASK) | 40));
+  EXPECT_FALSE(read_with_entry(c, 3, e | 0x80000000U));
+
+  //a dense register above 64 - p + 1
+  HyperLogLog<uint64_t> dense(4);
+  for (uint64_t i = 0; i < 1000; ++i) dense.add(i);
+  ASSERT_FALSE(dense.is_sparse());
+  std::stringstream ss;
+  write_binary(dense, ss);
+  std::string s = ss.str();
+  std::vector<uint8_t> r(s.begin() + sizeof(HLLFileHeader), s.end());
+  r.resize(r.size() + HLL_PAD);
+  hll_set(r.data(), 7, 62);
+  s.replace(sizeof(HLLFileHeader), 12, (const char*)r.data(), 12);
+  std::stringstream in(s);
+  HyperLogLog<uint64_t> back;
+  EXPECT_FALSE(read_binary(back, in));
+
+  //a precision past the range, which must be checked before it sizes anything
+  for (uint32_t p : {3U, 19U, 64U, 200U}){
+    std::string t = ss.str();
+    memcpy(&t[offsetof(HLLFileHeader, precision)], &p, sizeof(p));
+    std::stringstream pin(t);
+    EXPECT_FALSE(read_binary(back, pin));
+  }
+}
+
+//a hash with state: the sketch a stream is read into keeps its own
+struct SeededHash {
+  uint32_t seed;
+  uint64_t operator()(const uint64_t& v) const {
+    return murmur3_x64_128((const uint8_t*)&v, sizeof(v), seed).h1;
+  }
+};
+
+TEST(HyperLogLog, ReadKeepsHash){
+  HyperLogLog<uint64_t, SeededHash> hll(10, SeededHash{5});
+  for (uint64_t i = 0; i < 5000; ++i) hll.add(i);
+  std::stringstream ss;
+  ASSERT_TRUE(write_binary(hll, ss));
+  HyperLogLog<uint64_t, SeededHash> back(10, SeededHash{5});
+  ASSERT_TRUE(read_binary(back, ss));
+  EXPECT_EQ(5U, back.hash().seed);
+  //adding the same keys again changes nothing
+  double est = back.estimate();
+  for (uint64_t i = 0; i < 5000; ++i) back.add(i);
+  EXPECT_EQ(est, back.estimate());
+}
@@ -0,0 +1,205 @@
+#ifndef LU_DECOMPOSITION
+#define LU_DECOMPOSITION
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "../matrix/gemm.h"
+
+namespace s = std;
+
+/* LU Factorization with Partial Pivoting
+ *
+ * factors a nrow x ncol matrix once into P A = L U and answers solve, determinant and rank
+ * queries from the factors without eliminating again.
+ *
+ * U is kept in row echelon form: a column without a usable pivot (every candidate below
+ * the current row is within eps of 0) is skipped instead of being divided by, so singular
+ * and rectangular matrices factor as well and the number of pivots is the rank.
+ *
+ * the factorization is right-looking and blocked: a panel of LU_NB columns is eliminated
+ * with row operations limited to the panel, the pivot rows are then solved against the
+ * columns right of the panel and the rest of the matrix is updated with a single gemm
+ * (A22 -= L21 * U12), which is where almost all of the work happens.
+ *
+ * storage is contiguous and row major, the factors overwrite a private copy of the input.
+ */
+
+template <typename T> constexpr T LU_EPSILON;
+template <> constexpr double LU_EPSILON<double> = 1e-12;
+template <> constexpr float LU_EPSILON<float> = 1e-6;
+
+constexpr size_t LU_NB = 64; //panel width
+
+enum class NUM_SOLUTIONS: size_t {
+  ZERO,
+  ONE,
+  INF,
+};
+
+template <typename T>
+class LU {
+  size_t mRows;
+  size_t mCols;
+  T mEps;
+  s::vector<T> mA;           //L below the pivots, U on and above, row major
+  s::vector<size_t> mPerm;   //mPerm[i] is the input row now at row i
+  s::vector<size_t> mPivCol; //column of the pivot of row i, for i < rank
+  int mSign;                 //parity of mPerm
+
+  T& at(size_t r, size_t c){ return mA[r * mCols + c]; }
+  T at(size_t r, size_t c) const { return mA[r * mCols + c]; }
+
+  void swap_rows(size_t r1, size_t r2){
+    s::swap_ranges(&mA[r1 * mCols], &mA[r1 * mCols] + mCols, &mA[r2 * mCols]);
+    s::swap(mPerm[r1], mPerm[r2]);
+    mSign = -mSign;
+  }
+
+  //eliminate columns [c0, c1) starting at pivot row r, only the panel columns are updated;
+  //returns the next pivot row
+  size_t factor_panel(size_t r, size_t c0, size_t c1){
+    for (size_t c = c0; c < c1 && r < mRows; ++c){
+      size_t maxr = r;
+      for (size_t i = r + 1; i < mRows; ++i)
+        if (s::abs(at(i, c)) > s::abs(at(maxr, c)))
+          maxr = i;
+      if (s::abs(at(maxr, c)) <= mEps) continue;
+      if (maxr != r) swap_rows(maxr, r);
+
+      T piv = at(r, c);
+      for (size_t i = r + 1; i < mRows; ++i){
+        T l = at(i, c) / piv;
+        at(i, c) = l;
+        for (size_t j = c + 1; j < c1; ++j)
+          at(i, j) -= l * at(r, j);
+      }
+      mPivCol.push_back(c);
+      ++r;
+    }
+    return r;
+  }
+
+  void factor(){
+    size_t r = 0;
+    s::vector<T> l21;
+    for (size_t c0 = 0; c0 < mCols && r < mRows; c0 += LU_NB){
+      size_t c1 = s::min(mCols, c0 + LU_NB);
+      size_t r0 = r;
+      r = factor_panel(r, c0, c1);
+      size_t p = r - r0;
+      if (p == 0 || c1 == mCols) continue;
+
+      //U12 = L11^-1 A12, L11 is unit lower triangular over the panel's pivots
+      for (size_t k = 1; k < p; ++k)
+        for (size_t j = 0; j < k; ++j){
+          T l = at(r0 + k, mPivCol[r0 + j]);
+          if (l == T()) continue;
+          T* dst = &at(r0 + k, c1);
+          const T* src = &at(r0 + j, c1);
+          for (size_t c = 0; c < mCols - c1; ++c) dst[c] -= l * src[c];
+        }
+      if (r == mRows) continue;
+
+      //skipped columns leave gaps in the panel, gather the multipliers into a dense L21
+      size_t m = mRows - r;
+      l21.resize(m * p);
+      for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < p; ++j)
+          l21[i * p + j] = at(r + i, mPivCol[r0 + j]);
+      gemm(m, mCols - c1, p, (T)-1,
+           l21.data(), p, (size_t)1,
+           &at(r0, c1), mCols, (size_t)1,
+           &at(r, c1), mCols, (size_t)1);
+    }
+  }
+public:
+  //element (i, j) of the input is a[i * rs + j * cs], this reads both layouts of Mtx
+  LU(const T* a, size_t nrow, size_t ncol, size_t rs, size_t cs, T eps = LU_EPSILON<T>):
+    mRows(nrow), mCols(ncol), mEps(eps), mA(nrow * ncol), mPerm(nrow), mSign(1) {
+    for (size_t i = 0; i < nrow; ++i){
+      mPerm[i] = i;
+      for (size_t j = 0; j < ncol; ++j)
+        at(i, j) = a[i * rs + j * cs];
+    }
+    factor();
+  }
+  LU(T** mtx, size_t nrow, size_t ncol, T eps = LU_EPSILON<T>):
+    mRows(nrow), mCols(ncol), mEps(eps), mA(nrow * ncol), mPerm(nrow), mSign(1) {
+    for (size_t i = 0; i < nrow; ++i){
+      mPerm[i] = i;
+      s::copy(mtx[i], mtx[i] + ncol, &at(i, 0));
+    }
+    factor();
+  }
+
+  size_t rows() const { return mRows; }
+  size_t cols() const { return mCols; }
+  size_t rank() const { return mPivCol.size(); }
+  bool singular() const { return rank() < s::min(mRows, mCols); }
+
+  T determinant() const {
+    assert(mRows == mCols);
+    if (rank() < mRows) return T();
+    T det = mSign;
+    for (size_t i = 0; i < mRows; ++i)
+      det *= at(i, i);
+    return det;
+  }
+
+  /* solve A X = B for nrhs right hand sides at once; B is nrow x nrhs and X is ncol x nrhs,
+   * both row major. free variables of an underdetermined system are set to 0 */
+  NUM_SOLUTIONS solve(T* x, const T* b, size_t nrhs) const {
+    size_t rk = rank();
+    s::vector<T> y(mRows * nrhs);
+    T bmax = 0;
+    for (size_t i = 0; i < mRows; ++i)
+      for (size_t k = 0; k < nrhs; ++k){
+        y[i * nrhs + k] = b[mPerm[i] * nrhs + k];
+        bmax = s::max(bmax, (T)s::abs(b[i * nrhs + k]));
+      }
+
+    //forward substitution with the unit lower triangular L
+    for (size_t i = 1; i < mRows; ++i){
+      T* yi = &y[i * nrhs];
+      for (size_t j = 0; j < s::min(i, rk); ++j){
+        T l = at(i, mPivCol[j]);
+        if (l == T()) continue;
+        const T* yj = &y[j * nrhs];
+        for (size_t k = 0; k < nrhs; ++k) yi[k] -= l * yj[k];
+      }
+    }
+
+    //rows without a pivot must have been eliminated to 0 for the system to be consistent
+    NUM_SOLUTIONS ret = rk < mCols ? NUM_SOLUTIONS::INF : NUM_SOLUTIONS::ONE;
+    for (size_t i = rk; i < mRows; ++i)
+      for (size_t k = 0; k < nrhs; ++k)
+        if (s::abs(y[i * nrhs + k]) > mEps * s::max((T)1, bmax))
+          ret = NUM_SOLUTIONS::ZERO;
+
+    //back substitution over the pivot rows of U
+    s::fill(x, x + mCols * nrhs, T());
+    for (size_t i = rk; i-- > 0;){
+      size_t pc = mPivCol[i];
+      T* xi = &x[pc * nrhs];
+      const T* yi = &y[i * nrhs];
+      for (size_t k = 0; k < nrhs; ++k) xi[k] = yi[k];
+      for (size_t j = pc + 1; j < mCols; ++j){
+        T u = at(i, j);
+        if (u == T()) continue;
+        const T* xj = &x[j * nrhs];
+        for (size_t k = 0; k < nrhs; ++k) xi[k] -= u * xj[k];
+      }
+      T d = at(i, pc);
+      for (size_t k = 0; k < nrhs; ++k) xi[k] /= d;
+    }
+    return ret;
+  }
+  NUM_SOLUTIONS solve(T* x, const T* b) const {
+    return solve(x, b, 1);
+  }
+};
+
+#endif//LU_DECOMPOSITION
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <random>
+#include <lu.h>
+
+namespace s = std;
+
+//row major nrow x ncol matrix of uniform values in [-1, 1]
+s::vector<double> random_mtx(size_t nrow, size_t ncol, unsigned seed){
+  s::mt19937 gen(seed);
+  s::uniform_real_distribution<double> dist(-1., 1.);
+  s::vector<double> m(nrow * ncol);
+  for (double& v : m) v = dist(gen);
+  return m;
+}
+
+s::vector<double> multiply(const s::vector<double>& a, const s::vector<double>& b, size_t m, size_t k, size_t n){
+  s::vector<double> c(m * n, 0.);
+  for (size_t i = 0; i < m; ++i)
+    for (size_t l = 0; l < k; ++l)
+      for (size_t j = 0; j < n; ++j)
+        c[i * n + j] += a[i * k + l] * b[l * n + j];
+  return c;
+}
+
+TEST(LU, SolveSmall){
+  double a[] = {2., 1., -2.,
+                1., -1., -1.,
+                1., 1., 3.};
+  double b[] = {3., 0., 12.};
+  double x[3];
+  LU<double> lu(a, 3, 3, 3, 1);
+  EXPECT_EQ(NUM_SOLUTIONS::ONE, lu.solve(x, b));
+  EXPECT_NEAR(3.5, x[0], 1e-12);
+  EXPECT_NEAR(1., x[1], 1e-12);
+  EXPECT_NEAR(2.5, x[2], 1e-12);
+  EXPECT_NEAR(-12., lu.determinant(), 1e-12);
+  EXPECT_EQ(3U, lu.rank());
+}
+
+TEST(LU, SolveBlockedMultiRHS){
+  for (size_t n : {1, 63, 64, 65, 200, 300}){
+    size_t nrhs = 5;
+    s::vector<double> a = random_mtx(n, n, n);
+    s::vector<double> xe = random_mtx(n, nrhs, n + 1);
+    s::vector<double> b = multiply(a, xe, n, n, nrhs);
+
+    LU<double> lu(a.data(), n, n, n, 1);
+    EXPECT_EQ(n, lu.rank());
+    s::vector<double> x(n * nrhs);
+    EXPECT_EQ(NUM_SOLUTIONS::ONE, lu.solve(x.data(), b.data(), nrhs));
+    for (size_t i = 0; i < x.size(); ++i) EXPECT_NEAR(xe[i], x[i], 1e-8);
+
+    //column layout input factors the transpose
+    LU<double> lut(a.data(), n, n, 1, n);
+    EXPECT_NEAR(lu.determinant(), lut.determinant(), 1e-9 * s::abs(lu.determinant()) + 1e-300);
+  }
+}
+
+TEST(LU, Determinant){
+  //triangular matrix times a permutation
+  size_t n = 150;
+  s::vector<double> a(n * n, 0.);
+  double expect = 1.;
+  for (size_t i = 0; i < n; ++i){
+    double d = 1. + (i % 3) * 0.5;
+    expect *= d;
+    for (size_t j = i; j < n; ++j) a[i * n + j] = j == i ? d : 0.25;
+  }
+  LU<double> lu(a.data(), n, n, n, 1);
+  EXPECT_NEAR(expect, lu.determinant(), 1e-9 * expect);
+  s::swap_ranges(&a[0], &a[n], &a[n]);
+  LU<double> swapped(a.data(), n, n, n, 1);
+  EXPECT_NEAR(-expect, swapped.determinant(), 1e-9 * expect);
+}
+
+TEST(LU, RankDeficient){
+  //product of n x k and k x m has rank k
+  size_t dims[][3] = {{100, 30, 150}, {150, 70, 100}, {90, 60, 90}, {5, 2, 300}};
+  for (auto& d : dims){
+    s::vector<double> a = multiply(random_mtx(d[0], d[1], 1), random_mtx(d[1], d[2], 2), d[0], d[1], d[2]);
+    LU<double> lu(a.data(), d[0], d[2], d[2], 1, 1e-9);
+    EXPECT_EQ(d[1], lu.rank());
+    if (d[0] == d[2]){
+      EXPECT_EQ(0., lu.determinant());
+    }
+  }
+  //zero leading column
+  double z[] = {0., 1.,
+                0., 1.};
+  EXPECT_EQ(1U, LU<double>(z, 2, 2, 2, 1).rank());
+}
+
+TEST(LU, SolveSingular){
+  //underdetermined consistent system: x0 + x1 = 2, 2 x0 + 2 x1 = 4
+  double a[] = {1., 1.,
+                2., 2.};
+  double b[] = {2., 4.};
+  double x[2];
+  LU<double> lu(a, 2, 2, 2, 1);
+  EXPECT_EQ(NUM_SOLUTIONS::INF, lu.solve(x, b));
+  EXPECT_NEAR(2., x[0] + x[1], 1e-12);
+  double c[] = {2., 5.};
+  EXPECT_EQ(NUM_SOLUTIONS::ZERO, lu.solve(x, c));
+
+  //overdetermined consistent system
+  size_t m = 120, n = 80;
+  s::vector<double> r = random_mtx(m, n, 7);
+  s::vector<double> xe = random_mtx(n, 1, 8);
+  s::vector<double> rb = multiply(r, xe, m, n, 1);
+  s::vector<double> rx(n);
+  LU<double> tall(r.data(), m, n, n, 1);
+  EXPECT_EQ(NUM_SOLUTIONS::ONE, tall.solve(rx.data(), rb.data()));
+  for (size_t i = 0; i < n; ++i) EXPECT_NEAR(xe[i], rx[i], 1e-8);
+  rb[0] += 1.;
+  EXPECT_EQ(NUM_SOLUTIONS::ZERO, tall.solve(rx.data(), rb.data()));
+}
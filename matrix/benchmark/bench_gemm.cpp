@@ -0,0 +1,76 @@
+#include <matrix.h>
+
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+
+namespace b = benchmark;
+
+/* the triple loop Mtx::dot used before the packed kernel, kept here as the baseline */
+template <typename T>
+void naive_dot(const Mtx<T>& x, const Mtx<T>& y, Mtx<T>& z){
+  for (size_t i = 0; i < x.rows(); ++i)
+    for (size_t j = 0; j < y.cols(); ++j)
+      for (size_t k = 0; k < x.cols(); ++k)
+        z(i, j) += x(i, k) * y(k, j);
+}
+
+template <typename T>
+Mtx<T> random_mtx(size_t n){
+  Mtx<T> ret(n, n);
+  D2IterC(ir, ic, 0, n, 0, n) ret(ir, ic) = (T)rand() / (T)RAND_MAX;
+  return ret;
+}
+
+template <typename T>
+static void bm_naive_dot(b::State& st){
+  size_t n = st.range(0);
+  Mtx<T> x = random_mtx<T>(n), y = random_mtx<T>(n);
+  for (auto _ : st){
+    Mtx<T> z(n, n);
+    naive_dot(x, y, z);
+    b::DoNotOptimize(z(0, 0));
+  }
+  st.counters["flops"] = b::Counter(2. * n * n * n, b::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(bm_naive_dot, float)->RangeMultiplier(2)->Range(64, 1024)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_naive_dot, double)->RangeMultiplier(2)->Range(64, 1024)->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_gemm_dot(b::State& st){
+  size_t n = st.range(0);
+  Mtx<T> x = random_mtx<T>(n), y = random_mtx<T>(n);
+  for (auto _ : st){
+    Mtx<T> z = x.dot(y);
+    b::DoNotOptimize(z(0, 0));
+  }
+  st.counters["flops"] = b::Counter(2. * n * n * n, b::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(bm_gemm_dot, float)->RangeMultiplier(2)->Range(64, 2048)->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_gemm_dot, double)->RangeMultiplier(2)->Range(64, 2048)->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_gemm_dot_rotated(b::State& st){
+  size_t n = st.range(0);
+  Mtx<T> x = random_mtx<T>(n), y = random_mtx<T>(n);
+  x.flip();
+  for (auto _ : st){
+    Mtx<T> z = x.dot(y);
+    b::DoNotOptimize(z(0, 0));
+  }
+  st.counters["flops"] = b::Counter(2. * n * n * n, b::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(bm_gemm_dot_rotated, double)->RangeMultiplier(2)->Range(64, 2048)->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_gemm_dot_threads(b::State& st){
+  size_t n = st.range(0);
+  set_mtx_threads(st.range(1));
+  Mtx<T> x = random_mtx<T>(n), y = random_mtx<T>(n);
+  for (auto _ : st){
+    Mtx<T> z = x.dot(y);
+    b::DoNotOptimize(z(0, 0));
+  }
+  set_mtx_threads(0);
+  st.counters["flops"] = b::Counter(2. * n * n * n, b::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(bm_gemm_dot_threads, double)->ArgsProduct({{1024, 2048}, {0, 1, 3, 7}})->UseRealTime()->Unit(b::kMillisecond);
@@ -0,0 +1,91 @@
+#include <matrix.h>
+
+#include <vector>
+#include <benchmark/benchmark.h>
+
+namespace b = benchmark;
+
+/* the visited bitmap cycle walk Mtx::rotate used before the blocked transpose */
+template <typename T>
+void bitmap_rotate(T* data, size_t rows, size_t cols){
+  vector<bool> visited(rows * cols, false);
+  for (size_t i = 0; i < cols; ++i)
+    for (size_t j = 0; j < rows; ++j){
+      size_t orig = j + i * rows;
+      size_t dest = i + j * cols;
+
+      if (visited[orig]) continue;
+      if (orig == dest) continue;
+
+      T valence = data[dest];
+      while (not visited[orig]){
+        data[dest] = data[orig];
+        visited[dest] = true;
+
+        size_t col = orig / cols;
+        size_t row = orig % cols;
+        dest = orig;
+        orig = col + row * rows;
+      }
+      data[dest] = valence;
+      visited[dest] = true;
+    }
+}
+
+//every transpose reads and writes the whole matrix once
+template <typename T>
+void set_throughput(b::State& st, size_t r, size_t c){
+  st.SetBytesProcessed((int64_t)st.iterations() * 2 * r * c * sizeof(T));
+}
+
+template <typename T>
+static void bm_bitmap_rotate(b::State& st){
+  size_t r = st.range(0), c = st.range(1);
+  vector<T> v(r * c, (T)1);
+  for (auto _ : st){
+    bitmap_rotate(v.data(), r, c);
+    std::swap(r, c);
+    b::ClobberMemory();
+  }
+  set_throughput<T>(st, r, c);
+}
+BENCHMARK_TEMPLATE(bm_bitmap_rotate, float)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_bitmap_rotate, double)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_mtx_t(b::State& st){
+  size_t r = st.range(0), c = st.range(1);
+  Mtx<T> m(r, c, (T)1);
+  for (auto _ : st){
+    m.t();
+    b::DoNotOptimize(m(0, 0));
+  }
+  set_throughput<T>(st, r, c);
+}
+BENCHMARK_TEMPLATE(bm_mtx_t, float)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
+BENCHMARK_TEMPLATE(bm_mtx_t, double)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_transpose_oop(b::State& st){
+  size_t r = st.range(0), c = st.range(1);
+  vector<T> src(r * c, (T)1), dst(r * c);
+  for (auto _ : st){
+    transpose_oop(src.data(), dst.data(), r, c);
+    b::ClobberMemory();
+  }
+  set_throughput<T>(st, r, c);
+}
+BENCHMARK_TEMPLATE(bm_transpose_oop, double)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
+
+template <typename T>
+static void bm_transpose_inplace(b::State& st){
+  size_t r = st.range(0), c = st.range(1);
+  vector<T> v(r * c, (T)1);
+  for (auto _ : st){
+    transpose_inplace(v.data(), r, c);
+    std::swap(r, c);
+    b::ClobberMemory();
+  }
+  set_throughput<T>(st, r, c);
+}
+BENCHMARK_TEMPLATE(bm_transpose_inplace, double)->Args({4096, 4096})->Args({4096, 2048})->Unit(b::kMillisecond);
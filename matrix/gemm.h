@@ -0,0 +1,306 @@
+#ifndef NN_MATRIX_GEMM
+#define NN_MATRIX_GEMM
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+
+#include "../thread_pool/thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NN_GEMM_X86
+#define NN_AVX2   __attribute__((target("avx2,fma")))
+#define NN_AVX512 __attribute__((target("avx512f")))
+#endif
+
+/* General matrix multiplication C += alpha * A * B
+ *
+ * every operand is described by a base pointer and a (row, column) stride, so element (i, j)
+ * lives at p[i * rs + j * cs]; this covers both the column layout and the rotated (row) layout
+ * of Mtx without any per-element branching.
+ *
+ * the algorithm follows the usual packed GEMM structure:
+ *   - B is cut into KC x NC blocks and packed into NR wide column panels (stays in L2/L3)
+ *   - A is cut into MC x KC blocks and packed into MR tall row panels (stays in L1/L2)
+ *   - a register blocked MR x NR micro-kernel accumulates one tile of C
+ * packing copies the operand into unit stride, zero padded panels so the micro-kernel never
+ * has to deal with the source layout or with matrix edges.
+ *
+ * the micro-kernel is chosen at runtime: AVX-512, AVX2 + FMA or a portable scalar kernel.
+ * row blocks of A and column panels of B are spread over default_pool().
+ */
+
+enum GemmArch {
+  GScalar,
+  GAvx2,
+  GAvx512,
+};
+
+inline GemmArch gemm_detect_arch(){
+#ifdef NN_GEMM_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))                                    return GAvx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))     return GAvx2;
+#endif
+  return GScalar;
+}
+
+inline GemmArch gemm_arch(){
+  static const GemmArch arch = gemm_detect_arch();
+  return arch;
+}
+
+/* cache blocking parameters, MC must be a multiple of every kernel's MR */
+constexpr size_t GEMM_MC = 128;
+constexpr size_t GEMM_KC = 256;
+constexpr size_t GEMM_NC = 3072;
+
+/* portable MR x NR kernel, used for non-x86 targets and non floating point types */
+template <typename T>
+struct GemmScalarKernel {
+  enum : size_t { MR = 4, NR = 4 };
+
+  static void run(size_t kc, const T* a, const T* b, T* c, size_t crs, size_t ccs, size_t mr, size_t nr, T alpha){
+    T acc[MR * NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR)
+      for (size_t j = 0; j < NR; ++j)
+        for (size_t i = 0; i < MR; ++i)
+          acc[i + j * MR] += a[i] * b[j];
+    for (size_t j = 0; j < nr; ++j)
+      for (size_t i = 0; i < mr; ++i)
+        c[i * crs + j * ccs] += alpha * acc[i + j * MR];
+  }
+};
+
+#ifdef NN_GEMM_X86
+
+template <typename T> struct Avx2Vec;
+template <> struct Avx2Vec<float> {
+  using reg = __m256;
+  enum : size_t { W = 8 };
+  NN_AVX2 static reg zero()                         { return _mm256_setzero_ps(); }
+  NN_AVX2 static reg load(const float* p)           { return _mm256_loadu_ps(p); }
+  NN_AVX2 static void store(float* p, reg v)        { _mm256_storeu_ps(p, v); }
+  NN_AVX2 static reg bcast(const float* p)          { return _mm256_broadcast_ss(p); }
+  NN_AVX2 static reg set1(float v)                  { return _mm256_set1_ps(v); }
+  NN_AVX2 static reg fma(reg a, reg b, reg c)       { return _mm256_fmadd_ps(a, b, c); }
+};
+template <> struct Avx2Vec<double> {
+  using reg = __m256d;
+  enum : size_t { W = 4 };
+  NN_AVX2 static reg zero()                         { return _mm256_setzero_pd(); }
+  NN_AVX2 static reg load(const double* p)          { return _mm256_loadu_pd(p); }
+  NN_AVX2 static void store(double* p, reg v)       { _mm256_storeu_pd(p, v); }
+  NN_AVX2 static reg bcast(const double* p)         { return _mm256_broadcast_sd(p); }
+  NN_AVX2 static reg set1(double v)                 { return _mm256_set1_pd(v); }
+  NN_AVX2 static reg fma(reg a, reg b, reg c)       { return _mm256_fmadd_pd(a, b, c); }
+};
+
+template <typename T> struct Avx512Vec;
+template <> struct Avx512Vec<float> {
+  using reg = __m512;
+  enum : size_t { W = 16 };
+  NN_AVX512 static reg zero()                       { return _mm512_setzero_ps(); }
+  NN_AVX512 static reg load(const float* p)         { return _mm512_loadu_ps(p); }
+  NN_AVX512 static void store(float* p, reg v)      { _mm512_storeu_ps(p, v); }
+  NN_AVX512 static reg bcast(const float* p)        { return _mm512_set1_ps(*p); }
+  NN_AVX512 static reg set1(float v)                { return _mm512_set1_ps(v); }
+  NN_AVX512 static reg fma(reg a, reg b, reg c)     { return _mm512_fmadd_ps(a, b, c); }
+};
+template <> struct Avx512Vec<double> {
+  using reg = __m512d;
+  enum : size_t { W = 8 };
+  NN_AVX512 static reg zero()                       { return _mm512_setzero_pd(); }
+  NN_AVX512 static reg load(const double* p)        { return _mm512_loadu_pd(p); }
+  NN_AVX512 static void store(double* p, reg v)     { _mm512_storeu_pd(p, v); }
+  NN_AVX512 static reg bcast(const double* p)       { return _mm512_set1_pd(*p); }
+  NN_AVX512 static reg set1(double v)               { return _mm512_set1_pd(v); }
+  NN_AVX512 static reg fma(reg a, reg b, reg c)     { return _mm512_fmadd_pd(a, b, c); }
+};
+
+/* the kernel bodies are identical across instruction sets, only the vector traits and the
+ * target attribute differ; MV vectors make up the MR rows of a tile */
+#define NN_GEMM_VEC_KERNEL(NAME, VEC, TARGET, MV, NRV)                                        \
+template <typename T>                                                                        \
+struct NAME {                                                                                \
+  using V = VEC<T>;                                                                          \
+  using reg = typename V::reg;                                                               \
+  enum : size_t { MR = MV * V::W, NR = NRV };                                                \
+                                                                                             \
+  TARGET static void run(size_t kc, const T* a, const T* b, T* c, size_t crs, size_t ccs,    \
+                         size_t mr, size_t nr, T alpha){                                     \
+    reg acc[MV][NR];                                                                         \
+    for (size_t j = 0; j < NR; ++j)                                                          \
+      for (size_t v = 0; v < MV; ++v)                                                        \
+        acc[v][j] = V::zero();                                                               \
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR){                                       \
+      reg av[MV];                                                                            \
+      for (size_t v = 0; v < MV; ++v) av[v] = V::load(a + v * V::W);                         \
+      for (size_t j = 0; j < NR; ++j){                                                       \
+        reg bv = V::bcast(b + j);                                                            \
+        for (size_t v = 0; v < MV; ++v) acc[v][j] = V::fma(av[v], bv, acc[v][j]);            \
+      }                                                                                      \
+    }                                                                                        \
+    reg valpha = V::set1(alpha);                                                             \
+    if (crs == 1 && mr == MR && nr == NR){                                                   \
+      for (size_t j = 0; j < NR; ++j)                                                        \
+        for (size_t v = 0; v < MV; ++v){                                                     \
+          T* cp = c + j * ccs + v * V::W;                                                    \
+          V::store(cp, V::fma(acc[v][j], valpha, V::load(cp)));                              \
+        }                                                                                    \
+      return;                                                                                \
+    }                                                                                        \
+    alignas(64) T tile[MR * NR];                                                             \
+    for (size_t j = 0; j < NR; ++j)                                                          \
+      for (size_t v = 0; v < MV; ++v)                                                        \
+        V::store(tile + j * MR + v * V::W, acc[v][j]);                                       \
+    for (size_t j = 0; j < nr; ++j)                                                          \
+      for (size_t i = 0; i < mr; ++i)                                                        \
+        c[i * crs + j * ccs] += alpha * tile[i + j * MR];                                    \
+  }                                                                                          \
+};
+
+NN_GEMM_VEC_KERNEL(GemmAvx2Kernel,   Avx2Vec,   NN_AVX2,   2, 6)
+NN_GEMM_VEC_KERNEL(GemmAvx512Kernel, Avx512Vec, NN_AVX512, 2, 12)
+
+#undef NN_GEMM_VEC_KERNEL
+
+#endif //NN_GEMM_X86
+
+/* pack mc x kc block of A into MR tall panels, p-th column of a panel is MR contiguous values */
+template <typename T, size_t MR>
+void gemm_pack_a(T* dst, const T* a, size_t ars, size_t acs, size_t mc, size_t kc){
+  for (size_t ir = 0; ir < mc; ir += MR){
+    size_t mr = std::min(MR, mc - ir);
+    const T* ap = a + ir * ars;
+    if (ars == 1){
+      for (size_t p = 0; p < kc; ++p, dst += MR){
+        const T* col = ap + p * acs;
+        size_t i = 0;
+        for (; i < mr; ++i) dst[i] = col[i];
+        for (; i < MR; ++i) dst[i] = T();
+      }
+    } else {
+      for (size_t p = 0; p < kc; ++p, dst += MR){
+        const T* col = ap + p * acs;
+        size_t i = 0;
+        for (; i < mr; ++i) dst[i] = col[i * ars];
+        for (; i < MR; ++i) dst[i] = T();
+      }
+    }
+  }
+}
+
+/* pack kc x nc block of B into NR wide panels, p-th row of a panel is NR contiguous values */
+template <typename T, size_t NR>
+void gemm_pack_b(T* dst, const T* b, size_t brs, size_t bcs, size_t kc, size_t nc){
+  for (size_t jr = 0; jr < nc; jr += NR){
+    size_t nr = std::min(NR, nc - jr);
+    const T* bp = b + jr * bcs;
+    if (bcs == 1){
+      for (size_t p = 0; p < kc; ++p, dst += NR){
+        const T* row = bp + p * brs;
+        size_t j = 0;
+        for (; j < nr; ++j) dst[j] = row[j];
+        for (; j < NR; ++j) dst[j] = T();
+      }
+    } else {
+      for (size_t p = 0; p < kc; ++p, dst += NR){
+        const T* row = bp + p * brs;
+        size_t j = 0;
+        for (; j < nr; ++j) dst[j] = row[j * bcs];
+        for (; j < NR; ++j) dst[j] = T();
+      }
+    }
+  }
+}
+
+/* multiply packed mc x kc A block with packed kc x nc B block into C */
+template <typename T, typename K>
+void gemm_macro_kernel(size_t mc, size_t nc, size_t kc, T alpha, const T* pa, const T* pb, T* c, size_t crs, size_t ccs){
+  for (size_t jr = 0; jr < nc; jr += K::NR){
+    size_t nr = std::min((size_t)K::NR, nc - jr);
+    for (size_t ir = 0; ir < mc; ir += K::MR){
+      size_t mr = std::min((size_t)K::MR, mc - ir);
+      K::run(kc, pa + ir * kc, pb + jr * kc, c + ir * crs + jr * ccs, crs, ccs, mr, nr, alpha);
+    }
+  }
+}
+
+template <typename T, typename K>
+void gemm_blocked(size_t m, size_t n, size_t k, T alpha,
+                  const T* a, size_t ars, size_t acs,
+                  const T* b, size_t brs, size_t bcs,
+                  T* c, size_t crs, size_t ccs){
+  static_assert(GEMM_MC % K::MR == 0, "MC must be a multiple of MR");
+  constexpr size_t NCP = (GEMM_NC + K::NR - 1) / K::NR * K::NR;
+
+  ThreadPool& pool = default_pool();
+  std::vector<T> pb(std::min(NCP, (n + K::NR - 1) / K::NR * K::NR) * GEMM_KC);
+
+  for (size_t jc = 0; jc < n; jc += NCP){
+    size_t nc = std::min(NCP, n - jc);
+    size_t npanels = (nc + K::NR - 1) / K::NR;
+    size_t mblocks = (m + GEMM_MC - 1) / GEMM_MC;
+    //when there are fewer row blocks than threads, also split the columns of the B block
+    size_t nsplit = std::min(npanels, (pool.concurrency() + mblocks - 1) / mblocks);
+    size_t split_panels = (npanels + nsplit - 1) / nsplit;
+
+    for (size_t pc = 0; pc < k; pc += GEMM_KC){
+      size_t kc = std::min(GEMM_KC, k - pc);
+      const T* bp = b + pc * brs + jc * bcs;
+      pool.parallel_for(0, npanels, 1, [&](size_t pbeg, size_t pend){
+        size_t jr = pbeg * K::NR, jn = std::min(nc, pend * K::NR);
+        gemm_pack_b<T, K::NR>(pb.data() + jr * kc, bp + jr * bcs, brs, bcs, kc, jn - jr);
+      });
+
+      //every C tile is owned by exactly one task, so the summation order does not depend on
+      //the number of threads
+      pool.parallel_for(0, mblocks * nsplit, 1, [&](size_t tbeg, size_t tend){
+        static thread_local std::vector<T> pa;
+        pa.resize(GEMM_MC * GEMM_KC);
+        size_t packed = (size_t)-1;
+        for (size_t t = tbeg; t < tend; ++t){
+          size_t ic = t / nsplit * GEMM_MC, mc = std::min(GEMM_MC, m - ic);
+          size_t jr = t % nsplit * split_panels * K::NR;
+          if (jr >= nc) continue;
+          size_t jn = std::min(nc, jr + split_panels * K::NR);
+          if (packed != ic){
+            gemm_pack_a<T, K::MR>(pa.data(), a + ic * ars + pc * acs, ars, acs, mc, kc);
+            packed = ic;
+          }
+          gemm_macro_kernel<T, K>(mc, jn - jr, kc, alpha, pa.data(), pb.data() + jr * kc,
+                                  c + ic * crs + (jc + jr) * ccs, crs, ccs);
+        }
+      });
+    }
+  }
+}
+
+/* C(m x n) += alpha * A(m x k) * B(k x n), element (i, j) of X is x[i * xrs + j * xcs] */
+template <typename T>
+void gemm(size_t m, size_t n, size_t k, T alpha,
+          const T* a, size_t ars, size_t acs,
+          const T* b, size_t brs, size_t bcs,
+          T* c, size_t crs, size_t ccs){
+  if (m == 0 || n == 0 || k == 0) return;
+
+#ifdef NN_GEMM_X86
+  if constexpr(std::is_same<T, float>::value || std::is_same<T, double>::value){
+    switch (gemm_arch()){
+    case GAvx512:
+      gemm_blocked<T, GemmAvx512Kernel<T>>(m, n, k, alpha, a, ars, acs, b, brs, bcs, c, crs, ccs);
+      return;
+    case GAvx2:
+      gemm_blocked<T, GemmAvx2Kernel<T>>(m, n, k, alpha, a, ars, acs, b, brs, bcs, c, crs, ccs);
+      return;
+    default: break;
+    }
+  }
+#endif
+  gemm_blocked<T, GemmScalarKernel<T>>(m, n, k, alpha, a, ars, acs, b, brs, bcs, c, crs, ccs);
+}
+
+#endif//NN_MATRIX_GEMM
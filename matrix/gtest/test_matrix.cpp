@@ -1,4 +1,6 @@
 #include <matrix.h>
+#include <mtx_file.h>
+#include <mtx_arena_pool.h>
 
 #include <gtest/gtest.h>
 #include <iostream>
@@ -341,6 +343,59 @@ TEST_F(ArithTest, DotMtx){
   std::cout << "Perf 100 * 100: " << (clock() - start) / (double)(CLOCKS_PER_SEC / 1000) << " ms" << std::endl;
 }
 
+template <typename T>
+Mtx<T> naive_dot(const Mtx<T>& a, const Mtx<T>& b){
+  Mtx<T> ret(a.rows(), b.cols(), 0.);
+  for (size_t i = 0; i < a.rows(); ++i)
+    for (size_t j = 0; j < b.cols(); ++j)
+      for (size_t k = 0; k < a.cols(); ++k)
+        ret(i, j) += a(i, k) * b(k, j);
+  return ret;
+}
+
+template <typename T>
+Mtx<T> random_mtx(size_t r, size_t c){
+  Mtx<T> ret(r, c);
+  D2IterC(ir, ic, 0, r, 0, c) ret(ir, ic) = (T)(rand() % 1000) / (T)100. - (T)5.;
+  return ret;
+}
+
+TEST(Gemm, BlockedDot){
+  //sizes straddle the micro-kernel tile and the cache block boundaries
+  size_t dims[][3] = {{1, 1, 1}, {7, 5, 3}, {33, 17, 29}, {131, 260, 67}, {300, 41, 513}};
+  for (auto& d : dims){
+    Mtx<tt> a = random_mtx<tt>(d[0], d[1]);
+    Mtx<tt> b = random_mtx<tt>(d[1], d[2]);
+    Mtx<tt> expected = naive_dot(a, b);
+
+    for (int flips = 0; flips < 4; ++flips){
+      Mtx<tt> fa(a), fb(b);
+      if (flips & 1) fa.flip();
+      if (flips & 2) fb.flip();
+      Mtx<tt> r = fa * fb;
+      EXPECT_EQ(d[0], r.rows());
+      EXPECT_EQ(d[2], r.cols());
+      D2IterC(ir, ic, 0, r.rows(), 0, r.cols()) EXPECT_NEAR(expected(ir, ic), r(ir, ic), 1e-9);
+    }
+  }
+}
+
+TEST(Gemm, BlockedDotFloat){
+  Mtx<float> a = random_mtx<float>(70, 300);
+  Mtx<float> b = random_mtx<float>(300, 45);
+  Mtx<float> expected = naive_dot(a, b);
+  Mtx<float> r = a.flip() * b;
+  D2IterC(ir, ic, 0, r.rows(), 0, r.cols()) EXPECT_NEAR(expected(ir, ic), r(ir, ic), 1e-2);
+}
+
+TEST(Gemm, IntegralDot){
+  Mtx<int> a(2, 3, vector<int>{1, 2, 3, 4, 5, 6});
+  Mtx<int> b(3, 2, vector<int>{1, 2, 3, 4, 5, 6});
+  Mtx<int> r = a * b;
+  vector<int> expected = {22, 28, 49, 64};
+  D2IterC(ir, ic, 0, r.rows(), 0, r.cols()) EXPECT_EQ(expected[ir + ic * r.rows()], r(ir, ic));
+}
+
 TEST_F(ArithTest, Sum){
   vector<tt> sum1 = d.sum(MRow);
   vector<tt> expected1 = {22., 26., 30.};
@@ -455,3 +510,415 @@ TEST_F(ArithTest, ColRefForeach){
   vector<tt> expected1 = {0., 0., 0., 0., 5., 6., 7., 8., 18., 20., 22., 24.};
   D2IterC(ir, ic, 0, e.rows(), 0, e.cols()) EXPECT_DOUBLE_EQ(expected1[ir + ic * e.rows()], e(ir, ic));
 }
+
+TEST(Parallel, MatchesSequential){
+  Mtx<tt> a = random_mtx<tt>(517, 389);
+  Mtx<tt> b = random_mtx<tt>(517, 389);
+  Mtx<tt> c = random_mtx<tt>(389, 300);
+  Mtx<tt> rb(b); rb.flip();
+
+  set_mtx_threads(0);
+  Mtx<tt> sa = a + rb;
+  Mtx<tt> sd = a.dot(c);
+  Mtx<tt> sp(a); sp.mul(b).pow(2.).foreach([](tt& v){ v = sqrt(v); });
+  vector<tt> scol = a.sum(MCol), srow = rb.sum(MRow), smean = a.mean(MRow);
+  vector<size_t> smax = rb.maxi(MCol), smin = a.mini(MRow);
+
+  set_mtx_threads(3);
+  for (int round = 0; round < 2; ++round){
+    Mtx<tt> pa = a + rb;
+    Mtx<tt> pd = a.dot(c);
+    Mtx<tt> pp(a); pp.mul(b).pow(2.).foreach([](tt& v){ v = sqrt(v); });
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(sa(ir, ic), pa(ir, ic));
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(sp(ir, ic), pp(ir, ic));
+    D2IterC(ir, ic, 0, sd.rows(), 0, sd.cols()) EXPECT_EQ(sd(ir, ic), pd(ir, ic));
+    EXPECT_EQ(scol, a.sum(MCol));
+    EXPECT_EQ(srow, rb.sum(MRow));
+    EXPECT_EQ(smean, a.mean(MRow));
+    EXPECT_EQ(smax, rb.maxi(MCol));
+    EXPECT_EQ(smin, a.mini(MRow));
+  }
+  set_mtx_threads(0);
+}
+
+TEST(Parallel, ExceptionPropagates){
+  ThreadPool pool(3);
+  std::atomic<size_t> done(0);
+  for (int round = 0; round < 2; ++round){
+    done = 0;
+    EXPECT_THROW(pool.parallel_for(0, 1000, 1, [&](size_t b, size_t e){
+      if (b <= 700 && 700 < e) throw std::runtime_error("chunk failed");
+      done += e - b;
+    }), std::runtime_error);
+    EXPECT_EQ(750U, done.load());
+  }
+  //the pool is still usable afterwards
+  done = 0;
+  pool.parallel_for(0, 1000, 1, [&](size_t b, size_t e){ done += e - b; });
+  EXPECT_EQ(1000U, done.load());
+}
+
+TEST(Expression, FusedElementwise){
+  Mtx<tt> a = random_mtx<tt>(37, 23);
+  Mtx<tt> b = random_mtx<tt>(37, 23);
+  Mtx<tt> c = random_mtx<tt>(37, 23);
+  Mtx<tt> d = random_mtx<tt>(37, 23).add(20.);
+  Mtx<tt> rc(c); rc.flip();
+
+  Mtx<tt> r1 = a + b - c / d;
+  D2IterC(ir, ic, 0, a.rows(), 0, a.cols())
+    EXPECT_DOUBLE_EQ(a(ir, ic) + b(ir, ic) - c(ir, ic) / d(ir, ic), r1(ir, ic));
+
+  //mixed layouts take the two dimensional path
+  Mtx<tt> r2 = hadamard(a, b) + rc - d;
+  D2IterC(ir, ic, 0, a.rows(), 0, a.cols())
+    EXPECT_DOUBLE_EQ(a(ir, ic) * b(ir, ic) + c(ir, ic) - d(ir, ic), r2(ir, ic));
+
+  //assignment reuses the destination buffer, operands may alias it
+  Mtx<tt> r3(a);
+  r3 = r3 + b + r3;
+  D2IterC(ir, ic, 0, a.rows(), 0, a.cols())
+    EXPECT_DOUBLE_EQ(a(ir, ic) + b(ir, ic) + a(ir, ic), r3(ir, ic));
+
+  //expressions as operands of matrix multiplication
+  Mtx<tt> e = random_mtx<tt>(23, 11);
+  Mtx<tt> r4 = (a + b) * e;
+  Mtx<tt> s(a); s.add(b);
+  Mtx<tt> expected = s.dot(e);
+  D2IterC(ir, ic, 0, r4.rows(), 0, r4.cols()) EXPECT_DOUBLE_EQ(expected(ir, ic), r4(ir, ic));
+
+  Mtx<tt> r5 = a * e + a * e;
+  D2IterC(ir, ic, 0, r5.rows(), 0, r5.cols()) EXPECT_NEAR(2. * a.dot(e)(ir, ic), r5(ir, ic), 1e-9);
+}
+
+TEST(Expression, MtxMembers){
+  Mtx<tt> a = random_mtx<tt>(37, 23);
+  Mtx<tt> b = random_mtx<tt>(37, 23);
+  Mtx<tt> s(a); s.add(b);
+
+  EXPECT_EQ(s.sum(MCol), (a + b).sum(MCol));
+  EXPECT_EQ(s.mean(MRow), (a + b).mean(MRow));
+  EXPECT_EQ(s.maxi(MCol), (a + b).maxi(MCol));
+  EXPECT_EQ(s.mini(MRow), (a + b).mini(MRow));
+
+  Mtx<tt> st = s.transpose();
+  Mtx<tt> t1 = (a + b).t();
+  Mtx<tt> t2 = (a + b).transpose();
+  Mtx<tt> p = (a + b).mul(2.);
+  EXPECT_EQ(23U, t1.rows());
+  D2IterC(ir, ic, 0, st.rows(), 0, st.cols()){
+    EXPECT_EQ(st(ir, ic), t1(ir, ic));
+    EXPECT_EQ(st(ir, ic), t2(ir, ic));
+  }
+  D2IterC(ir, ic, 0, s.rows(), 0, s.cols()) EXPECT_EQ(2. * s(ir, ic), p(ir, ic));
+
+  Mtx<tt> e = random_mtx<tt>(23, 11);
+  Mtx<tt> d = (a + b).dot(e);
+  Mtx<tt> expected = s.dot(e);
+  D2IterC(ir, ic, 0, d.rows(), 0, d.cols()) EXPECT_EQ(expected(ir, ic), d(ir, ic));
+}
+
+TEST(Transpose, FlipUnflipRoundTrip){
+  size_t dims[][2] = {{7, 5}, {5, 7}, {33, 17}, {64, 64}, {100, 3}, {1, 9}};
+  for (auto& d : dims){
+    Mtx<tt> a = random_mtx<tt>(d[0], d[1]);
+    Mtx<tt> b(a);
+    b.flip();
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), b(ir, ic));
+    b.unflip();
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), b(ir, ic));
+    b.t().t();
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), b(ir, ic));
+    Mtx<tt> c = b.transpose();
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), c(ic, ir));
+  }
+}
+
+TEST(Transpose, InplaceKernels){
+  size_t dims[][2] = {{2, 3}, {3, 2}, {37, 41}, {40, 40}, {128, 6}, {33, 100}};
+  for (auto& d : dims){
+    size_t r = d[0], c = d[1];
+    vector<tt> v(r * c);
+    for (size_t i = 0; i < v.size(); ++i) v[i] = (tt)i;
+    vector<tt> out(r * c);
+    transpose_oop(v.data(), out.data(), r, c);
+    vector<tt> in(v);
+    transpose_inplace(in.data(), r, c);
+    for (size_t i = 0; i < r; ++i)
+      for (size_t j = 0; j < c; ++j){
+        EXPECT_EQ(v[i + j * r], out[j + i * c]);
+        EXPECT_EQ(v[i + j * r], in[j + i * c]);
+      }
+  }
+}
+
+TEST(BinaryFile, SaveMapRoundTrip){
+  const char* fname = "tmp.mtxb";
+  for (bool rotated : {false, true}){
+    Mtx<tt> a = random_mtx<tt>(37, 53);
+    if (rotated) a.flip();
+    EXPECT_TRUE(save_binary(a, fname));
+
+    MappedMtx<tt> mapped(fname);
+    ASSERT_TRUE(mapped.is_open());
+    const Mtx<tt>& b = mapped.mtx();
+    EXPECT_EQ(a.rows(), b.rows());
+    EXPECT_EQ(a.cols(), b.cols());
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), b(ir, ic));
+
+    Mtx<tt> c = load_binary<tt>(fname);
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), c(ir, ic));
+    Mtx<tt> d = b * c.transpose();
+    Mtx<tt> e = a * a.transpose();
+    D2IterC(ir, ic, 0, d.rows(), 0, d.cols()) EXPECT_NEAR(e(ir, ic), d(ir, ic), 1e-9);
+  }
+  remove(fname);
+}
+
+TEST(BinaryFile, FlipMappedKeepsFile){
+  const char* fname = "tmp.mtxb";
+  for (size_t n : {16, 40}){
+    Mtx<tt> a = random_mtx<tt>(n, 24);
+    save_binary(a, fname);
+    {
+      MappedMtx<tt> mapped(fname);
+      ASSERT_TRUE(mapped.is_open());
+      mapped.mtx().flip();
+      D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), mapped.mtx()(ir, ic));
+      mapped.mtx().unflip();
+      D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), mapped.mtx()(ir, ic));
+    }
+    MappedMtx<tt> again(fname);
+    D2IterC(ir, ic, 0, a.rows(), 0, a.cols()) EXPECT_EQ(a(ir, ic), again.mtx()(ir, ic));
+  }
+  remove(fname);
+}
+
+TEST(BinaryFile, StreamingWriter){
+  const char* fname = "tmp.mtxb";
+  {
+    MtxWriter<float> out(fname, 3, 4);
+    for (size_t ic = 0; ic < 4; ++ic){
+      float col[3] = {(float)ic, (float)ic + 0.5f, (float)ic * 2.f};
+      out.write(col, 3);
+    }
+    EXPECT_TRUE(out.close());
+  }
+  MappedMtx<float> mapped(fname);
+  ASSERT_TRUE(mapped.is_open());
+  for (size_t ic = 0; ic < 4; ++ic){
+    EXPECT_EQ((float)ic, mapped.mtx()(0, ic));
+    EXPECT_EQ((float)ic + 0.5f, mapped.mtx()(1, ic));
+    EXPECT_EQ((float)ic * 2.f, mapped.mtx()(2, ic));
+  }
+
+  MappedMtx<double> wrong(fname);
+  EXPECT_FALSE(wrong.is_open());
+
+  MtxWriter<float> partial(fname, 3, 4);
+  float v = 1.f;
+  partial.write(&v, 1);
+  EXPECT_FALSE(partial.close());
+  MappedMtx<float> truncated(fname);
+  EXPECT_FALSE(truncated.is_open());
+
+  //rows * cols wraps around to 0 elements
+  {
+    MtxFileHeader h = make_mtx_header<float>(1UL << 32, 1UL << 32, false);
+    ofstream out(fname, ios::out | ios::binary | ios::trunc);
+    out.write((const char*)&h, sizeof(h));
+  }
+  MappedMtx<float> overflow(fname);
+  EXPECT_FALSE(overflow.is_open());
+  remove(fname);
+}
+
+TEST(View, SubBlock){
+  Mtx<tt> a = random_mtx<tt>(30, 20);
+  for (bool rotated : {false, true}){
+    if (rotated) a.flip();
+    MtxView<tt> v = a.view(3, 5, 10, 7);
+    EXPECT_EQ(10, v.rows());
+    EXPECT_EQ(7, v.cols());
+    D2IterC(ir, ic, 0, v.rows(), 0, v.cols()) EXPECT_EQ(a(ir + 3, ic + 5), v(ir, ic));
+
+    MtxView<tt> vv = v.view(2, 1, 4, 3);
+    D2IterC(ir, ic, 0, vv.rows(), 0, vv.cols()) EXPECT_EQ(a(ir + 5, ic + 6), vv(ir, ic));
+    MtxView<tt> vt = v.t();
+    D2IterC(ir, ic, 0, vt.rows(), 0, vt.cols()) EXPECT_EQ(v(ic, ir), vt(ir, ic));
+
+    Mtx<tt> copy(v);
+    vector<tt> sc = v.sum(MCol), sr = v.sum(MRow);
+    vector<tt> ec = copy.sum(MCol), er = copy.sum(MRow);
+    for (size_t i = 0; i < sc.size(); ++i) EXPECT_DOUBLE_EQ(ec[i], sc[i]);
+    for (size_t i = 0; i < sr.size(); ++i) EXPECT_DOUBLE_EQ(er[i], sr[i]);
+    EXPECT_EQ(copy.maxi(MCol), v.maxi(MCol));
+    EXPECT_EQ(copy.maxi(MRow), v.maxi(MRow));
+    EXPECT_EQ(copy.mini(MCol), v.mini(MCol));
+    EXPECT_EQ(copy.mini(MRow), v.mini(MRow));
+  }
+}
+
+TEST(View, WriteThrough){
+  Mtx<tt> a(6, 5, 1.);
+  a.view(1, 1, 3, 2).add(2.);
+  D2IterC(ir, ic, 0, 6, 0, 5){
+    bool in = ir >= 1 && ir < 4 && ic >= 1 && ic < 3;
+    EXPECT_EQ(in ? 3. : 1., a(ir, ic));
+  }
+  Mtx<tt> b(3, 2, 4.);
+  a.view(1, 1, 3, 2).mul(b);
+  EXPECT_EQ(12., a(2, 2));
+  a.view(0, 3, 3, 2).assign(b + a.view(1, 1, 3, 2));
+  EXPECT_EQ(16., a(1, 3));
+  EXPECT_EQ(16., a(2, 4));
+  EXPECT_EQ(16., a(0, 4));
+  EXPECT_EQ(1., a(3, 3));
+
+  Mtx<tt> c(3, 2, 1.);
+  c.add(a.view(0, 3, 3, 2));
+  EXPECT_EQ(17., c(0, 0));
+  EXPECT_EQ(17., c(1, 1));
+  Mtx<tt> d = c - a.view(0, 3, 3, 2);
+  D2IterC(ir, ic, 0, 3, 0, 2) EXPECT_EQ(1., d(ir, ic));
+}
+
+TEST(View, ConstReadOnly){
+  static_assert(is_same<MtxView<const tt>, decltype(declval<const Mtx<tt>&>().view())>::value, "");
+  static_assert(is_same<MtxView<const tt>, decltype(declval<const Mtx<tt>&>().view(0, 0, 1, 1))>::value, "");
+  static_assert(not is_convertible<MtxView<const tt>, MtxView<tt>>::value, "");
+  static_assert(not is_convertible<const Mtx<tt>&, MtxView<tt>>::value, "");
+  static_assert(is_convertible<MtxView<tt>, MtxView<const tt>>::value, "");
+
+  Mtx<tt> a = random_mtx<tt>(7, 5);
+  const Mtx<tt>& ca = a;
+  MtxView<const tt> v = ca.view(1, 1, 4, 3);
+  MtxView<const tt> w = a.view(1, 1, 4, 3);
+  Mtx<tt> b(4, 3, 1.);
+  b.add(v);
+  Mtx<tt> c = v + w;
+  D2IterC(ir, ic, 0, 4, 0, 3){
+    EXPECT_EQ(a(ir + 1, ic + 1) + 1., b(ir, ic));
+    EXPECT_EQ(2. * a(ir + 1, ic + 1), c(ir, ic));
+  }
+  EXPECT_EQ(ca.sum(MCol), a.view().sum(MCol));
+}
+
+TEST(View, AliasedOperands){
+  vector<tt> v = {0., 1., 2., 3., 4., 5., 6., 7., 8.};
+  Mtx<tt> a(3, 3, v);
+  a = a.view().t() + a;
+  D2IterC(ir, ic, 0, 3, 0, 3) EXPECT_EQ(v[ir + ic * 3] + v[ic + ir * 3], a(ir, ic));
+  EXPECT_EQ(4., a(0, 1));
+  EXPECT_EQ(8., a(0, 2));
+  EXPECT_EQ(12., a(1, 2));
+
+  for (bool rotated : {false, true}){
+    Mtx<tt> b = random_mtx<tt>(20, 20);
+    if (rotated) b.flip();
+    Mtx<tt> e(b);
+    b.add(b.view().t());
+    D2IterC(ir, ic, 0, 20, 0, 20) EXPECT_EQ(e(ir, ic) + e(ic, ir), b(ir, ic));
+
+    //overlapping shifted blocks of the same matrix
+    Mtx<tt> c(e);
+    c.view(1, 0, 19, 20).assign(c.view(0, 0, 19, 20));
+    c.view(0, 1, 20, 19).add(c.view(0, 0, 20, 19));
+    D2IterC(ir, ic, 0, 20, 1, 20)
+      EXPECT_EQ(e(ir == 0 ? 0 : ir - 1, ic) + e(ir == 0 ? 0 : ir - 1, ic - 1), c(ir, ic));
+  }
+}
+
+TEST(View, Dot){
+  Mtx<tt> a = random_mtx<tt>(40, 50);
+  Mtx<tt> b = random_mtx<tt>(60, 30);
+  MtxView<tt> va = a.view(5, 7, 20, 25);
+  MtxView<tt> vb = b.view(10, 2, 25, 15);
+  Mtx<tt> ca(va), cb(vb);
+  Mtx<tt> expect = naive_dot(ca, cb);
+  Mtx<tt> r1 = va.dot(vb);
+  Mtx<tt> r2 = va * vb;
+  Mtx<tt> r3 = ca * vb;
+  Mtx<tt> r4 = vb.t().dot(va.t());
+  D2IterC(ir, ic, 0, expect.rows(), 0, expect.cols()){
+    EXPECT_NEAR(expect(ir, ic), r1(ir, ic), 1e-9);
+    EXPECT_NEAR(expect(ir, ic), r2(ir, ic), 1e-9);
+    EXPECT_NEAR(expect(ir, ic), r3(ir, ic), 1e-9);
+    EXPECT_NEAR(expect(ir, ic), r4(ic, ir), 1e-9);
+  }
+}
+
+Arena test_arena;
+BufferPool& test_arena_pool(){
+  static ArenaBufferPool pool(test_arena);
+  return pool;
+}
+
+TEST(Alloc, Aligned){
+  for (size_t n : {1, 3, 17, 100}){
+    Mtx<float> a(n, n + 1, 1.f);
+    EXPECT_EQ(0U, (size_t)a.view().data() % MTX_ALIGN);
+    a.flip();
+    EXPECT_EQ(0U, (size_t)a.view().data() % MTX_ALIGN);
+    Mtx<float> b = a + a;
+    EXPECT_EQ(0U, (size_t)b.view().data() % MTX_ALIGN);
+  }
+}
+
+TEST(Alloc, PoolRecycles){
+  BufferPool pool;
+  void* p = pool.acquire(1000);
+  EXPECT_EQ(0U, (size_t)p % MTX_ALIGN);
+  pool.release(p, 1000);
+  EXPECT_EQ(1024U, pool.cached());
+  //same size class
+  void* q = pool.acquire(600);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(1U, pool.hits());
+  EXPECT_EQ(0U, pool.cached());
+  pool.release(q, 600);
+
+  pool.set_max_cached(1024);
+  void* r = pool.acquire(100);
+  pool.release(r, 100);
+  EXPECT_EQ(1024U, pool.cached());
+  pool.trim();
+  EXPECT_EQ(0U, pool.cached());
+}
+
+TEST(Alloc, PooledMtx){
+  using PMtx = Mtx<tt, PooledAlloc<tt>>;
+  default_buffer_pool().trim();
+  size_t hits = default_buffer_pool().hits();
+  Mtx<tt> ra = random_mtx<tt>(30, 40), rb = random_mtx<tt>(40, 20);
+  PMtx a(30, 40), b(40, 20);
+  a.view().assign(ra);
+  b.view().assign(rb);
+  Mtx<tt> expect = naive_dot(ra, rb);
+  for (size_t i = 0; i < 4; ++i){
+    PMtx c = a * b;
+    PMtx d = c + c;
+    d.flip();
+    D2IterC(ir, ic, 0, c.rows(), 0, c.cols()){
+      EXPECT_NEAR(expect(ir, ic), c(ir, ic), 1e-9);
+      EXPECT_NEAR(2. * expect(ir, ic), d(ir, ic), 1e-9);
+    }
+  }
+  //every iteration after the first reuses the temporaries of the one before
+  EXPECT_LE(hits + 6, default_buffer_pool().hits());
+  Mtx<tt> mixed = ra * b;
+  D2IterC(ir, ic, 0, mixed.rows(), 0, mixed.cols()) EXPECT_NEAR(expect(ir, ic), mixed(ir, ic), 1e-9);
+}
+
+TEST(Alloc, ArenaPool){
+  using AMtx = Mtx<tt, PooledAlloc<tt, test_arena_pool>>;
+  for (size_t i = 0; i < 3; ++i){
+    AMtx a(33, 17, 2.);
+    EXPECT_EQ(0U, (size_t)a.view().data() % MTX_ALIGN);
+    a.t();
+    AMtx b = a + a;
+    EXPECT_EQ(17U, b.rows());
+    D2IterC(ir, ic, 0, b.rows(), 0, b.cols()) EXPECT_EQ(4., b(ir, ic));
+  }
+  EXPECT_LT(0U, test_arena_pool().hits());
+}
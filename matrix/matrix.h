@@ -5,9 +5,17 @@
 #include <cassert>
 #include <cstring>
 #include <cmath>
+#include <new>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <utility>
+#include <type_traits>
+
+#include "mtx_alloc.h"
+#include "gemm.h"
+#include "transpose.h"
+#include "../thread_pool/thread_pool.h"
 using namespace std;
 
 #define D1Iter(i, ib, ie) \
@@ -17,22 +25,59 @@ using namespace std;
 #define D2IterR(ir, ic, rb, re, cb, ce) \
   for (size_t ir = rb; ir < re; ++ir) for (size_t ic = cb; ic < ce; ++ic)
 
-const unsigned long long PTR_MASK = 0xFFFFFFFFFFFFFFFEUL;
+//low bits of the data pointer: 0x1 rotated buffer, 0x2 borrowed buffer (not owned, read only)
+const unsigned long long PTR_MASK = 0xFFFFFFFFFFFFFFFCUL;
 const unsigned STRIDE = 32 * 1024; //TODO
+const size_t MTX_PAR_GRAIN = 32 * 1024; //minimum number of elements handed to one thread
+
+/* matrix operations run on default_pool(); n extra worker threads, 0 runs everything on the
+ * calling thread. transforms given to foreach must be safe to call concurrently when n > 0 */
+inline void set_mtx_threads(size_t n){
+  default_pool().resize(n);
+}
+
+template <typename T, typename A = AlignedAlloc<T>> class Mtx;
+template <typename T, typename A = AlignedAlloc<T>> class RowRef;
+template <typename T, typename A = AlignedAlloc<T>> class ColRef;
+template <typename T> class MtxLeaf;
+template <typename T> class MappedMtx;
+template <typename T> class MtxView;
+template <typename X> struct MtxTerm;
 
-template <typename T> class RowRef;
-template <typename T> class ColRef;
+/* tag base of every lazy element-wise expression, see MtxBinExpr */
+struct MtxExprBase {};
+template <typename E>
+using enable_if_expr = typename enable_if<is_base_of<MtxExprBase, E>::value>::type;
 
 enum MtxDim {
   MCol,
   MRow,
 };
 
-/* column locality matrix */
+/* true if the r x c blocks a and b, element (i, j) at x[i * rs + j * cs], may share elements
+ * at different positions; a single pass writing b while reading a could then read a value
+ * it has already overwritten. blocks over the same elements in the same order are safe */
 template <typename T>
+bool mtx_aliases(const T* a, size_t r, size_t c, size_t ars, size_t acs, const T* b, size_t brs, size_t bcs){
+  if (r == 0 || c == 0 || (a == b && ars == brs && acs == bcs)) return false;
+  size_t alo = (size_t)a, ahi = (size_t)(a + (r - 1) * ars + (c - 1) * acs);
+  size_t blo = (size_t)b, bhi = (size_t)(b + (r - 1) * brs + (c - 1) * bcs);
+  return alo <= bhi && blo <= ahi;
+}
+
+/* column locality matrix
+ *   A is the buffer allocation policy, see mtx_alloc.h; buffers are MTX_ALIGN aligned by
+ *   default, PooledAlloc recycles them
+ */
+template <typename T, typename A>
 class Mtx {
-  friend class RowRef<T>;
-  friend class ColRef<T>;
+  friend class RowRef<T, A>;
+  friend class ColRef<T, A>;
+  friend class MtxLeaf<T>;
+  friend class MappedMtx<T>;
+  friend class MtxView<T>;
+  friend class MtxView<const T>;
+  template <typename U, typename B> friend bool save_binary(const Mtx<U, B>&, const string&);
 
   mutable T* mData;
   size_t mRows;
@@ -55,66 +100,122 @@ class Mtx {
   void flip_bit() const {
     mData = (T*)((size_t)mData ^ 0x1UL);
   }
+  bool is_borrowed() const {
+    return ((size_t)mData & 0x2UL);
+  }
+  void release() {
+    T* data = dataptr();
+    if (data && not is_borrowed()) A::deallocate(data, mRows * mCols);
+    mData = nullptr;
+  }
+  //distance between two adjacent rows and two adjacent columns in the buffer
+  size_t rstride() const {
+    return is_rotated() ? mCols : 1;
+  }
+  size_t cstride() const {
+    return is_rotated() ? 1 : mRows;
+  }
+  //f(b, e) over element range [0, n), split across the shared pool
+  template <typename F>
+  static void par_for(size_t n, size_t grain, F&& f){
+    default_pool().parallel_for(0, n, grain, f);
+  }
+  size_t col_grain() const {
+    return MTX_PAR_GRAIN / max(mRows, (size_t)1) + 1;
+  }
+  size_t row_grain() const {
+    return MTX_PAR_GRAIN / max(mCols, (size_t)1) + 1;
+  }
+  //fused evaluation of an expression into the existing buffer; linear when every operand
+  //shares this matrix's layout
+  template <typename E>
+  void assign(const E& e){
+    T* data = dataptr();
+    if (e.uniform(is_rotated()))
+      par_for(mRows * mCols, MTX_PAR_GRAIN, [&](size_t b, size_t en){
+        D1Iter(i, b, en) data[i] = e.at(i);
+      });
+    else {
+      size_t rs = rstride(), cs = cstride();
+      par_for(mCols, col_grain(), [&](size_t b, size_t en){
+        D2IterC(ir, ic, 0, mRows, b, en) data[ir * rs + ic * cs] = e(ir, ic);
+      });
+    }
+  }
   
+  //physically transpose the buffer: a column buffer becomes a row buffer and vice versa,
+  //the caller updates the rotation bit
   void rotate() const {
     T* data = dataptr();
-    vector<bool> visited(rows() * cols(), false);
-    for (size_t i = 0; i < cols(); ++i)
-      for (size_t j = 0; j < rows(); ++j){
-        size_t orig = j + i * rows();
-        size_t dest = i + j * cols();
-
-        if (visited[orig]) continue;
-        if (orig == dest) continue;
-
-        T valence = data[dest];
-        while (not visited[orig]){
-          data[dest] = data[orig];
-          visited[dest] = true;
-
-          size_t col = orig / cols();
-          size_t row = orig % cols();
-          dest = orig;
-          orig = col + row * rows();
-        }
-        data[dest] = valence;
-        visited[dest] = true;
-      }
+    size_t r = is_rotated() ? mCols : mRows;
+    size_t c = is_rotated() ? mRows : mCols;
+    if (r <= 1 || c <= 1) return;
+
+    //a borrowed buffer is read only, the transpose always lands in a new owned buffer
+    if (is_borrowed()){
+      T* dst = A::allocate(r * c);
+      transpose_oop(data, dst, r, c);
+      mData = (T*)((size_t)dst | ((size_t)mData & 0x1UL));
+      return;
+    }
+
+    //square matrices transpose in place as fast as out of place; otherwise take the out of
+    //place path whenever a second buffer can be allocated
+    T* dst = nullptr;
+    if (r != c)
+      try { dst = A::allocate(r * c); } catch (const bad_alloc&) {}
+    if (dst == nullptr){
+      transpose_inplace(data, r, c);
+      return;
+    }
+    transpose_oop(data, dst, r, c);
+    A::deallocate(data, r * c);
+    mData = (T*)((size_t)dst | ((size_t)mData & 0x1UL));
+  }
+  //wrap a buffer owned by someone else, used by MappedMtx for zero-copy file views
+  Mtx(const T* data, size_t r, size_t c, bool rotated): mData(nullptr), mRows(r), mCols(c) {
+    mData = (T*)((size_t)data | 0x2UL | (rotated ? 0x1UL : 0x0UL));
   }
 public:
   /* constructors, destructors, assignment operators */
   Mtx(): mData(nullptr) {} //mRows mCols undefined
   Mtx(size_t r, size_t c, T s = 0): mData(nullptr), mRows(r), mCols(c) {
-    mData = new T[r * c];
+    mData = A::allocate(r * c);
     D1Iter(i, 0, r * c) mData[i] = s;
   }
   //NOTE: vector<T> is a vector of columns
   Mtx(size_t r, size_t c, const vector<T>& data): mData(nullptr), mRows(r), mCols(c) {
     assert(data.size() == r * c);
-    mData = new T[r * c];
+    mData = A::allocate(r * c);
     memcpy(mData, data.data(), sizeof(T) * r * c);
   }
-  Mtx(const Mtx& o): mRows(o.mRows), mCols(o.mCols) {
+  Mtx(const Mtx& o): mData(nullptr), mRows(o.mRows), mCols(o.mCols) {
     T* optr = o.dataptr();
     if (not optr) return;
-    mData = new T[rows() * cols()];
+    mData = A::allocate(rows() * cols());
     memcpy(dataptr(), optr, sizeof(T) * rows() * cols());
     if (o.is_rotated())
       flip_bit();
   }
-  Mtx(Mtx&& o) = default;
+  Mtx(Mtx&& o): mData(o.mData), mRows(o.mRows), mCols(o.mCols) {
+    o.mData = nullptr;
+  }
+  //evaluate an element-wise expression in a single pass, no intermediate matrix is created
+  template <typename E, typename = enable_if_expr<E>>
+  Mtx(const E& e): mData(nullptr), mRows(e.rows()), mCols(e.cols()) {
+    mData = A::allocate(mRows * mCols);
+    if (e.rotated()) flip_bit();
+    assign(e);
+  }
   ~Mtx() {
-    T* data = dataptr();
-    if (data) delete[] data;
-    mData = nullptr;
+    release();
   }
   Mtx& operator=(const Mtx& o){
-    T* data = dataptr();
     T* odata = o.dataptr();
     if (&o == this) return *this;
-    delete[] data;
+    release();
 
-    mData = new T[o.rows() * o.cols()];
+    mData = A::allocate(o.rows() * o.cols());
     mRows = o.rows();
     mCols = o.cols();
     memcpy(mData, odata, sizeof(T) * rows() * cols());
@@ -125,8 +226,7 @@ public:
   Mtx& operator=(Mtx&& o){
     if (this == &o) return *this;
 
-    T* data = dataptr();
-    delete[] data;
+    release();
 
     mData = o.mData;
     mRows = o.mRows;
@@ -135,6 +235,18 @@ public:
     o.mData = nullptr;
     return *this;
   }
+  template <typename E, typename = enable_if_expr<E>>
+  Mtx& operator=(const E& e){
+    //operands may alias this matrix as long as every element only reads its own position, a
+    //transposed or shifted view of it is evaluated into a new buffer first
+    if (dataptr() == nullptr || mRows != e.rows() || mCols != e.cols() ||
+        e.aliases(dataptr(), rstride(), cstride())){
+      Mtx tmp(e);
+      return *this = move(tmp);
+    }
+    assign(e);
+    return *this;
+  }
   explicit Mtx(const string& filename): mData(nullptr) {
     ifstream in(filename.c_str());
     if (not in.is_open()){
@@ -150,7 +262,7 @@ public:
     mRows = r;
     mCols = c;
 
-    mData = new T[vec.size()];
+    mData = A::allocate(r * c);
 
     memcpy(mData, vec.data(), sizeof(T) * r * c);
   }
@@ -158,10 +270,17 @@ public:
   /* accessors */
   size_t rows() const { return mRows; }
   size_t cols() const { return mCols; }
-  const RowRef<T> row(size_t idx) const;
-  RowRef<T> row(size_t idx);
-  const ColRef<T> col(size_t idx) const;
-  ColRef<T> col(size_t idx);
+  const RowRef<T, A> row(size_t idx) const;
+  RowRef<T, A> row(size_t idx);
+  const ColRef<T, A> col(size_t idx) const;
+  ColRef<T, A> col(size_t idx);
+  //non-owning views of the whole matrix or of the nr x nc block starting at (r0, c0); a view
+  //is invalidated by anything that moves the buffer, e.g. flip(), unflip() or t(). the view
+  //of a const matrix is read only
+  MtxView<T> view();
+  MtxView<const T> view() const;
+  MtxView<T> view(size_t r0, size_t c0, size_t nr, size_t nc);
+  MtxView<const T> view(size_t r0, size_t c0, size_t nr, size_t nc) const;
   T operator()(size_t r, size_t c) const {
     assert(dataptr() != nullptr);
     if (not is_rotated()) return dataptr()[index(r, c)];
@@ -177,142 +296,98 @@ public:
   Mtx& add(T val){
     T* data = dataptr();
     assert(data != nullptr);
-    D1Iter(i, 0U, rows() * cols()) data[i] += val;
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, val](size_t b, size_t e){
+      D1Iter(i, b, e) data[i] += val;
+    });
     return *this;
   }
   Mtx& sub(T val){
     T* data = dataptr();
     assert(data != nullptr);
-    D1Iter(i, 0U, rows() * cols()) data[i] -= val;
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, val](size_t b, size_t e){
+      D1Iter(i, b, e) data[i] -= val;
+    });
     return *this;
   }
   Mtx& mul(T val){
     T* data = dataptr();
     assert(data != nullptr);
-    D1Iter(i, 0U, rows() * cols()) data[i] *= val;
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, val](size_t b, size_t e){
+      D1Iter(i, b, e) data[i] *= val;
+    });
     return *this;
   }
   Mtx& div(T val){
     T* data = dataptr();
     assert(data != nullptr);
     assert(val != T());
-    D1Iter(i, 0U, rows() * cols()) data[i] /= val;
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, val](size_t b, size_t e){
+      D1Iter(i, b, e) data[i] /= val;
+    });
     return *this;
   }
   Mtx& pow(T val){
     T* data = dataptr();
     assert(data != nullptr);
-    D1Iter(i, 0U, rows() * cols()) data[i] = std::pow(data[i], val);
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, val](size_t b, size_t e){
+      D1Iter(i, b, e) data[i] = std::pow(data[i], val);
+    });
     return *this;
   }
   template <typename F>
   Mtx& foreach(F&& transform){
     T* data = dataptr();
     assert(data != nullptr);
-    D1Iter(i, 0U, rows() * cols()) transform(data[i]);
+    par_for(rows() * cols(), MTX_PAR_GRAIN, [data, &transform](size_t b, size_t e){
+      D1Iter(i, b, e) transform(data[i]);
+    });
     return *this;
   }
 
-  /* matrix operations */
-  Mtx& add(const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
-    T* data = dataptr();
-    T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) data[i] += odata[i];
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[index(ir, ic)] += odata[rindex(ir, ic)];
-    else
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[rindex(ir, ic)] += odata[index(ir, ic)];
-    return *this;
+  /* matrix operations, o is a Mtx or a view of one */
+  Mtx& add(const MtxView<const T>& o){
+    return foreach([](T& a, const T& b){ a += b; }, o);
   }
-  Mtx& sub(const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
-    T* data = dataptr();
-    T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) data[i] -= odata[i];
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[index(ir, ic)] -= odata[rindex(ir, ic)];
-    else
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[rindex(ir, ic)] -= odata[index(ir, ic)];
-    return *this;
+  Mtx& sub(const MtxView<const T>& o){
+    return foreach([](T& a, const T& b){ a -= b; }, o);
   }
-  Mtx& mul(const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
-    T* data = dataptr();
-    T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) data[i] *= odata[i];
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[index(ir, ic)] *= odata[rindex(ir, ic)];
-    else
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[rindex(ir, ic)] *= odata[index(ir, ic)];
-    return *this;
+  Mtx& mul(const MtxView<const T>& o){
+    return foreach([](T& a, const T& b){ a *= b; }, o);
   }
-  Mtx& div(const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
-    T* data = dataptr();
-    T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) data[i] /= odata[i];
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[index(ir, ic)] /= odata[rindex(ir, ic)];
-    else
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[rindex(ir, ic)] /= odata[index(ir, ic)];
-    return *this;
+  Mtx& div(const MtxView<const T>& o){
+    return foreach([](T& a, const T& b){ a /= b; }, o);
   }
-  Mtx& pow(const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
-    T* data = dataptr();
-    T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) data[i] = std::pow(data[i], odata[i]);
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[index(ir, ic)] = std::pow(data[index(ir, ic)], odata[rindex(ir, ic)]);
-    else
-      D2IterC(ir, ic, 0, mRows, 0, mCols) data[rindex(ir, ic)] = std::pow(data[rindex(ir, ic)], odata[index(ir, ic)]);
-    return *this;
+  Mtx& pow(const MtxView<const T>& o){
+    return foreach([](T& a, const T& b){ a = std::pow(a, b); }, o);
   }
   template <typename F>
-  Mtx& foreach(F transform, const Mtx& o){
-    assert(mRows == o.mRows && mCols == o.mCols);
+  Mtx& foreach(F transform, const MtxView<const T>& o){
+    assert(mRows == o.rows() && mCols == o.cols());
+    if (o.aliases(dataptr(), rstride(), cstride())){
+      Mtx<T> copy(o);
+      return foreach(transform, copy);
+    }
 
     T* data = dataptr();
-    const T* odata = o.dataptr();
-    if (is_rotated() == o.is_rotated())
-      D1Iter(i, 0U, mRows * mCols) transform(data[i], odata[i]);
-    else if (o.is_rotated() && not is_rotated())
-      D2IterC(ir, ic, 0U, mRows, 0U, mCols) transform(data[index(ir, ic)], odata[rindex(ir, ic)]);
+    const T* odata = o.data();
+    if (o.uniform(is_rotated()))
+      par_for(mRows * mCols, MTX_PAR_GRAIN, [&](size_t b, size_t e){
+        D1Iter(i, b, e) transform(data[i], odata[i]);
+      });
+    else if (not is_rotated())
+      par_for(mCols, col_grain(), [&](size_t b, size_t e){
+        D2IterC(ir, ic, 0U, mRows, b, e) transform(data[index(ir, ic)], o(ir, ic));
+      });
     else
-      D2IterC(ir, ic, 0U, mRows, 0U, mCols) transform(data[rindex(ir, ic)], odata[index(ir, ic)]);
+      par_for(mRows, row_grain(), [&](size_t b, size_t e){
+        D2IterR(ir, ic, b, e, 0U, mCols) transform(data[rindex(ir, ic)], o(ir, ic));
+      });
     return *this;
   }
 
   /* matrix multiplication */
-  Mtx dot(const Mtx& o) const {
-    assert(cols() == o.rows());
-
-    Mtx ret(rows(), o.cols());
-    T* a = dataptr();
-    T* b = o.dataptr();
-    T* c = ret.dataptr();
-
-    o.unflip();
-
-    if (is_rotated()){
-      for (size_t i = 0; i < rows(); ++i)
-        for (size_t j = 0; j < o.cols(); ++j)
-          for (size_t k = 0; k < cols(); ++k)
-            c[ret.rindex(i, j)] += a[rindex(i, k)] * b[o.index(k, j)];
-      ret.flip_bit();
-    } else {
-      for (size_t i = 0; i < rows(); ++i)
-        for (size_t j = 0; j < o.cols(); ++j)
-          for (size_t k = 0; k < cols(); ++k)
-            c[ret.index(i, j)] += a[index(i, k)] * b[o.index(k, j)];
-    }
-    return ret;
+  Mtx dot(const MtxView<const T>& o) const {
+    return view().template dot<A>(o);
   }
 
   /* transpose functions */
@@ -328,14 +403,17 @@ public:
     return *this;
   }
   //return a copy of self that is transposed
-  Mtx transpose(){
-    Mtx ret = *this;
-    if (ret.is_rotated()) ret.flip_bit();
-    else                  ret.rotate();
-
-    ret.mRows = mCols;
-    ret.mCols = mRows;
-
+  Mtx transpose() const {
+    if (is_rotated()){
+      Mtx ret = *this;
+      ret.flip_bit();
+      ret.mRows = mCols;
+      ret.mCols = mRows;
+      return ret;
+    }
+    //transpose straight into the new buffer instead of copying and then rotating
+    Mtx ret(mCols, mRows, 0);
+    transpose_oop(dataptr(), ret.dataptr(), mRows, mCols);
     return ret;
   }
 
@@ -358,58 +436,19 @@ public:
   }
 
   /* statistics functions */
+  //every output is reduced by a single thread in the same order as a sequential run, so the
+  //result does not depend on the number of threads
   vector<size_t> maxi(MtxDim dim) const {
-    size_t n = dim == MCol ? mCols : mRows;
-    vector<size_t> ret(n, 0);
-    IndexFP indexfp = is_rotated() ? &Mtx::rindex : &Mtx::index;
-    T* data = dataptr();
-
-    if (dim == MCol){
-      D2IterC(ir, ic, 0, rows(), 0, cols())
-        if (data[(this->*indexfp)(ir, ic)] > data[(this->*indexfp)(ret[ic], ic)])
-          ret[ic] = ir;
-    } else {
-      D2IterC(ir, ic, 0, rows(), 0, cols())
-        if (data[(this->*indexfp)(ir, ic)] > data[(this->*indexfp)(ir, ret[ir])])
-          ret[ir] = ic;
-    }
-    return ret;
+    return view().maxi(dim);
   }
   vector<size_t> mini(MtxDim dim) const {
-    size_t n = dim == MCol ? mCols : mRows;
-    vector<size_t> ret(n, 0);
-    IndexFP indexfp = is_rotated() ? &Mtx::rindex : &Mtx::index;
-    T* data = dataptr();
-
-    if (dim == MCol){
-      D2IterC(ir, ic, 0, rows(), 0, cols())
-        if (data[(this->*indexfp)(ir, ic)] < data[(this->*indexfp)(ret[ic], ic)])
-          ret[ic] = ir;
-    } else {
-      D2IterC(ir, ic, 0, rows(), 0, cols())
-        if (data[(this->*indexfp)(ir, ic)] < data[(this->*indexfp)(ir, ret[ir])])
-          ret[ir] = ic;
-    }
-    return ret;
+    return view().mini(dim);
   }
   vector<T> sum(MtxDim dim) const {
-    size_t n = dim == MCol ? mCols : mRows;
-    vector<T> ret(n, 0.);
-    IndexFP findex = is_rotated() ? &Mtx::rindex : &Mtx::index;
-    T* data = dataptr();
-
-    if (dim == MCol){
-      D2IterC(ir, ic, 0, rows(), 0, cols()) ret[ic] += data[(this->*findex)(ir, ic)];
-    } else {
-      D2IterR(ir, ic, 0, rows(), 0, cols()) ret[ir] += data[(this->*findex)(ir, ic)];
-    }
-    return ret;
+    return view().sum(dim);
   }
   vector<T> mean(MtxDim dim) const {
-    vector<T> ret = sum(dim);
-    size_t n = dim == MCol ? mRows : mCols;
-    D1Iter(i, 0, ret.size()) ret[i] /= (double)n;
-    return ret;
+    return view().mean(dim);
   }
 
   /* save matrix to file */
@@ -436,12 +475,12 @@ public:
   }
 };
 
-template <typename T>
+template <typename T, typename A>
 class RowRef {
-  Mtx<T>& mMtx;
+  Mtx<T, A>& mMtx;
   size_t mRowId;
 public:
-  RowRef(Mtx<T>& m, size_t r): mMtx(m), mRowId(r) {}
+  RowRef(Mtx<T, A>& m, size_t r): mMtx(m), mRowId(r) {}
 
   size_t size() const { return mMtx.cols(); }
 
@@ -494,12 +533,12 @@ public:
   }
 };
 
-template <typename T>
+template <typename T, typename A>
 class ColRef {
-  Mtx<T>& mMtx;
+  Mtx<T, A>& mMtx;
   size_t mColId;
 public:
-  ColRef(Mtx<T>& m, size_t c): mMtx(m), mColId(c) {}
+  ColRef(Mtx<T, A>& m, size_t c): mMtx(m), mColId(c) {}
 
   size_t size() const { return mMtx.rows(); }
 
@@ -552,52 +591,419 @@ public:
   }
 };
 
-template <typename T>
-const RowRef<T> Mtx<T>::row(size_t idx) const {
-  return RowRef<T>(const_cast<Mtx<T>&>(*this), idx);
+template <typename T, typename A>
+const RowRef<T, A> Mtx<T, A>::row(size_t idx) const {
+  return RowRef<T, A>(const_cast<Mtx<T, A>&>(*this), idx);
 }
-template <typename T>
-RowRef<T> Mtx<T>::row(size_t idx){
-  return RowRef<T>(*this, idx);
+template <typename T, typename A>
+RowRef<T, A> Mtx<T, A>::row(size_t idx){
+  return RowRef<T, A>(*this, idx);
 }
-template <typename T>
-const ColRef<T> Mtx<T>::col(size_t idx) const {
-  return ColRef<T>(const_cast<Mtx<T>&>(*this), idx);
+template <typename T, typename A>
+const ColRef<T, A> Mtx<T, A>::col(size_t idx) const {
+  return ColRef<T, A>(const_cast<Mtx<T, A>&>(*this), idx);
 }
-template <typename T>
-ColRef<T> Mtx<T>::col(size_t idx){
-  return ColRef<T>(*this, idx);
+template <typename T, typename A>
+ColRef<T, A> Mtx<T, A>::col(size_t idx){
+  return ColRef<T, A>(*this, idx);
 }
 
-/* operators that does not generate new matrix instances */
-
-/* operators that generate new matrix instances */
+/* non-owning view of a rectangular block of a Mtx
+ *   element (r, c) is at data()[r * rstride() + c * cstride()], which covers a whole matrix in
+ *   either layout, any sub-block of it and its transpose; taking a view, a sub-view or a
+ *   transposed view never copies. a view takes part in element-wise expressions like a Mtx,
+ *   and Mtx arithmetic, dot and the statistics functions accept one wherever they accept a Mtx.
+ *   copies of a view refer to the same elements, use assign() to copy values into a view.
+ *   MtxView<const T>, the view of a const Mtx, is read only: it reads like any other view,
+ *   its mutating members do not compile, and a MtxView<T> converts to it but not back.
+ */
 template <typename T>
-Mtx<T> operator+(const Mtx<T>& a, const Mtx<T>& b){
-  Mtx<T> ret(a);
-  ret.add(b);
-  return ret;
+class MtxView : public MtxExprBase {
+  template <typename U> friend class MtxView;
+public:
+  using value_type = typename remove_const<T>::type;
+private:
+  T* mData;
+  size_t mRows;
+  size_t mCols;
+  size_t mRStride;
+  size_t mCStride;
+
+  static size_t grain(size_t n){
+    return MTX_PAR_GRAIN / max(n, (size_t)1) + 1;
+  }
+  //f(ir, ic) over every element, split across the shared pool along the outer dimension of
+  //the underlying buffer
+  template <typename F>
+  void par_each(F&& f) const {
+    static_assert(not is_const<T>::value, "the view of a const matrix is read only");
+    if (not rotated())
+      default_pool().parallel_for(0, mCols, grain(mRows), [&](size_t b, size_t e){
+        D2IterC(ir, ic, 0U, mRows, b, e) f(ir, ic);
+      });
+    else
+      default_pool().parallel_for(0, mRows, grain(mCols), [&](size_t b, size_t e){
+        D2IterR(ir, ic, b, e, 0U, mCols) f(ir, ic);
+      });
+  }
+public:
+  MtxView(T* data, size_t r, size_t c, size_t rs, size_t cs):
+    mData(data), mRows(r), mCols(c), mRStride(rs), mCStride(cs) {}
+  template <typename A>
+  MtxView(Mtx<value_type, A>& m):
+    mData(m.dataptr()), mRows(m.rows()), mCols(m.cols()), mRStride(m.rstride()), mCStride(m.cstride()) {
+    assert(mData != nullptr);
+  }
+  template <typename A, typename U = T, typename = typename enable_if<is_const<U>::value>::type>
+  MtxView(const Mtx<value_type, A>& m):
+    mData(m.dataptr()), mRows(m.rows()), mCols(m.cols()), mRStride(m.rstride()), mCStride(m.cstride()) {
+    assert(mData != nullptr);
+  }
+  //a writable view is also a read only one
+  template <typename U, typename = typename enable_if<is_same<const U, T>::value>::type>
+  MtxView(const MtxView<U>& o):
+    mData(o.mData), mRows(o.mRows), mCols(o.mCols), mRStride(o.mRStride), mCStride(o.mCStride) {}
+
+  /* accessors */
+  size_t rows() const { return mRows; }
+  size_t cols() const { return mCols; }
+  size_t rstride() const { return mRStride; }
+  size_t cstride() const { return mCStride; }
+  T* data() const { return mData; }
+  value_type operator()(size_t r, size_t c) const {
+    return mData[r * mRStride + c * mCStride];
+  }
+  T& operator()(size_t r, size_t c){
+    return mData[r * mRStride + c * mCStride];
+  }
+  MtxView view(size_t r0, size_t c0, size_t nr, size_t nc) const {
+    assert(r0 + nr <= mRows && c0 + nc <= mCols);
+    return MtxView(mData + r0 * mRStride + c0 * mCStride, nr, nc, mRStride, mCStride);
+  }
+  MtxView t() const {
+    return MtxView(mData, mCols, mRows, mCStride, mRStride);
+  }
+
+  /* element-wise expression interface, see MtxBinExpr */
+  bool rotated() const { return mRStride > mCStride; }
+  //linear access is only valid when the view is a whole buffer in the requested layout
+  bool uniform(bool rotated) const {
+    return rotated ? mCStride == 1 && mRStride == mCols : mRStride == 1 && mCStride == mRows;
+  }
+  //see mtx_aliases, data is a block of the same size as this view
+  bool aliases(const value_type* data, size_t rs, size_t cs) const {
+    return mtx_aliases<value_type>(mData, mRows, mCols, mRStride, mCStride, data, rs, cs);
+  }
+  value_type at(size_t i) const { return mData[i]; }
+
+  /* scalar operations */
+  MtxView& add(T val){
+    par_each([&](size_t ir, size_t ic){ (*this)(ir, ic) += val; });
+    return *this;
+  }
+  MtxView& sub(T val){
+    par_each([&](size_t ir, size_t ic){ (*this)(ir, ic) -= val; });
+    return *this;
+  }
+  MtxView& mul(T val){
+    par_each([&](size_t ir, size_t ic){ (*this)(ir, ic) *= val; });
+    return *this;
+  }
+  MtxView& div(T val){
+    assert(val != T());
+    par_each([&](size_t ir, size_t ic){ (*this)(ir, ic) /= val; });
+    return *this;
+  }
+  MtxView& pow(T val){
+    par_each([&](size_t ir, size_t ic){ T& v = (*this)(ir, ic); v = std::pow(v, val); });
+    return *this;
+  }
+  template <typename F>
+  MtxView& foreach(F&& transform){
+    par_each([&](size_t ir, size_t ic){ transform((*this)(ir, ic)); });
+    return *this;
+  }
+
+  /* matrix operations, o is a Mtx or a view of one */
+  MtxView& add(const MtxView<const value_type>& o){
+    return foreach([](T& a, const T& b){ a += b; }, o);
+  }
+  MtxView& sub(const MtxView<const value_type>& o){
+    return foreach([](T& a, const T& b){ a -= b; }, o);
+  }
+  MtxView& mul(const MtxView<const value_type>& o){
+    return foreach([](T& a, const T& b){ a *= b; }, o);
+  }
+  MtxView& div(const MtxView<const value_type>& o){
+    return foreach([](T& a, const T& b){ a /= b; }, o);
+  }
+  MtxView& pow(const MtxView<const value_type>& o){
+    return foreach([](T& a, const T& b){ a = std::pow(a, b); }, o);
+  }
+  template <typename F>
+  MtxView& foreach(F transform, const MtxView<const value_type>& o){
+    assert(mRows == o.mRows && mCols == o.mCols);
+    if (o.aliases(mData, mRStride, mCStride)){
+      Mtx<value_type> copy(o);
+      return foreach(transform, copy);
+    }
+    par_each([&](size_t ir, size_t ic){ transform((*this)(ir, ic), o(ir, ic)); });
+    return *this;
+  }
+  //write the values of a Mtx, a view or an element-wise expression into the viewed elements
+  template <typename E>
+  MtxView& assign(const E& e){
+    typename MtxTerm<E>::type term(e);
+    assert(mRows == term.rows() && mCols == term.cols());
+    if (term.aliases(mData, mRStride, mCStride))
+      return assign(Mtx<value_type>(term));
+    par_each([&](size_t ir, size_t ic){ (*this)(ir, ic) = term(ir, ic); });
+    return *this;
+  }
+
+  /* matrix multiplication */
+  template <typename A = AlignedAlloc<value_type>>
+  Mtx<value_type, A> dot(const MtxView<const value_type>& o) const {
+    assert(mCols == o.mRows);
+
+    Mtx<value_type, A> ret(mRows, o.mCols);
+    MtxView<value_type> r = ret.view();
+    gemm(mRows, o.mCols, mCols, (value_type)1,
+         mData, mRStride, mCStride,
+         o.mData, o.mRStride, o.mCStride,
+         r.mData, r.mRStride, r.mCStride);
+    return ret;
+  }
+
+  /* statistics functions */
+  //every output is reduced by a single thread in the same order as a sequential run, so the
+  //result does not depend on the number of threads
+  vector<size_t> maxi(MtxDim dim) const {
+    size_t n = dim == MCol ? mCols : mRows;
+    vector<size_t> ret(n, 0);
+    const MtxView& m = *this;
+
+    if (dim == MCol){
+      default_pool().parallel_for(0, mCols, grain(mRows), [&](size_t b, size_t e){
+        D2IterC(ir, ic, 0, mRows, b, e)
+          if (m(ir, ic) > m(ret[ic], ic))
+            ret[ic] = ir;
+      });
+    } else {
+      default_pool().parallel_for(0, mRows, grain(mCols), [&](size_t b, size_t e){
+        D2IterC(ir, ic, b, e, 0, mCols)
+          if (m(ir, ic) > m(ir, ret[ir]))
+            ret[ir] = ic;
+      });
+    }
+    return ret;
+  }
+  vector<size_t> mini(MtxDim dim) const {
+    size_t n = dim == MCol ? mCols : mRows;
+    vector<size_t> ret(n, 0);
+    const MtxView& m = *this;
+
+    if (dim == MCol){
+      default_pool().parallel_for(0, mCols, grain(mRows), [&](size_t b, size_t e){
+        D2IterC(ir, ic, 0, mRows, b, e)
+          if (m(ir, ic) < m(ret[ic], ic))
+            ret[ic] = ir;
+      });
+    } else {
+      default_pool().parallel_for(0, mRows, grain(mCols), [&](size_t b, size_t e){
+        D2IterC(ir, ic, b, e, 0, mCols)
+          if (m(ir, ic) < m(ir, ret[ir]))
+            ret[ir] = ic;
+      });
+    }
+    return ret;
+  }
+  vector<value_type> sum(MtxDim dim) const {
+    size_t n = dim == MCol ? mCols : mRows;
+    vector<value_type> ret(n, 0.);
+    const MtxView& m = *this;
+
+    if (dim == MCol){
+      default_pool().parallel_for(0, mCols, grain(mRows), [&](size_t b, size_t e){
+        D2IterC(ir, ic, 0, mRows, b, e) ret[ic] += m(ir, ic);
+      });
+    } else {
+      default_pool().parallel_for(0, mRows, grain(mCols), [&](size_t b, size_t e){
+        D2IterC(ir, ic, b, e, 0, mCols) ret[ir] += m(ir, ic);
+      });
+    }
+    return ret;
+  }
+  vector<value_type> mean(MtxDim dim) const {
+    vector<value_type> ret = sum(dim);
+    size_t n = dim == MCol ? mRows : mCols;
+    D1Iter(i, 0, ret.size()) ret[i] /= (double)n;
+    return ret;
+  }
+};
+
+template <typename T, typename A>
+MtxView<T> Mtx<T, A>::view(){
+  return MtxView<T>(*this);
 }
+template <typename T, typename A>
+MtxView<const T> Mtx<T, A>::view() const {
+  return MtxView<const T>(*this);
+}
+template <typename T, typename A>
+MtxView<T> Mtx<T, A>::view(size_t r0, size_t c0, size_t nr, size_t nc){
+  return view().view(r0, c0, nr, nc);
+}
+template <typename T, typename A>
+MtxView<const T> Mtx<T, A>::view(size_t r0, size_t c0, size_t nr, size_t nc) const {
+  return view().view(r0, c0, nr, nc);
+}
+
+/* lazy element-wise expressions
+ *   a + b - c / d builds a tree of MtxBinExpr nodes that only hold references to the operand
+ *   matrices; the tree is evaluated in one fused pass when it is assigned to (or used to
+ *   construct) a Mtx, without allocating intermediate matrices.
+ *   NOTE: an expression refers to its operands, do not keep one (e.g. in an auto variable)
+ *         beyond the lifetime of the matrices it was built from
+ */
 template <typename T>
-Mtx<T> operator-(const Mtx<T>& a, const Mtx<T>& b){
-  Mtx<T> ret(a);
-  ret.sub(b);
-  return ret;
+class MtxLeaf : public MtxExprBase {
+  const T* mData;
+  size_t mRows;
+  size_t mCols;
+  bool mRotated;
+public:
+  using value_type = T;
+
+  template <typename A>
+  MtxLeaf(const Mtx<T, A>& m): mData(m.dataptr()), mRows(m.rows()), mCols(m.cols()), mRotated(m.is_rotated()) {
+    assert(mData != nullptr);
+  }
+
+  size_t rows() const { return mRows; }
+  size_t cols() const { return mCols; }
+  bool rotated() const { return mRotated; }
+  bool uniform(bool rotated) const { return mRotated == rotated; }
+  T at(size_t i) const { return mData[i]; }
+  T operator()(size_t r, size_t c) const {
+    return mRotated ? mData[c + r * mCols] : mData[r + c * mRows];
+  }
+  bool aliases(const T* data, size_t rs, size_t cs) const {
+    return mtx_aliases(mData, mRows, mCols, mRotated ? mCols : 1, mRotated ? 1 : mRows, data, rs, cs);
+  }
+};
+
+template <typename Op, typename L, typename R>
+class MtxBinExpr : public MtxExprBase {
+  L mL;
+  R mR;
+public:
+  using value_type = typename L::value_type;
+
+  MtxBinExpr(const L& l, const R& r): mL(l), mR(r) {
+    assert(l.rows() == r.rows() && l.cols() == r.cols());
+  }
+
+  size_t rows() const { return mL.rows(); }
+  size_t cols() const { return mL.cols(); }
+  bool rotated() const { return mL.rotated(); }
+  bool uniform(bool rotated) const { return mL.uniform(rotated) && mR.uniform(rotated); }
+  value_type at(size_t i) const { return Op::apply(mL.at(i), mR.at(i)); }
+  value_type operator()(size_t r, size_t c) const { return Op::apply(mL(r, c), mR(r, c)); }
+  bool aliases(const value_type* data, size_t rs, size_t cs) const {
+    return mL.aliases(data, rs, cs) || mR.aliases(data, rs, cs);
+  }
+
+  /* the rest of the Mtx interface, so (a + b).sum(MCol) and the like keep working: these
+   * evaluate the expression into a new Mtx first, a mutating member returns that Mtx */
+  Mtx<value_type> eval() const { return Mtx<value_type>(*this); }
+  vector<size_t> maxi(MtxDim dim) const { return eval().maxi(dim); }
+  vector<size_t> mini(MtxDim dim) const { return eval().mini(dim); }
+  vector<value_type> sum(MtxDim dim) const { return eval().sum(dim); }
+  vector<value_type> mean(MtxDim dim) const { return eval().mean(dim); }
+  Mtx<value_type> dot(const MtxView<const value_type>& o) const { return eval().dot(o); }
+  Mtx<value_type> transpose() const { return eval().transpose(); }
+  Mtx<value_type> t() const { return move(eval().t()); }
+  Mtx<value_type> add(value_type v) const { return move(eval().add(v)); }
+  Mtx<value_type> sub(value_type v) const { return move(eval().sub(v)); }
+  Mtx<value_type> mul(value_type v) const { return move(eval().mul(v)); }
+  Mtx<value_type> div(value_type v) const { return move(eval().div(v)); }
+  Mtx<value_type> pow(value_type v) const { return move(eval().pow(v)); }
+  template <typename F>
+  Mtx<value_type> foreach(F&& transform) const { return move(eval().foreach(transform)); }
+};
+
+struct MtxAddOp { template <typename T> static T apply(T a, T b){ return a + b; } };
+struct MtxSubOp { template <typename T> static T apply(T a, T b){ return a - b; } };
+struct MtxMulOp { template <typename T> static T apply(T a, T b){ return a * b; } };
+struct MtxDivOp { template <typename T> static T apply(T a, T b){ return a / b; } };
+
+template <typename X> struct MtxTerm;
+template <typename T, typename A> struct MtxTerm<Mtx<T, A>> {
+  using type = MtxLeaf<T>;
+  using value_type = T;
+};
+template <typename T> struct MtxTerm<MtxView<T>> {
+  using type = MtxView<T>;
+  using value_type = typename remove_const<T>::type;
+};
+template <typename Op, typename L, typename R> struct MtxTerm<MtxBinExpr<Op, L, R>> {
+  using type = MtxBinExpr<Op, L, R>;
+  using value_type = typename L::value_type;
+};
+template <typename A, typename B, typename Op>
+using MtxBinExprOf = MtxBinExpr<Op, typename MtxTerm<A>::type, typename MtxTerm<B>::type>;
+
+//materialize a term for operations that cannot be fused, such as matrix multiplication
+template <typename T, typename A>
+const Mtx<T, A>& eval(const Mtx<T, A>& m){
+  return m;
 }
+//a view does not need to be materialized, gemm reads it through its strides
 template <typename T>
-Mtx<T> operator*(const Mtx<T>& a, const Mtx<T>& b){
+const MtxView<T>& eval(const MtxView<T>& v){
+  return v;
+}
+template <typename E, typename = enable_if_expr<E>>
+Mtx<typename E::value_type> eval(const E& e){
+  return Mtx<typename E::value_type>(e);
+}
+
+/* operators that generate lazy expressions */
+template <typename A, typename B>
+MtxBinExprOf<A, B, MtxAddOp> operator+(const A& a, const B& b){
+  return MtxBinExprOf<A, B, MtxAddOp>(a, b);
+}
+template <typename A, typename B>
+MtxBinExprOf<A, B, MtxSubOp> operator-(const A& a, const B& b){
+  return MtxBinExprOf<A, B, MtxSubOp>(a, b);
+}
+template <typename A, typename B>
+MtxBinExprOf<A, B, MtxDivOp> operator/(const A& a, const B& b){
+  return MtxBinExprOf<A, B, MtxDivOp>(a, b);
+}
+//element-wise product, operator* is the matrix product
+template <typename A, typename B>
+MtxBinExprOf<A, B, MtxMulOp> hadamard(const A& a, const B& b){
+  return MtxBinExprOf<A, B, MtxMulOp>(a, b);
+}
+
+/* operators that generate new matrix instances */
+template <typename T, typename A>
+Mtx<T, A> operator*(const Mtx<T, A>& a, const Mtx<T, A>& b){
   return a.dot(b);
 }
-template <typename T>
-Mtx<T> operator/(const Mtx<T>& a, const Mtx<T>& b){
-  Mtx<T> ret(a);
-  ret.div(b);
-  return ret;
+template <typename A, typename B,
+          typename V = typename MtxTerm<A>::value_type,
+          typename = typename enable_if<is_same<V, typename MtxTerm<B>::value_type>::value &&
+                                        not (is_same<A, B>::value && not is_base_of<MtxExprBase, A>::value)>::type>
+Mtx<V> operator*(const A& a, const B& b){
+  return MtxView<const V>(eval(a)).dot(eval(b));
 }
 
 /* print matrix */
-template <typename T>
-ostream& operator<<(ostream& out, const Mtx<T>& m){
+template <typename T, typename A>
+ostream& operator<<(ostream& out, const Mtx<T, A>& m){
   for (size_t ir = 0; ir < m.rows(); ++ir){
     for (size_t ic = 0; ic < m.cols(); ++ic)
       out << m(ir, ic) << " ";
@@ -605,14 +1011,18 @@ ostream& operator<<(ostream& out, const Mtx<T>& m){
   }
   return out;
 }
-template <typename T>
-ostream& operator<<(ostream& out, const RowRef<T>& rr){
+template <typename E, typename = enable_if_expr<E>>
+ostream& operator<<(ostream& out, const E& e){
+  return out << eval(e);
+}
+template <typename T, typename A>
+ostream& operator<<(ostream& out, const RowRef<T, A>& rr){
   D1Iter(i, 0, rr.size()) out << rr[i] << " ";
   out << endl;
   return out;
 }
-template <typename T>
-ostream& operator<<(ostream& out, const ColRef<T>& cr){
+template <typename T, typename A>
+ostream& operator<<(ostream& out, const ColRef<T, A>& cr){
   D1Iter(i, 0, cr.size()) out << cr[i] << " ";
   out << endl;
   return out;
@@ -0,0 +1,150 @@
+#ifndef NN_MATRIX_ALLOC
+#define NN_MATRIX_ALLOC
+
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <vector>
+
+/* Matrix Buffer Allocation Policies
+ *
+ * Mtx<T, A> gets and returns its buffers through the static functions of its policy A:
+ *   static T* allocate(size_t n);            //uninitialized buffer of n elements, throws bad_alloc
+ *   static void deallocate(T* p, size_t n);  //n is the size the buffer was allocated with
+ *
+ *   AlignedAlloc: the default, every buffer starts on a MTX_ALIGN boundary
+ *   PooledAlloc:  aligned buffers recycled through a BufferPool, so temporaries of a shape
+ *                 that was used before do not go back to the system allocator
+ */
+
+constexpr size_t MTX_ALIGN = 64; //cache line, and the widest vector register
+
+template <typename T>
+struct AlignedAlloc {
+  static T* allocate(size_t n){
+    return (T*)::operator new(n * sizeof(T), std::align_val_t(MTX_ALIGN));
+  }
+  static void deallocate(T* p, size_t){
+    ::operator delete((void*)p, std::align_val_t(MTX_ALIGN));
+  }
+};
+
+/* size class buffer pool
+ *   requests are rounded up to a power of two number of bytes (at least MTX_ALIGN), released
+ *   buffers are kept on a free list of their class and handed out again by the next request
+ *   of the same class. requests larger than MAX_CLASS bytes bypass the pool. up to
+ *   max_cached() bytes are kept, beyond that released buffers are returned upstream.
+ *   a pool is thread safe. fetch and drop are the upstream allocator, override them to carve
+ *   buffers from somewhere else, see ArenaBufferPool
+ */
+class BufferPool {
+  enum : size_t {
+    MIN_SHIFT = 6,  //64 bytes
+    MAX_SHIFT = 34, //16 GB
+    NCLASS    = MAX_SHIFT - MIN_SHIFT + 1,
+  };
+
+  std::mutex mLock;
+  std::vector<void*> mFree[NCLASS];
+  size_t mCached;
+  size_t mMaxCached;
+  size_t mHits;
+  size_t mMisses;
+
+  static size_t size_class(size_t bytes){
+    size_t k = 0;
+    while (((size_t)1 << (MIN_SHIFT + k)) < bytes) ++k;
+    return k;
+  }
+  static size_t class_bytes(size_t k){
+    return (size_t)1 << (MIN_SHIFT + k);
+  }
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+protected:
+  virtual void* fetch(size_t bytes){
+    return ::operator new(bytes, std::align_val_t(MTX_ALIGN));
+  }
+  virtual void drop(void* p, size_t){
+    ::operator delete(p, std::align_val_t(MTX_ALIGN));
+  }
+public:
+  static constexpr size_t MAX_CLASS = (size_t)1 << MAX_SHIFT;
+
+  explicit BufferPool(size_t max_cached = (size_t)1 << 30):
+    mCached(0), mMaxCached(max_cached), mHits(0), mMisses(0) {}
+  //derived pools must call trim() in their own destructor, fetch and drop are no longer
+  //virtual dispatched here
+  virtual ~BufferPool(){
+    trim();
+  }
+
+  void* acquire(size_t bytes){
+    if (bytes > MAX_CLASS) return fetch(bytes);
+    size_t k = size_class(bytes);
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      if (not mFree[k].empty()){
+        void* p = mFree[k].back();
+        mFree[k].pop_back();
+        mCached -= class_bytes(k);
+        ++mHits;
+        return p;
+      }
+      ++mMisses;
+    }
+    return fetch(class_bytes(k));
+  }
+  void release(void* p, size_t bytes){
+    if (p == nullptr) return;
+    if (bytes > MAX_CLASS){
+      drop(p, bytes);
+      return;
+    }
+    size_t k = size_class(bytes);
+    {
+      std::lock_guard<std::mutex> lock(mLock);
+      if (mCached + class_bytes(k) <= mMaxCached){
+        mFree[k].push_back(p);
+        mCached += class_bytes(k);
+        return;
+      }
+    }
+    drop(p, class_bytes(k));
+  }
+  //return every cached buffer upstream
+  void trim(){
+    std::lock_guard<std::mutex> lock(mLock);
+    for (size_t k = 0; k < NCLASS; ++k){
+      for (void* p : mFree[k]) drop(p, class_bytes(k));
+      mFree[k].clear();
+    }
+    mCached = 0;
+  }
+
+  size_t cached() const { return mCached; }
+  size_t max_cached() const { return mMaxCached; }
+  void set_max_cached(size_t bytes){ mMaxCached = bytes; }
+  size_t hits() const { return mHits; }
+  size_t misses() const { return mMisses; }
+};
+
+inline BufferPool& default_buffer_pool(){
+  static BufferPool pool;
+  return pool;
+}
+
+/* Pool is the function returning the pool to use, e.g. a function returning a static
+ * ArenaBufferPool to carve all buffers of a training loop out of one Arena */
+template <typename T, BufferPool& (*Pool)() = default_buffer_pool>
+struct PooledAlloc {
+  static T* allocate(size_t n){
+    return (T*)Pool().acquire(n * sizeof(T));
+  }
+  static void deallocate(T* p, size_t n){
+    Pool().release((void*)p, n * sizeof(T));
+  }
+};
+
+#endif//NN_MATRIX_ALLOC
@@ -0,0 +1,38 @@
+#ifndef NN_MATRIX_ARENA_POOL
+#define NN_MATRIX_ARENA_POOL
+
+#include "mtx_alloc.h"
+#include "../arena_mem/arena.h"
+
+/* BufferPool carving its buffers out of an Arena
+ *   the arena only hands out 4 or 8 byte aligned memory, every buffer is over-allocated and
+ *   aligned up to MTX_ALIGN. buffers are never given back to the arena, they stay in the pool
+ *   until the arena itself is destroyed, so the arena must outlive the pool and every matrix
+ *   allocated from it.
+ *   NOTE: Arena is not thread safe, this pool serializes its own calls into it but the arena
+ *         must not be used by anything else concurrently
+ *
+ *   Arena arena;
+ *   BufferPool& arena_pool(){ static ArenaBufferPool pool(arena); return pool; }
+ *   Mtx<float, PooledAlloc<float, arena_pool>> m(128, 128);
+ */
+class ArenaBufferPool : public BufferPool {
+  Arena& mArena;
+  std::mutex mArenaLock;
+protected:
+  void* fetch(size_t bytes) override {
+    std::lock_guard<std::mutex> lock(mArenaLock);
+    size_t addr = (size_t)mArena.alloc(bytes + MTX_ALIGN - 1);
+    return (void*)((addr + MTX_ALIGN - 1) & ~(MTX_ALIGN - 1));
+  }
+  void drop(void*, size_t) override { /* do nothing, the arena owns the memory */ }
+public:
+  //arena buffers cannot be returned, so by default every released buffer is cached
+  explicit ArenaBufferPool(Arena& arena, size_t max_cached = ~(size_t)0):
+    BufferPool(max_cached), mArena(arena) {}
+  ~ArenaBufferPool(){
+    trim();
+  }
+};
+
+#endif//NN_MATRIX_ARENA_POOL
@@ -0,0 +1,199 @@
+#ifndef NN_MATRIX_FILE
+#define NN_MATRIX_FILE
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "matrix.h"
+
+/* Binary Matrix File
+ *
+ * a 64 byte header followed by the raw matrix buffer exactly as Mtx keeps it in memory:
+ * column major, or row major when the rotated flag is set. the buffer starts at a 64 byte
+ * aligned offset so the file can be mapped and used in place without any parsing or copying.
+ * values are stored in native byte order.
+ *
+ *   save_binary:  write a matrix
+ *   MtxWriter:    write a matrix a chunk at a time, it never has to be in memory as a whole
+ *   MappedMtx:    map a file read only and expose it as a const Mtx that borrows the mapping
+ *   load_binary:  read a file into an owned Mtx
+ */
+
+constexpr char     MTX_FILE_MAGIC[4] = {'M', 'T', 'X', 'B'};
+constexpr uint32_t MTX_FILE_VERSION = 1;
+constexpr uint64_t MTX_FILE_ALIGN = 64;
+constexpr uint32_t MTX_FILE_ROTATED = 0x1;
+
+template <typename T> struct MtxDType;
+template <> struct MtxDType<float>   { static constexpr uint32_t value = 1; };
+template <> struct MtxDType<double>  { static constexpr uint32_t value = 2; };
+template <> struct MtxDType<int32_t> { static constexpr uint32_t value = 3; };
+template <> struct MtxDType<int64_t> { static constexpr uint32_t value = 4; };
+
+struct MtxFileHeader {
+  char     magic[4];
+  uint32_t version;
+  uint32_t dtype;
+  uint32_t flags;
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t offset;  //byte offset of the first element
+  uint8_t  pad[24];
+};
+static_assert(sizeof(MtxFileHeader) == MTX_FILE_ALIGN, "matrix file header must be 64 bytes");
+
+template <typename T>
+MtxFileHeader make_mtx_header(size_t rows, size_t cols, bool rotated){
+  MtxFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MTX_FILE_MAGIC, sizeof(h.magic));
+  h.version = MTX_FILE_VERSION;
+  h.dtype = MtxDType<T>::value;
+  h.flags = rotated ? MTX_FILE_ROTATED : 0;
+  h.rows = rows;
+  h.cols = cols;
+  h.offset = MTX_FILE_ALIGN;
+  return h;
+}
+
+//validate a header against the element type and the size of the file it came from
+template <typename T>
+bool check_mtx_header(const MtxFileHeader& h, size_t file_size, const string& filename){
+  if (memcmp(h.magic, MTX_FILE_MAGIC, sizeof(h.magic)) != 0 || h.version != MTX_FILE_VERSION){
+    cout << "file " << filename << " is not a binary matrix file" << endl;
+    return false;
+  }
+  if (h.dtype != MtxDType<T>::value){
+    cout << "file " << filename << " has element type " << h.dtype << ", expected " << MtxDType<T>::value << endl;
+    return false;
+  }
+  if (h.offset % MTX_FILE_ALIGN != 0 || h.offset < sizeof(MtxFileHeader) ||
+      file_size < h.offset || (h.cols != 0 && h.rows > SIZE_MAX / h.cols) || (file_size - h.offset) / sizeof(T) < h.rows * h.cols){
+    cout << "file " << filename << " is truncated or corrupted" << endl;
+    return false;
+  }
+  return true;
+}
+
+/* streaming writer, elements are given in buffer order: by column, or by row if rotated */
+template <typename T>
+class MtxWriter {
+  ofstream mOut;
+  string   mFilename;
+  size_t   mExpected;
+  size_t   mWritten;
+public:
+  MtxWriter(const string& filename, size_t rows, size_t cols, bool rotated = false):
+    mFilename(filename), mExpected(rows * cols), mWritten(0) {
+    mOut.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+    if (not mOut.is_open()){
+      cout << "could not open file " << filename << " to save" << endl;
+      return;
+    }
+    MtxFileHeader h = make_mtx_header<T>(rows, cols, rotated);
+    mOut.write((const char*)&h, sizeof(h));
+  }
+  ~MtxWriter(){
+    close();
+  }
+
+  bool is_open() const { return mOut.is_open(); }
+
+  void write(const T* data, size_t n){
+    if (not mOut.is_open()) return;
+    assert(mWritten + n <= mExpected);
+    mOut.write((const char*)data, sizeof(T) * n);
+    mWritten += n;
+  }
+
+  //returns false if the file could not be written or is missing elements
+  bool close(){
+    if (not mOut.is_open()) return false;
+    mOut.close();
+    if (mOut.fail()){
+      cout << "failed writing file " << mFilename << endl;
+      return false;
+    }
+    if (mWritten != mExpected){
+      cout << "file " << mFilename << " has " << mWritten << " of " << mExpected << " elements" << endl;
+      return false;
+    }
+    return true;
+  }
+};
+
+//the buffer is written in its current layout, a rotated matrix stays rotated
+template <typename T, typename A>
+bool save_binary(const Mtx<T, A>& m, const string& filename){
+  MtxWriter<T> out(filename, m.rows(), m.cols(), m.is_rotated());
+  if (not out.is_open()) return false;
+  out.write(m.dataptr(), m.rows() * m.cols());
+  return out.close();
+}
+
+/* read only memory mapping of a binary matrix file; the Mtx it exposes borrows the mapping
+ * and must not outlive this object. flip() and unflip() on it transpose into a new owned
+ * buffer, the file is never written */
+template <typename T>
+class MappedMtx {
+  void*  mMap;
+  size_t mSize;
+  Mtx<T> mMtx;
+public:
+  explicit MappedMtx(const string& filename): mMap(nullptr), mSize(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+      cout << "could not open input file " << filename << " to load" << endl;
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MtxFileHeader)){
+      cout << "file " << filename << " is not a binary matrix file" << endl;
+      ::close(fd);
+      return;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED){
+      cout << "could not map file " << filename << endl;
+      return;
+    }
+
+    MtxFileHeader h;
+    memcpy(&h, map, sizeof(h));
+    if (not check_mtx_header<T>(h, st.st_size, filename)){
+      munmap(map, st.st_size);
+      return;
+    }
+    mMap = map;
+    mSize = st.st_size;
+    mMtx = Mtx<T>((const T*)((const char*)map + h.offset), h.rows, h.cols, h.flags & MTX_FILE_ROTATED);
+  }
+  MappedMtx(const MappedMtx&) = delete;
+  MappedMtx& operator=(const MappedMtx&) = delete;
+  ~MappedMtx(){
+    //mMtx only frees a buffer it owns, so it may be destroyed after the unmap
+    if (mMap) munmap(mMap, mSize);
+  }
+
+  bool is_open() const { return mMap != nullptr; }
+  const Mtx<T>& mtx() const { return mMtx; }
+};
+
+//owned copy of a binary matrix file, an empty matrix if the file could not be read
+template <typename T>
+Mtx<T> load_binary(const string& filename){
+  MappedMtx<T> mapped(filename);
+  if (not mapped.is_open()) return Mtx<T>();
+  return Mtx<T>(mapped.mtx());
+}
+
+#endif//NN_MATRIX_FILE
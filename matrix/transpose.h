@@ -0,0 +1,106 @@
+#ifndef NN_MATRIX_TRANSPOSE
+#define NN_MATRIX_TRANSPOSE
+
+#include <cstddef>
+#include <algorithm>
+
+#include "../thread_pool/thread_pool.h"
+
+/* Matrix Transpose of a column locality buffer
+ *
+ * all functions take a r x c matrix stored by column (element (i, j) at i + j * r) and produce
+ * its c x r transpose, also stored by column; equivalently they turn a column buffer into a
+ * row buffer of the same matrix.
+ *
+ *   transpose_oop:     out-of-place, cache-oblivious recursion down to tiles that fit in L1
+ *   transpose_inplace: no extra memory; square matrices swap tiles across the diagonal,
+ *                      rectangular matrices follow the permutation cycles and use a cycle
+ *                      leader test instead of a visited bitmap
+ */
+
+constexpr size_t TRANSPOSE_TILE = 32;
+
+template <typename T>
+void transpose_tile(const T* src, T* dst, size_t r, size_t c, size_t rb, size_t re, size_t cb, size_t ce){
+  for (size_t i = rb; i < re; ++i)
+    for (size_t j = cb; j < ce; ++j)
+      dst[j + i * c] = src[i + j * r];
+}
+
+//split the longer side until the block is a tile, this keeps both the reads and the writes
+//inside a cache sized region at every level of the memory hierarchy
+template <typename T>
+void transpose_rec(const T* src, T* dst, size_t r, size_t c, size_t rb, size_t re, size_t cb, size_t ce){
+  size_t nr = re - rb, nc = ce - cb;
+  if (nr <= TRANSPOSE_TILE && nc <= TRANSPOSE_TILE){
+    transpose_tile(src, dst, r, c, rb, re, cb, ce);
+  } else if (nr >= nc){
+    size_t rm = rb + nr / 2;
+    transpose_rec(src, dst, r, c, rb, rm, cb, ce);
+    transpose_rec(src, dst, r, c, rm, re, cb, ce);
+  } else {
+    size_t cm = cb + nc / 2;
+    transpose_rec(src, dst, r, c, rb, re, cb, cm);
+    transpose_rec(src, dst, r, c, rb, re, cm, ce);
+  }
+}
+
+template <typename T>
+void transpose_oop(const T* src, T* dst, size_t r, size_t c){
+  //column stripes are independent, hand them out to the shared pool
+  size_t stripes = (c + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+  size_t grain = std::max((size_t)1, (size_t)(64 * 1024) / std::max(r * TRANSPOSE_TILE, (size_t)1));
+  default_pool().parallel_for(0, stripes, grain, [=](size_t b, size_t e){
+    transpose_rec(src, dst, r, c, 0, r, b * TRANSPOSE_TILE, std::min(c, e * TRANSPOSE_TILE));
+  });
+}
+
+//square n x n: transpose tiles on the diagonal, swap the ones mirrored across it
+template <typename T>
+void transpose_square_inplace(T* data, size_t n){
+  //both tiles of a pair are live at once, use half the tile so they share L1 and the TLB
+  constexpr size_t TILE = TRANSPOSE_TILE / 2;
+  for (size_t jb = 0; jb < n; jb += TILE){
+    size_t je = std::min(n, jb + TILE);
+    for (size_t ib = jb; ib < n; ib += TILE){
+      size_t ie = std::min(n, ib + TILE);
+      for (size_t j = jb; j < je; ++j)
+        for (size_t i = std::max(ib, j + 1); i < ie; ++i)
+          std::swap(data[i + j * n], data[j + i * n]);
+    }
+  }
+}
+
+/* element at position p of the r x c column buffer moves to p * c mod (n - 1), the last
+ * element stays; a cycle is moved once, from its smallest position (the leader) */
+template <typename T>
+void transpose_cycles_inplace(T* data, size_t r, size_t c){
+  size_t n = r * c;
+  size_t m = n - 1;
+  for (size_t s = 1; s < m; ++s){
+    size_t q = s * c % m;
+    while (q > s) q = q * c % m;
+    if (q < s) continue;   //s is not the smallest position of its cycle
+    if (s * c % m == s) continue;
+
+    //walk the cycle backwards: position p receives the element from p * r mod (n - 1)
+    T tmp = data[s];
+    size_t p = s;
+    for (;;){
+      size_t from = p * r % m;
+      if (from == s) break;
+      data[p] = data[from];
+      p = from;
+    }
+    data[p] = tmp;
+  }
+}
+
+template <typename T>
+void transpose_inplace(T* data, size_t r, size_t c){
+  if (r <= 1 || c <= 1) return;
+  if (r == c) transpose_square_inplace(data, r);
+  else        transpose_cycles_inplace(data, r, c);
+}
+
+#endif//NN_MATRIX_TRANSPOSE
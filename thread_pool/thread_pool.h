@@ -0,0 +1,152 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+/* Persistent Thread Pool
+ *   workers are created once and sleep on a condition variable between jobs, so a parallel
+ *   loop costs a queue push and a wake up instead of a thread creation per call.
+ *
+ *   the calling thread always takes part in parallel_for: a pool with n workers runs a loop
+ *   on n + 1 threads, and a pool with 0 workers runs the loop inline on the caller. while
+ *   waiting for its chunks to finish the caller keeps draining the queue, so a parallel_for
+ *   issued from inside a task cannot dead lock the pool.
+ *
+ *   the range is split into equal contiguous chunks that only depend on the range size and
+ *   the pool size; callers that reduce per output element (rather than combining partial
+ *   results across chunks) get the same answer for any number of threads.
+ *
+ *   if fn throws, the other chunks still run to completion and the first exception caught
+ *   is rethrown on the calling thread once they have.
+ */
+class ThreadPool {
+  std::vector<std::thread>          mWorkers;
+  std::deque<std::function<void()>> mTasks;
+  std::mutex                        mMutex;
+  std::condition_variable           mCond;
+  bool                              mStop;
+
+  void work(){
+    for (;;){
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCond.wait(lock, [this]{ return mStop || not mTasks.empty(); });
+        if (mTasks.empty()) return;
+        task = std::move(mTasks.front());
+        mTasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  bool run_one(){
+    std::function<void()> task;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (mTasks.empty()) return false;
+      task = std::move(mTasks.front());
+      mTasks.pop_front();
+    }
+    task();
+    return true;
+  }
+
+  void start(size_t nworkers){
+    mStop = false;
+    for (size_t i = 0; i < nworkers; ++i)
+      mWorkers.emplace_back([this]{ work(); });
+  }
+
+  void stop(){
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCond.notify_all();
+    for (std::thread& t : mWorkers) t.join();
+    mWorkers.clear();
+  }
+public:
+  explicit ThreadPool(size_t nworkers = 0): mStop(false) {
+    start(nworkers);
+  }
+  ~ThreadPool(){
+    stop();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t workers() const { return mWorkers.size(); }
+  size_t concurrency() const { return mWorkers.size() + 1; }
+
+  //NOTE: must not be called while a parallel_for is running on this pool
+  void resize(size_t nworkers){
+    if (nworkers == mWorkers.size()) return;
+    stop();
+    start(nworkers);
+  }
+
+  /* call fn(b, e) over disjoint sub ranges covering [begin, end), at least grain items each */
+  template <typename F>
+  void parallel_for(size_t begin, size_t end, size_t grain, F&& fn){
+    if (begin >= end) return;
+    size_t n = end - begin;
+    grain = std::max(grain, (size_t)1);
+    size_t chunks = std::min(concurrency(), (n + grain - 1) / grain);
+    if (chunks <= 1){
+      fn(begin, end);
+      return;
+    }
+
+    size_t step = n / chunks, rem = n % chunks;
+    auto chunk_begin = [=](size_t c){ return begin + c * step + std::min(c, rem); };
+
+    std::atomic<size_t> pending(chunks - 1);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run = [&fn, &error, &error_mutex](size_t b, size_t e){
+      try {
+        fn(b, e);
+      } catch (...){
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (not error) error = std::current_exception();
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (size_t c = 1; c < chunks; ++c){
+        size_t b = chunk_begin(c), e = chunk_begin(c + 1);
+        mTasks.emplace_back([&run, &pending, b, e]{
+          run(b, e);
+          pending.fetch_sub(1, std::memory_order_release);
+        });
+      }
+    }
+    mCond.notify_all();
+
+    run(chunk_begin(0), chunk_begin(1));
+    while (pending.load(std::memory_order_acquire) > 0)
+      if (not run_one())
+        std::this_thread::yield();
+    if (error) std::rethrow_exception(error);
+  }
+};
+
+/* process wide pool shared by the numeric containers, starts with no workers */
+inline ThreadPool& default_pool(){
+  static ThreadPool pool;
+  return pool;
+}
+
+#endif//THREAD_POOL_H